@@ -548,6 +548,9 @@ private:
         std::vector<InputMessage> samples;
     };
     std::vector<Batch> mBatches;
+    // The sample storage of batches that were consumed, kept so that it can be reused by the next
+    // batches. A touch stream starts a new batch every frame, and this keeps that from allocating.
+    std::vector<std::vector<InputMessage>> mRecycledBatchSamples;
 
     // Touch state per device and source, only for sources of class pointer.
     struct History {
@@ -658,6 +661,9 @@ private:
     status_t consumeSamples(InputEventFactoryInterface* factory,
             Batch& batch, size_t count, uint32_t* outSeq, InputEvent** outEvent);
 
+    void startBatch(const InputMessage& msg);
+    void eraseBatch(size_t index);
+
     void updateTouchState(InputMessage& msg);
     void resampleTouchState(nsecs_t frameTime, MotionEvent* event,
             const InputMessage *next);
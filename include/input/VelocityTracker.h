@@ -21,7 +21,9 @@
 #include <input/RingBuffer.h>
 #include <utils/BitSet.h>
 #include <utils/Timers.h>
+#include <array>
 #include <map>
+#include <optional>
 #include <set>
 
 namespace android {
@@ -123,11 +125,13 @@ private:
     // When default strategy is specified, then each axis will use a potentially different strategy
     // based on a hardcoded mapping.
     const Strategy mOverrideStrategy;
-    // Maps axes to their respective VelocityTrackerStrategy instances.
-    // Note that, only axes that have had MotionEvents (and not all supported axes) will be here.
-    std::map<int32_t /*axis*/, std::unique_ptr<VelocityTrackerStrategy>> mConfiguredStrategies;
+    // The VelocityTrackerStrategy instance of each axis, indexed by axis.
+    // Note that, only axes that have had MotionEvents (and not all supported axes) will have one.
+    std::array<std::unique_ptr<VelocityTrackerStrategy>, AMOTION_EVENT_MAXIMUM_VALID_AXIS_VALUE + 1>
+            mConfiguredStrategies;
 
     void configureStrategy(int32_t axis);
+    void clearStrategies();
 
     // Generates a VelocityTrackerStrategy instance for the given Strategy type.
     // The `deltaValues` parameter indicates whether or not the created strategy should treat motion
@@ -175,6 +179,17 @@ protected:
     // protected const field.
     static constexpr uint32_t HISTORY_SIZE = 20;
 
+    /**
+     * Called after a movement has been added to the movements of a pointer (it is then the newest
+     * of them), and right before a movement is removed from them. Strategies can use these to keep
+     * running totals over the movements, instead of going over all of them on every query.
+     */
+    virtual void onMovementAdded(int32_t /*pointerId*/) {}
+    virtual void onMovementRemoved(int32_t /*pointerId*/, const Movement& /*movement*/) {}
+
+    // Returns the movements of the given pointer, or nullptr if none were ever added.
+    const RingBuffer<Movement>* getMovements(int32_t pointerId) const;
+
     /**
      * Duration, in nanoseconds, since the latest movement where a movement may be considered for
      * velocity calculation.
@@ -185,7 +200,12 @@ protected:
      * addition of a new movement.
      */
     const bool mMaintainHorizonDuringAdd;
-    std::map<int32_t /*pointerId*/, RingBuffer<Movement>> mMovements;
+    /**
+     * The movements of each pointer, indexed by pointer id. The ring buffer of a pointer is created
+     * when its first movement is added, and is kept when the pointer is cleared so that it can be
+     * reused.
+     */
+    std::array<std::optional<RingBuffer<Movement>>, MAX_POINTER_ID + 1> mMovements;
 };
 
 /*
@@ -220,6 +240,22 @@ private:
     // changes in direction.
     static const nsecs_t HORIZON = 100 * 1000000; // 100 ms
 
+    /**
+     * Running sums over the movements of a pointer, as needed by the unweighted second degree fit.
+     * The time of each movement is taken relative to `originTime` rather than to the newest
+     * movement, so that adding a movement does not change the terms of the ones already summed.
+     */
+    struct RunningSums {
+        nsecs_t originTime = 0;
+        double sx = 0, sx2 = 0, sx3 = 0, sx4 = 0, sy = 0, sxy = 0, sx2y = 0;
+
+        // Adds (sign = 1) or removes (sign = -1) the terms of a movement.
+        void accumulate(const Movement& movement, double sign);
+    };
+
+    void onMovementAdded(int32_t pointerId) override;
+    void onMovementRemoved(int32_t pointerId, const Movement& movement) override;
+
     float chooseWeight(int32_t pointerId, uint32_t index) const;
     /**
      * An optimized least-squares solver for degree 2 and no weight (i.e. `Weighting.NONE`).
@@ -228,9 +264,19 @@ private:
      */
     std::optional<float> solveUnweightedLeastSquaresDeg2(
             const RingBuffer<Movement>& movements) const;
+    /**
+     * Same as above, but in constant time, from the running sums of the `count` movements of a
+     * pointer, the newest of which happened at `newestTime`.
+     */
+    static std::optional<float> solveUnweightedLeastSquaresDeg2(const RunningSums& sums,
+                                                                size_t count, nsecs_t newestTime);
 
     const uint32_t mDegree;
     const Weighting mWeighting;
+    // Whether the running sums are maintained, which is the case for the unweighted second degree
+    // fit (the default strategy for planar axes).
+    const bool mUseRunningSums;
+    std::array<RunningSums, MAX_POINTER_ID + 1> mRunningSums;
 };
 
 /*
@@ -930,14 +930,14 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                             sendFinishedSignal(msg.header.seq, false);
                         }
                         batch.samples.erase(batch.samples.begin(), batch.samples.begin() + count);
-                        mBatches.erase(mBatches.begin() + batchIndex);
+                        eraseBatch(batchIndex);
                     } else {
                         // We cannot append to the batch in progress, so we need to consume
                         // the previous batch right now and defer the new message until later.
                         mMsgDeferred = true;
                         status_t result = consumeSamples(factory, batch, batch.samples.size(),
                                                          outSeq, outEvent);
-                        mBatches.erase(mBatches.begin() + batchIndex);
+                        eraseBatch(batchIndex);
                         if (result) {
                             return result;
                         }
@@ -952,9 +952,7 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
                 // Start a new batch if needed.
                 if (mMsg.body.motion.action == AMOTION_EVENT_ACTION_MOVE ||
                     mMsg.body.motion.action == AMOTION_EVENT_ACTION_HOVER_MOVE) {
-                    Batch batch;
-                    batch.samples.push_back(mMsg);
-                    mBatches.push_back(batch);
+                    startBatch(mMsg);
                     ALOGD_IF(DEBUG_TRANSPORT_CONSUMER,
                              "channel '%s' consumer ~ started batch event",
                              mChannel->getName().c_str());
@@ -1035,7 +1033,7 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         Batch& batch = mBatches[i];
         if (frameTime < 0) {
             result = consumeSamples(factory, batch, batch.samples.size(), outSeq, outEvent);
-            mBatches.erase(mBatches.begin() + i);
+            eraseBatch(i);
             return result;
         }
 
@@ -1051,7 +1049,7 @@ status_t InputConsumer::consumeBatch(InputEventFactoryInterface* factory,
         result = consumeSamples(factory, batch, split + 1, outSeq, outEvent);
         const InputMessage* next;
         if (batch.samples.empty()) {
-            mBatches.erase(mBatches.begin() + i);
+            eraseBatch(i);
             next = nullptr;
         } else {
             next = &batch.samples[0];
@@ -1092,6 +1090,22 @@ status_t InputConsumer::consumeSamples(InputEventFactoryInterface* factory,
     return OK;
 }
 
+void InputConsumer::startBatch(const InputMessage& msg) {
+    Batch& batch = mBatches.emplace_back();
+    if (!mRecycledBatchSamples.empty()) {
+        batch.samples = std::move(mRecycledBatchSamples.back());
+        mRecycledBatchSamples.pop_back();
+    }
+    batch.samples.push_back(msg);
+}
+
+void InputConsumer::eraseBatch(size_t index) {
+    std::vector<InputMessage>& samples = mBatches[index].samples;
+    samples.clear();
+    mRecycledBatchSamples.push_back(std::move(samples));
+    mBatches.erase(mBatches.begin() + index);
+}
+
 void InputConsumer::updateTouchState(InputMessage& msg) {
     if (!mResampleTouch || !isPointerEvent(msg.body.motion.source)) {
         return;
@@ -1282,10 +1296,15 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
     }
 
     // Resample touch coordinates.
+    // The coordinates of the pointers that are interpolated are gathered first, so that the
+    // interpolation is then done for all of them at once, in a loop that can be vectorized.
     History oldLastResample;
     oldLastResample.initializeFrom(touchState.lastResample);
     touchState.lastResample.eventTime = sampleTime;
     touchState.lastResample.idBits.clear();
+    size_t lerpCount = 0;
+    std::array<size_t, MAX_POINTERS> lerpIndices;
+    std::array<float, MAX_POINTERS> currentX, currentY, otherX, otherY;
     for (size_t i = 0; i < pointerCount; i++) {
         uint32_t id = event->getPointerId(i);
         touchState.lastResample.idToIndex[id] = i;
@@ -1310,15 +1329,12 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         resampledCoords.isResampled = true;
         if (other->idBits.hasBit(id) && shouldResampleTool(event->getToolType(i))) {
             const PointerCoords& otherCoords = other->getPointerById(id);
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X,
-                                         lerp(currentCoords.getX(), otherCoords.getX(), alpha));
-            resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y,
-                                         lerp(currentCoords.getY(), otherCoords.getY(), alpha));
-            ALOGD_IF(debugResampling(),
-                     "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
-                     "other (%0.3f, %0.3f), alpha %0.3f",
-                     id, resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
-                     currentCoords.getY(), otherCoords.getX(), otherCoords.getY(), alpha);
+            lerpIndices[lerpCount] = i;
+            currentX[lerpCount] = currentCoords.getX();
+            currentY[lerpCount] = currentCoords.getY();
+            otherX[lerpCount] = otherCoords.getX();
+            otherY[lerpCount] = otherCoords.getY();
+            lerpCount++;
         } else {
             ALOGD_IF(debugResampling(), "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f)", id,
                      resampledCoords.getX(), resampledCoords.getY(), currentCoords.getX(),
@@ -1326,6 +1342,22 @@ void InputConsumer::resampleTouchState(nsecs_t sampleTime, MotionEvent* event,
         }
     }
 
+    std::array<float, MAX_POINTERS> resampledX, resampledY;
+    for (size_t j = 0; j < lerpCount; j++) {
+        resampledX[j] = lerp(currentX[j], otherX[j], alpha);
+        resampledY[j] = lerp(currentY[j], otherY[j], alpha);
+    }
+    for (size_t j = 0; j < lerpCount; j++) {
+        PointerCoords& resampledCoords = touchState.lastResample.pointers[lerpIndices[j]];
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_X, resampledX[j]);
+        resampledCoords.setAxisValue(AMOTION_EVENT_AXIS_Y, resampledY[j]);
+        ALOGD_IF(debugResampling(),
+                 "[%d] - out (%0.3f, %0.3f), cur (%0.3f, %0.3f), "
+                 "other (%0.3f, %0.3f), alpha %0.3f",
+                 event->getPointerId(lerpIndices[j]), resampledX[j], resampledY[j], currentX[j],
+                 currentY[j], otherX[j], otherY[j], alpha);
+    }
+
     event->addSample(sampleTime, touchState.lastResample.pointers);
 }
 
@@ -215,10 +215,16 @@ std::unique_ptr<VelocityTrackerStrategy> VelocityTracker::createStrategy(
     return nullptr;
 }
 
+void VelocityTracker::clearStrategies() {
+    for (std::unique_ptr<VelocityTrackerStrategy>& strategy : mConfiguredStrategies) {
+        strategy.reset();
+    }
+}
+
 void VelocityTracker::clear() {
     mCurrentPointerIdBits.clear();
     mActivePointerId = std::nullopt;
-    mConfiguredStrategies.clear();
+    clearStrategies();
 }
 
 void VelocityTracker::clearPointer(int32_t pointerId) {
@@ -233,8 +239,10 @@ void VelocityTracker::clearPointer(int32_t pointerId) {
         }
     }
 
-    for (const auto& [_, strategy] : mConfiguredStrategies) {
-        strategy->clearPointer(pointerId);
+    for (const std::unique_ptr<VelocityTrackerStrategy>& strategy : mConfiguredStrategies) {
+        if (strategy) {
+            strategy->clearPointer(pointerId);
+        }
     }
 }
 
@@ -244,6 +252,9 @@ void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t
         LOG(FATAL) << "Invalid pointer ID " << pointerId << " for axis "
                    << MotionEvent::getLabel(axis);
     }
+    if (axis < 0 || axis > AMOTION_EVENT_MAXIMUM_VALID_AXIS_VALUE) {
+        LOG(FATAL) << "Invalid axis " << axis << " for pointer ID " << pointerId;
+    }
 
     if (mCurrentPointerIdBits.hasBit(pointerId) &&
         std::chrono::nanoseconds(eventTime - mLastEventTime) > ASSUME_POINTER_STOPPED_TIME) {
@@ -252,7 +263,7 @@ void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t
 
         // We have not received any movements for too long.  Assume that all pointers
         // have stopped.
-        mConfiguredStrategies.clear();
+        clearStrategies();
     }
     mLastEventTime = eventTime;
 
@@ -262,7 +273,7 @@ void VelocityTracker::addMovement(nsecs_t eventTime, int32_t pointerId, int32_t
         mActivePointerId = pointerId;
     }
 
-    if (mConfiguredStrategies.find(axis) == mConfiguredStrategies.end()) {
+    if (!mConfiguredStrategies[axis]) {
         configureStrategy(axis);
     }
     mConfiguredStrategies[axis]->addMovement(eventTime, pointerId, position);
@@ -315,7 +326,7 @@ void VelocityTracker::addMovement(const MotionEvent& event) {
                 // We have not received any movements for too long.  Assume that all pointers
                 // have stopped.
                 for (int32_t axis : PLANAR_AXES) {
-                    mConfiguredStrategies.erase(axis);
+                    mConfiguredStrategies[axis].reset();
                 }
             }
             // These actions because they do not convey any new information about
@@ -358,9 +369,12 @@ void VelocityTracker::addMovement(const MotionEvent& event) {
 }
 
 std::optional<float> VelocityTracker::getVelocity(int32_t axis, int32_t pointerId) const {
-    const auto& it = mConfiguredStrategies.find(axis);
-    if (it != mConfiguredStrategies.end()) {
-        return it->second->getVelocity(pointerId);
+    if (axis < 0 || axis > AMOTION_EVENT_MAXIMUM_VALID_AXIS_VALUE) {
+        return {};
+    }
+    const std::unique_ptr<VelocityTrackerStrategy>& strategy = mConfiguredStrategies[axis];
+    if (strategy) {
+        return strategy->getVelocity(pointerId);
     }
     return {};
 }
@@ -368,7 +382,10 @@ std::optional<float> VelocityTracker::getVelocity(int32_t axis, int32_t pointerI
 VelocityTracker::ComputedVelocity VelocityTracker::getComputedVelocity(int32_t units,
                                                                        float maxVelocity) {
     ComputedVelocity computedVelocity;
-    for (const auto& [axis, _] : mConfiguredStrategies) {
+    for (int32_t axis = 0; axis <= AMOTION_EVENT_MAXIMUM_VALID_AXIS_VALUE; axis++) {
+        if (!mConfiguredStrategies[axis]) {
+            continue;
+        }
         BitSet32 copyIdBits = BitSet32(mCurrentPointerIdBits);
         while (!copyIdBits.isEmpty()) {
             uint32_t id = copyIdBits.clearFirstMarkedBit();
@@ -387,14 +404,30 @@ AccumulatingVelocityTrackerStrategy::AccumulatingVelocityTrackerStrategy(
         nsecs_t horizonNanos, bool maintainHorizonDuringAdd)
       : mHorizonNanos(horizonNanos), mMaintainHorizonDuringAdd(maintainHorizonDuringAdd) {}
 
+const RingBuffer<AccumulatingVelocityTrackerStrategy::Movement>*
+AccumulatingVelocityTrackerStrategy::getMovements(int32_t pointerId) const {
+    if (pointerId < 0 || pointerId > MAX_POINTER_ID || !mMovements[pointerId]) {
+        return nullptr;
+    }
+    return &*mMovements[pointerId];
+}
+
 void AccumulatingVelocityTrackerStrategy::clearPointer(int32_t pointerId) {
-    mMovements.erase(pointerId);
+    if (pointerId < 0 || pointerId > MAX_POINTER_ID) {
+        return;
+    }
+    if (mMovements[pointerId]) {
+        mMovements[pointerId]->clear();
+    }
 }
 
 void AccumulatingVelocityTrackerStrategy::addMovement(nsecs_t eventTime, int32_t pointerId,
                                                       float position) {
-    auto [ringBufferIt, _] = mMovements.try_emplace(pointerId, HISTORY_SIZE);
-    RingBuffer<Movement>& movements = ringBufferIt->second;
+    std::optional<RingBuffer<Movement>>& pointerMovements = mMovements[pointerId];
+    if (!pointerMovements) {
+        pointerMovements.emplace(HISTORY_SIZE);
+    }
+    RingBuffer<Movement>& movements = *pointerMovements;
     const size_t size = movements.size();
 
     if (size != 0 && movements[size - 1].eventTime == eventTime) {
@@ -404,16 +437,24 @@ void AccumulatingVelocityTrackerStrategy::addMovement(nsecs_t eventTime, int32_t
         // for this time (i.e. pop out the last element, and insert the updated movement).
         // We only compare against the last value, as it is likely that addMovement is called
         // in chronological order as events occur.
+        onMovementRemoved(pointerId, movements[size - 1]);
         movements.popBack();
+    } else if (size == movements.capacity()) {
+        // Make room for the new movement, which the ring buffer would otherwise do by silently
+        // dropping the oldest one.
+        onMovementRemoved(pointerId, movements[0]);
+        movements.popFront();
     }
 
     movements.pushBack({eventTime, position});
+    onMovementAdded(pointerId);
 
     // Clear movements that do not fall within `mHorizonNanos` of the latest movement.
     // Note that, if in the future we decide to use more movements (i.e. increase HISTORY_SIZE),
     // we can consider making this step binary-search based, which will give us some improvement.
     if (mMaintainHorizonDuringAdd) {
         while (eventTime - movements[0].eventTime > mHorizonNanos) {
+            onMovementRemoved(pointerId, movements[0]);
             movements.popFront();
         }
     }
@@ -426,10 +467,54 @@ LeastSquaresVelocityTrackerStrategy::LeastSquaresVelocityTrackerStrategy(uint32_
       : AccumulatingVelocityTrackerStrategy(HORIZON /*horizonNanos*/,
                                             true /*maintainHorizonDuringAdd*/),
         mDegree(degree),
-        mWeighting(weighting) {}
+        mWeighting(weighting),
+        mUseRunningSums(degree == 2 && weighting == Weighting::NONE) {}
 
 LeastSquaresVelocityTrackerStrategy::~LeastSquaresVelocityTrackerStrategy() {}
 
+void LeastSquaresVelocityTrackerStrategy::RunningSums::accumulate(const Movement& movement,
+                                                                  double sign) {
+    const double x = (movement.eventTime - originTime) * 1E-9;
+    const double y = movement.position;
+    const double x2 = x * x;
+    sx += sign * x;
+    sx2 += sign * x2;
+    sx3 += sign * x2 * x;
+    sx4 += sign * x2 * x2;
+    sy += sign * y;
+    sxy += sign * x * y;
+    sx2y += sign * x2 * y;
+}
+
+void LeastSquaresVelocityTrackerStrategy::onMovementAdded(int32_t pointerId) {
+    if (!mUseRunningSums) {
+        return;
+    }
+    const RingBuffer<Movement>& movements = *mMovements[pointerId];
+    const Movement& newestMovement = movements[movements.size() - 1];
+    RunningSums& sums = mRunningSums[pointerId];
+    if (movements.size() == 1 || newestMovement.eventTime - sums.originTime > HORIZON) {
+        // Sum the movements up again, relative to the newest one. This keeps the times in the sums
+        // within a few horizons, and drops the rounding errors left behind by removed movements.
+        // It happens about once per horizon, so adding a movement is still constant time on
+        // average.
+        sums = RunningSums();
+        sums.originTime = newestMovement.eventTime;
+        for (size_t i = 0; i < movements.size(); i++) {
+            sums.accumulate(movements[i], 1);
+        }
+        return;
+    }
+    sums.accumulate(newestMovement, 1);
+}
+
+void LeastSquaresVelocityTrackerStrategy::onMovementRemoved(int32_t pointerId,
+                                                            const Movement& movement) {
+    if (mUseRunningSums) {
+        mRunningSums[pointerId].accumulate(movement, -1);
+    }
+}
+
 /**
  * Solves a linear least squares problem to obtain a N degree polynomial that fits
  * the specified input data as nearly as possible.
@@ -645,13 +730,36 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::solveUnweightedLeastSq
     return (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
 }
 
+std::optional<float> LeastSquaresVelocityTrackerStrategy::solveUnweightedLeastSquaresDeg2(
+        const RunningSums& sums, size_t count, nsecs_t newestTime) {
+    // Solving y = a + b*x + c*x^2, where "x" is the time of the movements relative to the origin
+    // of the sums. The velocity is then the derivative of this at the time of the newest movement.
+    const double n = count;
+    double Sxx = sums.sx2 - sums.sx * sums.sx / n;
+    double Sxy = sums.sxy - sums.sx * sums.sy / n;
+    double Sxx2 = sums.sx3 - sums.sx * sums.sx2 / n;
+    double Sx2y = sums.sx2y - sums.sx2 * sums.sy / n;
+    double Sx2x2 = sums.sx4 - sums.sx2 * sums.sx2 / n;
+
+    double denominator = Sxx * Sx2x2 - Sxx2 * Sxx2;
+    if (denominator == 0) {
+        ALOGW("division by 0 when computing velocity, Sxx=%f, Sx2x2=%f, Sxx2=%f", Sxx, Sx2x2, Sxx2);
+        return std::nullopt;
+    }
+
+    double b = (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
+    double c = (Sx2y * Sxx - Sxy * Sxx2) / denominator;
+    double newestX = (newestTime - sums.originTime) * 1E-9;
+    return static_cast<float>(b + 2 * c * newestX);
+}
+
 std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t pointerId) const {
-    const auto movementIt = mMovements.find(pointerId);
-    if (movementIt == mMovements.end()) {
+    const RingBuffer<Movement>* pointerMovements = getMovements(pointerId);
+    if (pointerMovements == nullptr) {
         return std::nullopt; // no data
     }
 
-    const RingBuffer<Movement>& movements = movementIt->second;
+    const RingBuffer<Movement>& movements = *pointerMovements;
     const size_t size = movements.size();
     if (size == 0) {
         return std::nullopt; // no data
@@ -668,6 +776,10 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t po
 
     if (degree == 2 && mWeighting == Weighting::NONE) {
         // Optimize unweighted, quadratic polynomial fit
+        if (mUseRunningSums) {
+            return solveUnweightedLeastSquaresDeg2(mRunningSums[pointerId], size,
+                                                   movements[size - 1].eventTime);
+        }
         return solveUnweightedLeastSquaresDeg2(movements);
     }
 
@@ -690,7 +802,7 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t po
 }
 
 float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint32_t index) const {
-    const RingBuffer<Movement>& movements = mMovements.at(pointerId);
+    const RingBuffer<Movement>& movements = *mMovements[pointerId];
     const size_t size = movements.size();
     switch (mWeighting) {
         case Weighting::DELTA: {
@@ -843,12 +955,12 @@ LegacyVelocityTrackerStrategy::~LegacyVelocityTrackerStrategy() {
 }
 
 std::optional<float> LegacyVelocityTrackerStrategy::getVelocity(int32_t pointerId) const {
-    const auto movementIt = mMovements.find(pointerId);
-    if (movementIt == mMovements.end()) {
+    const RingBuffer<Movement>* pointerMovements = getMovements(pointerId);
+    if (pointerMovements == nullptr) {
         return std::nullopt; // no data
     }
 
-    const RingBuffer<Movement>& movements = movementIt->second;
+    const RingBuffer<Movement>& movements = *pointerMovements;
     const size_t size = movements.size();
     if (size == 0) {
         return std::nullopt; // no data
@@ -992,12 +1104,12 @@ static float kineticEnergyToVelocity(float work) {
 }
 
 std::optional<float> ImpulseVelocityTrackerStrategy::getVelocity(int32_t pointerId) const {
-    const auto movementIt = mMovements.find(pointerId);
-    if (movementIt == mMovements.end()) {
+    const RingBuffer<Movement>* pointerMovements = getMovements(pointerId);
+    if (pointerMovements == nullptr) {
         return std::nullopt; // no data
     }
 
-    const RingBuffer<Movement>& movements = movementIt->second;
+    const RingBuffer<Movement>& movements = *pointerMovements;
     const size_t size = movements.size();
     if (size == 0) {
         return std::nullopt; // no data
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <attestation/HmacKeyManager.h>
+#include <input/InputTransport.h>
+
+namespace {
+
+// Counts the heap allocations of this process, so that the benchmarks can report how many of
+// them consuming a frame takes.
+std::atomic<size_t> gAllocationCount = 0;
+
+} // namespace
+
+void* operator new(size_t size) {
+    gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+namespace android {
+namespace {
+
+using std::literals::chrono_literals::operator""ms;
+
+constexpr int32_t kDeviceId = 1;
+// A touchscreen reporting at 240 Hz.
+constexpr std::chrono::nanoseconds kSamplePeriod = 4ms;
+// How long before a frame the samples must be, to not be held for the next one when resampling.
+constexpr std::chrono::nanoseconds kResampleLatency = 5ms;
+
+class ConsumerFixture {
+public:
+    ConsumerFixture(size_t pointerCount, bool resample)
+          : mPointerCount(pointerCount), mResample(resample) {
+        std::unique_ptr<InputChannel> serverChannel, clientChannel;
+        InputChannel::openInputChannelPair("benchmark", serverChannel, clientChannel);
+        mPublisher = std::make_unique<InputPublisher>(std::move(serverChannel));
+        mConsumer = std::make_unique<InputConsumer>(std::move(clientChannel),
+                                                    /*enableTouchResampling=*/resample);
+    }
+
+    status_t publish(int32_t action) {
+        std::vector<PointerProperties> properties(mPointerCount);
+        std::vector<PointerCoords> coords(mPointerCount);
+        for (size_t i = 0; i < mPointerCount; i++) {
+            properties[i].id = i;
+            properties[i].toolType = ToolType::FINGER;
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_X, mPosition + 100 * i);
+            coords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, 2 * mPosition);
+        }
+        mPosition += 3;
+        mEventTime += kSamplePeriod.count();
+
+        const ui::Transform identityTransform;
+        return mPublisher->publishMotionEvent(mSeq++, InputEvent::nextId(), kDeviceId,
+                                              AINPUT_SOURCE_TOUCHSCREEN, ADISPLAY_ID_DEFAULT,
+                                              INVALID_HMAC, action, /*actionButton=*/0,
+                                              /*flags=*/0, /*edgeFlags=*/0, AMETA_NONE,
+                                              /*buttonState=*/0, MotionClassification::NONE,
+                                              identityTransform, /*xPrecision=*/0,
+                                              /*yPrecision=*/0,
+                                              AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                              AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                              identityTransform, /*downTime=*/0, mEventTime,
+                                              mPointerCount, properties.data(), coords.data());
+    }
+
+    // Consumes the events of a frame and finishes them, as the app side of a window would.
+    // When resampling, the newest sample is later than the frame, so it is held back and used
+    // for resampling. Otherwise the frame comes after the newest sample, so the batch is emptied
+    // and its event is recycled.
+    status_t consumeFrame() {
+        const nsecs_t frameTime =
+                mResample ? mEventTime + kResampleLatency.count() - 1 : mEventTime + 1;
+        uint32_t seq;
+        InputEvent* event;
+        status_t status;
+        while ((status = mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, frameTime,
+                                            &seq, &event)) == OK) {
+            status = mConsumer->sendFinishedSignal(seq, /*handled=*/true);
+            if (status != OK) {
+                return status;
+            }
+        }
+        return status == WOULD_BLOCK ? OK : status;
+    }
+
+    void drainConsumerResponses() {
+        while (mPublisher->receiveConsumerResponse().ok()) {
+        }
+    }
+
+private:
+    const size_t mPointerCount;
+    const bool mResample;
+    std::unique_ptr<InputPublisher> mPublisher;
+    std::unique_ptr<InputConsumer> mConsumer;
+    PreallocatedInputEventFactory mEventFactory;
+    uint32_t mSeq = 1;
+    nsecs_t mEventTime = 0;
+    float mPosition = 0;
+};
+
+// Arguments are the number of pointers, the number of samples per frame, and whether touch
+// resampling is enabled.
+void consumeBatchedMotion(benchmark::State& state) {
+    ConsumerFixture fixture(state.range(0), state.range(2) != 0);
+    const size_t samplesPerFrame = state.range(1);
+    if (fixture.publish(AMOTION_EVENT_ACTION_DOWN) != OK || fixture.consumeFrame() != OK) {
+        state.SkipWithError("Could not start the gesture");
+        return;
+    }
+    fixture.drainConsumerResponses();
+
+    size_t allocationCount = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < samplesPerFrame; i++) {
+            if (fixture.publish(AMOTION_EVENT_ACTION_MOVE) != OK) {
+                state.SkipWithError("Could not publish");
+                return;
+            }
+        }
+
+        const size_t allocationsBefore = gAllocationCount.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        const status_t status = fixture.consumeFrame();
+        const auto end = std::chrono::steady_clock::now();
+        allocationCount += gAllocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        if (status != OK) {
+            state.SkipWithError("Could not consume");
+            return;
+        }
+        state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+
+        fixture.drainConsumerResponses();
+    }
+    state.counters["allocations/frame"] =
+            benchmark::Counter(allocationCount, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(consumeBatchedMotion)
+        ->UseManualTime()
+        ->ArgNames({"pointers", "samples", "resample"})
+        ->ArgsProduct({{1, 2, 5, 10}, {1, 2, 4}, {0, 1}});
+
+} // namespace
+} // namespace android
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <vector>
+
+#include <attestation/HmacKeyManager.h>
+#include <gui/constants.h>
+#include <input/VelocityTracker.h>
+
+namespace android {
+namespace {
+
+using std::literals::chrono_literals::operator""ns;
+
+// A touchscreen reporting at 120 Hz, as in the recorded flings of VelocityTracker_test.
+constexpr std::chrono::nanoseconds kSamplePeriod = 8333333ns;
+constexpr size_t kMovesPerGesture = 60;
+
+MotionEvent createMotionEvent(int32_t action, nsecs_t eventTime, size_t pointerCount,
+                              float position) {
+    std::vector<PointerProperties> properties(pointerCount);
+    std::vector<PointerCoords> coords(pointerCount);
+    for (size_t i = 0; i < pointerCount; i++) {
+        properties[i].id = i;
+        properties[i].toolType = ToolType::FINGER;
+        coords[i].setAxisValue(AMOTION_EVENT_AXIS_X, position + 100 * i);
+        coords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, 2 * position);
+    }
+
+    MotionEvent event;
+    ui::Transform identityTransform;
+    event.initialize(InputEvent::nextId(), /*deviceId=*/0, AINPUT_SOURCE_TOUCHSCREEN,
+                     ADISPLAY_ID_DEFAULT, INVALID_HMAC, action, /*actionButton=*/0, /*flags=*/0,
+                     AMOTION_EVENT_EDGE_FLAG_NONE, AMETA_NONE, /*buttonState=*/0,
+                     MotionClassification::NONE, identityTransform, /*xPrecision=*/0,
+                     /*yPrecision=*/0, AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                     AMOTION_EVENT_INVALID_CURSOR_POSITION, identityTransform, /*downTime=*/0,
+                     eventTime, pointerCount, properties.data(), coords.data());
+    return event;
+}
+
+// A fling with the given number of pointers that accelerates over the whole gesture.
+std::vector<MotionEvent> createFling(size_t pointerCount) {
+    std::vector<MotionEvent> events;
+    nsecs_t eventTime = 0;
+    float position = 0;
+    events.push_back(createMotionEvent(AMOTION_EVENT_ACTION_DOWN, eventTime, 1, position));
+    for (size_t i = 1; i < pointerCount; i++) {
+        events.push_back(
+                createMotionEvent(AMOTION_EVENT_ACTION_POINTER_DOWN |
+                                          (i << AMOTION_EVENT_ACTION_POINTER_INDEX_SHIFT),
+                                  eventTime, i + 1, position));
+    }
+    for (size_t i = 0; i < kMovesPerGesture; i++) {
+        eventTime += kSamplePeriod.count();
+        position += 0.5f * i;
+        events.push_back(
+                createMotionEvent(AMOTION_EVENT_ACTION_MOVE, eventTime, pointerCount, position));
+    }
+    return events;
+}
+
+// Feeds a fling to the tracker, and queries the velocity of every pointer after each event, as
+// an app that keeps up with a gesture does.
+void addMovementAndGetVelocity(benchmark::State& state, VelocityTracker::Strategy strategy) {
+    const size_t pointerCount = state.range(0);
+    const std::vector<MotionEvent> events = createFling(pointerCount);
+    for (auto _ : state) {
+        VelocityTracker tracker(strategy);
+        for (const MotionEvent& event : events) {
+            tracker.addMovement(event);
+            for (size_t i = 0; i < pointerCount; i++) {
+                benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_X, i));
+                benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_Y, i));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * events.size());
+}
+BENCHMARK_CAPTURE(addMovementAndGetVelocity, lsq2, VelocityTracker::Strategy::LSQ2)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(5)
+        ->Arg(10);
+BENCHMARK_CAPTURE(addMovementAndGetVelocity, impulse, VelocityTracker::Strategy::IMPULSE)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(5)
+        ->Arg(10);
+BENCHMARK_CAPTURE(addMovementAndGetVelocity, lsq3, VelocityTracker::Strategy::LSQ3)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(5)
+        ->Arg(10);
+
+// Only the velocity at the end of the fling is needed, as when deciding whether to start one.
+void getComputedVelocity(benchmark::State& state) {
+    const std::vector<MotionEvent> events = createFling(state.range(0));
+    VelocityTracker tracker;
+    for (const MotionEvent& event : events) {
+        tracker.addMovement(event);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tracker.getComputedVelocity(/*units=*/1000, /*maxVelocity=*/8000));
+    }
+}
+BENCHMARK(getComputedVelocity)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+
+} // namespace
+} // namespace android
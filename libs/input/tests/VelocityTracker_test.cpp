@@ -1335,6 +1335,20 @@ TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategy_Parabolic3) {
     computeAndCheckQuadraticVelocity(motions, 0E3);
 }
 
+/*
+ * A long movement at constant velocity. Most of the movements leave the horizon (and the history)
+ * of the tracker again, which must not affect the fit of the ones that are left.
+ */
+TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategy_LongLinearMotion) {
+    std::vector<PlanarMotionEventEntry> motions;
+    for (int i = 0; i < 500; i++) {
+        const float position = 2 * i;
+        motions.push_back({i * 4ms, {{position, position}}});
+    }
+    motions.push_back({499 * 4ms, {{998, 998}}}); // ACTION_UP
+    computeAndCheckQuadraticVelocity(motions, 500);
+}
+
 // Recorded by hand on sailfish, but only the diffs are taken to test cumulative axis velocity.
 TEST_F(VelocityTrackerTest, AxisScrollVelocity) {
     std::vector<std::pair<std::chrono::nanoseconds, float>> motions = {
@@ -51,6 +51,12 @@ struct DisplaySettings {
     // z=1.
     Rect clip = Rect::INVALID_RECT;
 
+    // If valid, only this rectangle of the destination buffer is cleared and redrawn, and the
+    // rest of the buffer keeps its previous contents. This is in the coordinates of the buffer,
+    // like physicalDisplay. Layers that blur what is behind them must not be drawn with a scissor,
+    // since the blur would sample outside of it.
+    Rect scissor = Rect::INVALID_RECT;
+
     // Maximum luminance pulled from the display's HDR capabilities.
     float maxLuminance = 1.0f;
 
@@ -93,7 +99,8 @@ struct DisplaySettings {
 
 static inline bool operator==(const DisplaySettings& lhs, const DisplaySettings& rhs) {
     return lhs.namePlusId == rhs.namePlusId && lhs.physicalDisplay == rhs.physicalDisplay &&
-            lhs.clip == rhs.clip && lhs.maxLuminance == rhs.maxLuminance &&
+            lhs.clip == rhs.clip && lhs.scissor == rhs.scissor &&
+            lhs.maxLuminance == rhs.maxLuminance &&
             lhs.currentLuminanceNits == rhs.currentLuminanceNits &&
             lhs.outputDataspace == rhs.outputDataspace &&
             lhs.colorTransform == rhs.colorTransform &&
@@ -133,6 +140,8 @@ static inline void PrintTo(const DisplaySettings& settings, ::std::ostream* os)
     PrintTo(settings.physicalDisplay, os);
     *os << "\n    .clip = ";
     PrintTo(settings.clip, os);
+    *os << "\n    .scissor = ";
+    PrintTo(settings.scissor, os);
     *os << "\n    .maxLuminance = " << settings.maxLuminance;
     *os << "\n    .currentLuminanceNits = " << settings.currentLuminanceNits;
     *os << "\n    .outputDataspace = ";
@@ -742,6 +742,10 @@ void SkiaRenderEngine::drawLayersInternal(
     }
 
     AutoSaveRestore surfaceAutoSaveRestore(canvas);
+    // Only redraw the scissored part of the canvas, if any, since the rest is kept as is.
+    if (display.scissor.isValid()) {
+        canvas->clipRect(getSkRect(display.scissor));
+    }
     // Clear the entire canvas with a transparent black to prevent ghost images.
     canvas->clear(SK_ColorTRANSPARENT);
     initCanvas(canvas, display);
@@ -785,6 +789,9 @@ void SkiaRenderEngine::drawLayersInternal(
             // assign dstCanvas to canvas and ensure that the canvas state is up to date
             canvas = dstCanvas;
             surfaceAutoSaveRestore.replace(canvas);
+            if (display.scissor.isValid()) {
+                canvas->clipRect(getSkRect(display.scissor));
+            }
             initCanvas(canvas, display);
 
             LOG_ALWAYS_FATAL_IF(activeSurface->getCanvas()->getSaveCount() !=
@@ -1508,6 +1508,42 @@ TEST_P(RenderEngineTest, drawLayers_fillRedBufferAndEmptyBuffer) {
     expectBufferColor(fullscreenRect(), 0, 0, 0, 0);
 }
 
+TEST_P(RenderEngineTest, drawLayers_scissorKeepsPixelsOutsideOfIt) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine();
+    renderengine::DisplaySettings settings;
+    settings.physicalDisplay = fullscreenRect();
+    settings.clip = fullscreenRect();
+    settings.outputDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+
+    renderengine::LayerSettings redLayer{
+            .geometry.boundaries = fullscreenRect().toFloatRect(),
+            .source.solidColor = half3(1.0f, 0.0f, 0.0f),
+            .alpha = 1.f,
+    };
+    invokeDraw(settings, {redLayer});
+    expectBufferColor(fullscreenRect(), 255, 0, 0, 255);
+
+    // Redraw a green layer over the whole buffer, but only within the top left quadrant.
+    const Rect scissor(DEFAULT_DISPLAY_WIDTH / 2, DEFAULT_DISPLAY_HEIGHT / 2);
+    settings.scissor = scissor;
+    renderengine::LayerSettings greenLayer{
+            .geometry.boundaries = fullscreenRect().toFloatRect(),
+            .source.solidColor = half3(0.0f, 1.0f, 0.0f),
+            .alpha = 1.f,
+    };
+    invokeDraw(settings, {greenLayer});
+    expectBufferColor(scissor, 0, 255, 0, 255);
+    expectBufferColor(Region(fullscreenRect()).subtractSelf(scissor), 255, 0, 0, 255);
+
+    // An empty redraw only clears the scissor.
+    invokeDraw(settings, {});
+    expectBufferColor(scissor, 0, 0, 0, 0);
+    expectBufferColor(Region(fullscreenRect()).subtractSelf(scissor), 255, 0, 0, 255);
+}
+
 TEST_P(RenderEngineTest, drawLayers_withoutBuffers_withColorTransform) {
     if (!GetParam()->apiSupported()) {
         GTEST_SKIP();
@@ -19,6 +19,9 @@
 #include <inttypes.h>
 #include <limits.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <android-base/stringprintf.h>
 
 #include <utils/Log.h>
@@ -64,6 +67,118 @@ enum {
 
 const Region Region::INVALID_REGION(Rect::INVALID_RECT);
 
+namespace {
+
+// Boolean operations are rasterized into buffers owned by the calling thread and reused from one
+// operation to the next, then copied into the destination. In-place operations can therefore
+// read from the destination while rasterizing, instead of copying it into a temporary, and the
+// destination only reallocates when it needs more room than it already has.
+struct OperationBuffers {
+    // A thread that once operated on a very complex region does not hold onto the memory.
+    static constexpr size_t kMaxRetainedRects = 1024;
+
+    void trim() {
+        if (rects.capacity() > kMaxRetainedRects) {
+            std::vector<Rect>().swap(rects);
+        }
+        if (span.capacity() > kMaxRetainedRects) {
+            std::vector<Rect>().swap(span);
+        }
+    }
+
+    std::vector<Rect> rects;
+    std::vector<Rect> span;
+};
+
+OperationBuffers& getOperationBuffers() {
+    thread_local OperationBuffers buffers;
+    return buffers;
+}
+
+// Unlike Rect::isEmpty, does not overflow for rects spanning most of the coordinate space.
+bool hasArea(const Rect& r) {
+    return r.left < r.right && r.top < r.bottom;
+}
+
+// Computes the operations between a region and a rect whose result is the region, the rect,
+// their intersection or nothing, without rasterizing. Returns false if the operation needs to
+// be rasterized.
+bool trivialOperation(uint32_t op, Region& dst, const Region& lhs, const Rect& rhs) {
+    const Rect bounds = lhs.getBounds();
+    if (!hasArea(bounds) || !hasArea(rhs)) {
+        return false;
+    }
+
+    Rect overlap;
+    if (!bounds.intersect(rhs, &overlap) || !hasArea(overlap)) {
+        switch (op) {
+            case op_and:
+                dst.clear();
+                return true;
+            case op_nand:
+                dst = lhs;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    const bool rhsContainsLhs = overlap == bounds;
+    switch (op) {
+        case op_and:
+            if (rhsContainsLhs) {
+                dst = lhs;
+                return true;
+            }
+            if (lhs.isRect()) {
+                dst.set(overlap);
+                return true;
+            }
+            return false;
+        case op_nand:
+            if (rhsContainsLhs) {
+                dst.clear();
+                return true;
+            }
+            return false;
+        case op_or:
+            if (rhsContainsLhs) {
+                dst.set(rhs);
+                return true;
+            }
+            if (lhs.isRect() && overlap == rhs) {
+                dst = lhs;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+// The rects of a region are sorted in bands of rects that share their top and bottom. The bands
+// are sorted from top to bottom and do not overlap, and the rects of a band are sorted from left
+// to right and do not overlap either, so both can be binary searched.
+
+// Returns the first rect of the topmost band that ends below y.
+const Rect* findBand(const Rect* begin, const Rect* end, int32_t y) {
+    return std::upper_bound(begin, end, y, [](int32_t y, const Rect& r) { return y < r.bottom; });
+}
+
+// Returns the rect after the last rect of the band starting at |band|.
+const Rect* findBandEnd(const Rect* band, const Rect* end) {
+    return std::upper_bound(band, end, band->top,
+                            [](int32_t top, const Rect& r) { return top < r.top; });
+}
+
+// Returns the leftmost rect of the band that ends right of x.
+const Rect* findInBand(const Rect* band, const Rect* bandEnd, int32_t x) {
+    return std::upper_bound(band, bandEnd, x,
+                            [](int32_t x, const Rect& r) { return x < r.right; });
+}
+
+} // namespace
+
 // ----------------------------------------------------------------------------
 
 Region::Region() {
@@ -249,17 +364,60 @@ bool Region::contains(const Point& point) const {
 }
 
 bool Region::contains(int x, int y) const {
-    const_iterator cur = begin();
     const_iterator const tail = end();
-    while (cur != tail) {
-        if (y >= cur->top && y < cur->bottom && x >= cur->left && x < cur->right) {
+    const_iterator const band = findBand(begin(), tail, y);
+    if (band == tail || y < band->top) {
+        return false;
+    }
+    const_iterator const bandEnd = findBandEnd(band, tail);
+    const_iterator const cur = findInBand(band, bandEnd, x);
+    return cur != bandEnd && x >= cur->left;
+}
+
+bool Region::intersects(const Rect& rect) const {
+    if (!hasArea(rect) || isEmpty()) {
+        return false;
+    }
+    const_iterator const tail = end();
+    const_iterator band = findBand(begin(), tail, rect.top);
+    while (band != tail && band->top < rect.bottom) {
+        const_iterator const bandEnd = findBandEnd(band, tail);
+        const_iterator const cur = findInBand(band, bandEnd, rect.left);
+        if (cur != bandEnd && cur->left < rect.right) {
             return true;
         }
-        cur++;
+        band = bandEnd;
     }
     return false;
 }
 
+bool Region::covers(const Rect& rect) const {
+    if (!hasArea(rect) || isEmpty()) {
+        return false;
+    }
+    const_iterator const tail = end();
+    const_iterator band = findBand(begin(), tail, rect.top);
+    int32_t coveredBottom = rect.top;
+    while (coveredBottom < rect.bottom) {
+        // Each band must start where the previous one ended, and cover the rect horizontally.
+        if (band == tail || band->top > coveredBottom) {
+            return false;
+        }
+        const_iterator const bandEnd = findBandEnd(band, tail);
+        int32_t coveredRight = rect.left;
+        for (const_iterator cur = findInBand(band, bandEnd, rect.left);
+             cur != bandEnd && cur->left <= coveredRight && coveredRight < rect.right; cur++) {
+            coveredRight = cur->right;
+        }
+        if (coveredRight < rect.right) {
+            return false;
+        }
+        coveredBottom = band->bottom;
+        band = bandEnd;
+    }
+    return true;
+}
+
 void Region::clear()
 {
     mStorage.clear();
@@ -329,8 +487,7 @@ Region& Region::subtractSelf(const Rect& r) {
     return operationSelf(r, op_nand);
 }
 Region& Region::operationSelf(const Rect& r, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, r);
+    boolean_operation(op, *this, *this, r);
     return *this;
 }
 
@@ -353,8 +510,7 @@ Region& Region::subtractSelf(const Region& rhs) {
     return operationSelf(rhs, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, rhs);
+    boolean_operation(op, *this, *this, rhs);
     return *this;
 }
 
@@ -438,8 +594,7 @@ Region& Region::subtractSelf(const Region& rhs, int dx, int dy) {
     return operationSelf(rhs, dx, dy, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, int dx, int dy, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, rhs, dx, dy);
+    boolean_operation(op, *this, *this, rhs, dx, dy);
     return *this;
 }
 
@@ -470,15 +625,16 @@ const Region Region::operation(const Region& rhs, int dx, int dy, uint32_t op) c
 class Region::rasterizer : public region_operator<Rect>::region_rasterizer
 {
     Rect bounds;
-    FatVector<Rect>& storage;
+    std::vector<Rect>& storage;
     Rect* head;
     Rect* tail;
-    FatVector<Rect> span;
+    std::vector<Rect>& span;
     Rect* cur;
 public:
-    explicit rasterizer(Region& reg)
-        : bounds(INT_MAX, 0, INT_MIN, 0), storage(reg.mStorage), head(), tail(), cur() {
+    rasterizer(std::vector<Rect>& storage, std::vector<Rect>& span)
+        : bounds(INT_MAX, 0, INT_MIN, 0), storage(storage), head(), tail(), span(span), cur() {
         storage.clear();
+        span.clear();
     }
 
     virtual ~rasterizer();
@@ -653,6 +809,13 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     validate(dst, "boolean_operation (before): dst");
 #endif
 
+    if ((dx | dy) == 0 &&
+        ((rhs.isRect() && trivialOperation(op, dst, lhs, rhs.getBounds())) ||
+         (lhs.isRect() && (op == op_or || op == op_and) &&
+          trivialOperation(op, dst, rhs, lhs.getBounds())))) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -662,10 +825,14 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     region_operator<Rect>::region lhs_region(lhs_rects, lhs_count);
     region_operator<Rect>::region rhs_region(rhs_rects, rhs_count, dx, dy);
     region_operator<Rect> operation(op, lhs_region, rhs_region);
+    OperationBuffers& buffers = getOperationBuffers();
     { // scope for rasterizer (dtor has side effects)
-        rasterizer r(dst);
+        rasterizer r(buffers.rects, buffers.span);
         operation(r);
     }
+    // lhs or rhs may be dst, so it can only be written once the operation is done.
+    dst.mStorage.assign(buffers.rects.begin(), buffers.rects.end());
+    buffers.trim();
 
 #if defined(VALIDATE_REGIONS)
     validate(lhs, "boolean_operation: lhs");
@@ -767,16 +934,24 @@ void Region::boolean_operation(uint32_t op, Region& dst,
 #if VALIDATE_WITH_CORECG || defined(VALIDATE_REGIONS)
     boolean_operation(op, dst, lhs, Region(rhs), dx, dy);
 #else
+    if ((dx | dy) == 0 && trivialOperation(op, dst, lhs, rhs)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
     region_operator<Rect>::region lhs_region(lhs_rects, lhs_count);
     region_operator<Rect>::region rhs_region(&rhs, 1, dx, dy);
     region_operator<Rect> operation(op, lhs_region, rhs_region);
+    OperationBuffers& buffers = getOperationBuffers();
     { // scope for rasterizer (dtor has side effects)
-        rasterizer r(dst);
+        rasterizer r(buffers.rects, buffers.span);
         operation(r);
     }
+    // lhs may be dst, so it can only be written once the operation is done.
+    dst.mStorage.assign(buffers.rects.begin(), buffers.rects.end());
+    buffers.trim();
 
 #endif
 }
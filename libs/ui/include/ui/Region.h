@@ -54,8 +54,13 @@ public:
     inline  Rect        getBounds() const   { return mStorage[mStorage.size() - 1]; }
     inline  Rect        bounds() const      { return getBounds(); }
 
+            // these are logarithmic in the number of rects of the region
             bool        contains(const Point& point) const;
             bool        contains(int x, int y) const;
+            // true if any of rect is in the region
+            bool        intersects(const Rect& rect) const;
+            // true if rect is not empty and all of it is in the region
+            bool        covers(const Rect& rect) const;
 
             // the region becomes its bounds
             Region&     makeBoundsSelf();
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cmath>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+namespace android {
+namespace {
+
+constexpr int32_t kRectSize = 10;
+constexpr int32_t kRectSpacing = 16;
+
+// A grid of |rectCount| disjoint squares, shifted by |offset|. Two grids shifted by less than
+// the spacing partially overlap each other, so every operation between them produces a complex
+// region.
+Region makeGrid(int64_t rectCount, int32_t offset) {
+    const auto columns = static_cast<int64_t>(std::ceil(std::sqrt(rectCount)));
+    Region region;
+    for (int64_t i = 0; i < rectCount; i++) {
+        const auto left = static_cast<int32_t>(i % columns) * kRectSpacing + offset;
+        const auto top = static_cast<int32_t>(i / columns) * kRectSpacing + offset;
+        region.orSelf(Rect(left, top, left + kRectSize, top + kRectSize));
+    }
+    return region;
+}
+
+// The result is a new region, as in `a.merge(b)`.
+template <const Region (Region::*Operation)(const Region&) const>
+void operation(benchmark::State& state) {
+    const Region lhs = makeGrid(state.range(0), 0);
+    const Region rhs = makeGrid(state.range(0), 4);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize((lhs.*Operation)(rhs));
+    }
+}
+BENCHMARK(operation<&Region::merge>)->Name("merge")->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(operation<&Region::subtract>)->Name("subtract")->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(operation<&Region::intersect>)->Name("intersect")->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// The result replaces the region, as in `a.orSelf(b)`. The region is reset from a copy every
+// iteration, which reuses its storage.
+template <Region& (Region::*Operation)(const Region&)>
+void operationSelf(benchmark::State& state) {
+    const Region lhs = makeGrid(state.range(0), 0);
+    const Region rhs = makeGrid(state.range(0), 4);
+    Region region;
+    for (auto _ : state) {
+        region = lhs;
+        benchmark::DoNotOptimize((region.*Operation)(rhs));
+    }
+}
+BENCHMARK(operationSelf<&Region::orSelf>)->Name("orSelf")->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(operationSelf<&Region::subtractSelf>)
+        ->Name("subtractSelf")
+        ->Arg(1)
+        ->Arg(10)
+        ->Arg(100)
+        ->Arg(1000);
+BENCHMARK(operationSelf<&Region::andSelf>)->Name("andSelf")->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// Subtracting a rect that does not overlap the region, as when removing the area covered by
+// layers above from a layer that is not covered.
+void subtractSelfDisjointRect(benchmark::State& state) {
+    Region region = makeGrid(state.range(0), 0);
+    const Rect rect(-100, -100, -10, -10);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.subtractSelf(rect));
+    }
+}
+BENCHMARK(subtractSelfDisjointRect)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// Query points spread over the bounds of |region|, about half of which are in the region.
+std::array<Point, 256> makeQueryPoints(const Region& region) {
+    const Rect bounds = region.getBounds();
+    std::array<Point, 256> points;
+    for (size_t i = 0; i < points.size(); i++) {
+        const auto step = static_cast<int32_t>(i);
+        points[i] = Point(bounds.left + (step * 37) % bounds.getWidth(),
+                          bounds.top + (step * 61) % bounds.getHeight());
+    }
+    return points;
+}
+
+// How contains(x, y) used to be answered, as a baseline.
+void containsByScan(benchmark::State& state) {
+    const Region region = makeGrid(state.range(0), 0);
+    const auto points = makeQueryPoints(region);
+    size_t i = 0;
+    for (auto _ : state) {
+        const Point& p = points[i++ % points.size()];
+        bool contained = false;
+        for (const Rect& rect : region) {
+            if (p.y >= rect.top && p.y < rect.bottom && p.x >= rect.left && p.x < rect.right) {
+                contained = true;
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(contained);
+    }
+}
+BENCHMARK(containsByScan)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+void contains(benchmark::State& state) {
+    const Region region = makeGrid(state.range(0), 0);
+    const auto points = makeQueryPoints(region);
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(region.contains(points[i++ % points.size()]));
+    }
+}
+BENCHMARK(contains)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Rects about the size of a grid cell, as when checking a layer against a region.
+template <bool (Region::*Query)(const Rect&) const>
+void rectQuery(benchmark::State& state) {
+    const Region region = makeGrid(state.range(0), 0);
+    const auto points = makeQueryPoints(region);
+    size_t i = 0;
+    for (auto _ : state) {
+        const Point& p = points[i++ % points.size()];
+        benchmark::DoNotOptimize((region.*Query)(Rect(p.x, p.y, p.x + 8, p.y + 8)));
+    }
+}
+BENCHMARK(rectQuery<&Region::intersects>)
+        ->Name("intersects")
+        ->Arg(10)
+        ->Arg(100)
+        ->Arg(1000)
+        ->Arg(10000);
+BENCHMARK(rectQuery<&Region::covers>)->Name("covers")->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+} // namespace
+} // namespace android
@@ -179,5 +179,144 @@ TEST_F(RegionTest, RegionHash) {
     EXPECT_NE(std::hash<Region>{}(region1), std::hash<Region>{}(region2));
 }
 
+TEST_F(RegionTest, OperationsWithSelf) {
+    Region r;
+    r.orSelf(Rect(0, 0, 100, 100));
+    r.orSelf(Rect(50, 50, 200, 150));
+    r.subtractSelf(Rect(20, 20, 40, 40));
+
+    const Region copy(r);
+    const Region expected = copy.subtract(copy, 3, -2);
+    r.subtractSelf(r, 3, -2);
+    EXPECT_TRUE(r.hasSameRects(expected));
+
+    r.orSelf(r);
+    EXPECT_TRUE(r.hasSameRects(expected));
+
+    r.subtractSelf(r);
+    EXPECT_TRUE(r.isEmpty());
+}
+
+TEST_F(RegionTest, TrivialRectOperations) {
+    Region r;
+    r.orSelf(Rect(0, 0, 10, 10));
+    r.orSelf(Rect(20, 0, 30, 10));
+    const Rect outside(100, 100, 200, 200);
+    const Rect around(-5, -5, 50, 50);
+
+    EXPECT_TRUE(r.subtract(outside).hasSameRects(r));
+    EXPECT_TRUE(r.intersect(outside).isEmpty());
+    EXPECT_TRUE(r.intersect(around).hasSameRects(r));
+    EXPECT_TRUE(r.subtract(around).isEmpty());
+    EXPECT_TRUE(r.merge(around).hasSameRects(Region(around)));
+    EXPECT_TRUE(Region(around).merge(r).hasSameRects(Region(around)));
+    EXPECT_TRUE(Region(around).intersect(r).hasSameRects(r));
+
+    const Region rect(Rect(0, 0, 10, 10));
+    EXPECT_TRUE(rect.intersect(Rect(5, 5, 20, 20)).hasSameRects(Region(Rect(5, 5, 10, 10))));
+    EXPECT_TRUE(rect.intersect(Rect(10, 0, 20, 10)).isEmpty());
+    EXPECT_TRUE(rect.merge(Rect(2, 2, 8, 8)).hasSameRects(rect));
+    EXPECT_TRUE(rect.merge(Rect(10, 0, 20, 10)).hasSameRects(Region(Rect(0, 0, 20, 10))));
+}
+
+TEST_F(RegionTest, Queries) {
+    Region r;
+    r.orSelf(Rect(0, 0, 100, 100));
+    r.subtractSelf(Rect(40, 40, 60, 60));
+    r.orSelf(Rect(100, 0, 120, 50));
+
+    EXPECT_TRUE(r.contains(0, 0));
+    EXPECT_TRUE(r.contains(119, 49));
+    EXPECT_FALSE(r.contains(50, 50));
+    EXPECT_FALSE(r.contains(100, 50));
+    EXPECT_FALSE(r.contains(-1, 0));
+
+    EXPECT_TRUE(r.intersects(Rect(30, 30, 41, 41)));
+    EXPECT_FALSE(r.intersects(Rect(40, 40, 60, 60)));
+    EXPECT_FALSE(r.intersects(Rect(100, 50, 200, 200)));
+    EXPECT_FALSE(r.intersects(Rect(10, 10, 10, 20)));
+
+    EXPECT_TRUE(r.covers(Rect(0, 0, 120, 40)));
+    EXPECT_TRUE(r.covers(Rect(0, 0, 40, 100)));
+    EXPECT_FALSE(r.covers(Rect(0, 0, 120, 51)));
+    EXPECT_FALSE(r.covers(Rect(30, 30, 41, 41)));
+    EXPECT_FALSE(r.covers(Rect(10, 10, 10, 20)));
+
+    EXPECT_FALSE(Region().contains(0, 0));
+    EXPECT_FALSE(Region().intersects(Rect(-10, -10, 10, 10)));
+    EXPECT_FALSE(Region().covers(Rect(0, 0, 1, 1)));
+}
+
+// The binary searches must agree with a scan of every rect and point.
+TEST_F(RegionTest, Random_Queries) {
+    srandom(12345);
+
+    for (int iter = 0; iter < ITER_MAX; iter++) {
+        Region r;
+        for (int i = 0; i < 20; i++) {
+            const int left = static_cast<int>(random() % 40);
+            const int top = static_cast<int>(random() % 40);
+            const Rect rect(left, top, left + 1 + static_cast<int>(random() % 20),
+                            top + 1 + static_cast<int>(random() % 20));
+            if (random() % 3) {
+                r.orSelf(rect);
+            } else {
+                r.subtractSelf(rect);
+            }
+        }
+
+        auto scanContains = [&r](int x, int y) {
+            for (const Rect& rect : r) {
+                if (x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        for (int y = -1; y <= 61; y++) {
+            for (int x = -1; x <= 61; x++) {
+                ASSERT_EQ(scanContains(x, y), r.contains(x, y)) << x << ", " << y;
+            }
+        }
+
+        for (int i = 0; i < 100; i++) {
+            const int left = static_cast<int>(random() % 60) - 1;
+            const int top = static_cast<int>(random() % 60) - 1;
+            const Rect rect(left, top, left + 1 + static_cast<int>(random() % 10),
+                            top + 1 + static_cast<int>(random() % 10));
+
+            bool anyContained = false;
+            bool allContained = true;
+            for (int y = rect.top; y < rect.bottom; y++) {
+                for (int x = rect.left; x < rect.right; x++) {
+                    const bool contained = scanContains(x, y);
+                    anyContained |= contained;
+                    allContained &= contained;
+                }
+            }
+            EXPECT_EQ(anyContained, r.intersects(rect)) << to_string(rect);
+            EXPECT_EQ(allContained, r.covers(rect)) << to_string(rect);
+        }
+    }
+}
+
+// In-place operations reuse the storage of the region when it is large enough.
+TEST_F(RegionTest, InPlaceOperationsReuseStorage) {
+    Region r;
+    for (int i = 0; i < 16; i++) {
+        r.orSelf(Rect(i * 20, 0, i * 20 + 10, 10));
+    }
+    const Rect* const storage = r.begin();
+
+    r.subtractSelf(Rect(0, 0, 40, 10));
+    EXPECT_EQ(storage, r.begin());
+    EXPECT_EQ(14, r.end() - r.begin());
+
+    r.andSelf(Rect(0, 0, 1000, 5));
+    EXPECT_EQ(storage, r.begin());
+    EXPECT_EQ(14, r.end() - r.begin());
+}
+
 }; // namespace android
 
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include <InputReader.h>
+#include <linux/input-event-codes.h>
+#include "../tests/FakeEventHub.h"
+#include "../tests/FakeInputReaderPolicy.h"
+
+namespace {
+
+// Heap allocations made while gCountAllocations is set, on any thread.
+std::atomic<bool> gCountAllocations{false};
+std::atomic<size_t> gAllocationCount{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (gCountAllocations.load(std::memory_order_relaxed)) {
+        gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace android {
+
+namespace {
+
+constexpr nsecs_t EVENT_INTERVAL = ms2ns(1);
+
+// Gives the benchmarks access to the reader loop without starting the reader thread.
+class BenchmarkInputReader : public InputReader {
+public:
+    BenchmarkInputReader(std::shared_ptr<EventHubInterface> eventHub,
+                         const sp<InputReaderPolicyInterface>& policy,
+                         InputListenerInterface& listener)
+          : InputReader(eventHub, policy, listener) {}
+
+    using InputReader::loopOnce;
+    using InputReader::setParallelDeviceProcessingEnabled;
+};
+
+// Drops every event, but measures how long motions took from their event time to the listener.
+class LatencyInputListener : public InputListenerInterface {
+public:
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs&) override {}
+    void notifyConfigurationChanged(const NotifyConfigurationChangedArgs&) override {}
+    void notifyKey(const NotifyKeyArgs&) override {}
+    void notifyMotion(const NotifyMotionArgs& args) override {
+        mTotalLatency += systemTime(SYSTEM_TIME_MONOTONIC) - args.eventTime;
+        mMotionCount++;
+    }
+    void notifySwitch(const NotifySwitchArgs&) override {}
+    void notifySensor(const NotifySensorArgs&) override {}
+    void notifyVibratorState(const NotifyVibratorStateArgs&) override {}
+    void notifyDeviceReset(const NotifyDeviceResetArgs&) override {}
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs&) override {}
+
+    void reset() {
+        mTotalLatency = 0;
+        mMotionCount = 0;
+    }
+
+    nsecs_t getAverageLatency() const {
+        return mMotionCount == 0 ? 0 : mTotalLatency / static_cast<nsecs_t>(mMotionCount);
+    }
+
+private:
+    nsecs_t mTotalLatency = 0;
+    size_t mMotionCount = 0;
+};
+
+// A reader with the given number of mice attached. The mice are in navigation mode, which needs
+// neither a viewport nor a pointer controller.
+struct ReaderWithMice {
+    explicit ReaderWithMice(int32_t mouseCount)
+          : eventHub(std::make_shared<FakeEventHub>()),
+            policy(sp<FakeInputReaderPolicy>::make()),
+            reader(eventHub, policy, listener),
+            mouseCount(mouseCount) {
+        for (int32_t deviceId = 1; deviceId <= mouseCount; deviceId++) {
+            eventHub->addDevice(deviceId, "mouse " + std::to_string(deviceId),
+                                InputDeviceClass::CURSOR);
+            eventHub->addRelativeAxis(deviceId, REL_X);
+            eventHub->addRelativeAxis(deviceId, REL_Y);
+            eventHub->addConfigurationProperty(deviceId, "cursor.mode", "navigation");
+        }
+        eventHub->finishDeviceScan();
+        reader.loopOnce();
+        reader.loopOnce();
+    }
+
+    // Queues one report from every mouse, as a 1 kHz mouse would deliver every millisecond.
+    void enqueueReports() {
+        enqueueReports(when);
+        when += EVENT_INTERVAL;
+    }
+
+    void enqueueReports(nsecs_t reportTime) {
+        for (int32_t deviceId = 1; deviceId <= mouseCount; deviceId++) {
+            eventHub->enqueueEvent(reportTime, reportTime, deviceId, EV_REL, REL_X, 1);
+            eventHub->enqueueEvent(reportTime, reportTime, deviceId, EV_REL, REL_Y, -1);
+            eventHub->enqueueEvent(reportTime, reportTime, deviceId, EV_SYN, SYN_REPORT, 0);
+        }
+    }
+
+    std::shared_ptr<FakeEventHub> eventHub;
+    sp<FakeInputReaderPolicy> policy;
+    LatencyInputListener listener;
+    BenchmarkInputReader reader;
+    const int32_t mouseCount;
+    nsecs_t when = 0;
+};
+
+} // namespace
+
+// Runs reader loops over reports from several mice, and reports the heap allocations of each
+// loop, from reading the events out of the EventHub to notifying the listener.
+static void benchmarkReaderLoop(benchmark::State& state) {
+    ReaderWithMice setup(state.range(0));
+
+    // Let the reused buffers grow to their steady-state size first.
+    for (int i = 0; i < 10; i++) {
+        setup.enqueueReports();
+        setup.reader.loopOnce();
+    }
+
+    size_t allocations = 0;
+    for (auto _ : state) {
+        setup.enqueueReports();
+
+        gAllocationCount.store(0, std::memory_order_relaxed);
+        gCountAllocations.store(true, std::memory_order_relaxed);
+        setup.reader.loopOnce();
+        gCountAllocations.store(false, std::memory_order_relaxed);
+        allocations += gAllocationCount.load(std::memory_order_relaxed);
+    }
+
+    state.SetItemsProcessed(state.iterations() * setup.mouseCount);
+    state.counters["allocs_per_loop"] =
+            benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    state.counters["allocs_per_report"] =
+            benchmark::Counter(static_cast<double>(allocations) / setup.mouseCount,
+                               benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(benchmarkReaderLoop)->Arg(1)->Arg(4);
+
+// Measures the latency from a report entering the EventHub to its motion reaching the listener,
+// with the mappers of several devices run one after another or in parallel.
+static void benchmarkReaderLatency(benchmark::State& state) {
+    ReaderWithMice setup(state.range(0));
+    setup.reader.setParallelDeviceProcessingEnabled(state.range(1) != 0);
+    for (int i = 0; i < 10; i++) {
+        setup.enqueueReports(systemTime(SYSTEM_TIME_MONOTONIC));
+        setup.reader.loopOnce();
+    }
+
+    setup.listener.reset();
+    for (auto _ : state) {
+        setup.enqueueReports(systemTime(SYSTEM_TIME_MONOTONIC));
+        setup.reader.loopOnce();
+    }
+
+    state.SetItemsProcessed(state.iterations() * setup.mouseCount);
+    state.counters["latency_us"] = ns2us(setup.listener.getAverageLatency());
+}
+BENCHMARK(benchmarkReaderLatency)
+        ->ArgNames({"devices", "parallel"})
+        ->Args({2, 0})
+        ->Args({2, 1})
+        ->Args({8, 0})
+        ->Args({8, 1});
+
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include <InputDevice.h>
+#include <TouchInputMapper.h>
+#include <gmock/gmock.h>
+#include <ui/Transform.h>
+#include "../tests/InterfaceMocks.h"
+
+namespace android {
+
+/**
+ * A TouchInputMapper that is set up like a configured touchscreen directly, so that
+ * cookPointerData can be measured on its own.
+ */
+class CookingTouchInputMapper : public TouchInputMapper {
+public:
+    CookingTouchInputMapper(InputDeviceContext& deviceContext,
+                            const InputReaderConfiguration& readerConfig)
+          : TouchInputMapper(deviceContext, readerConfig) {
+        mCalibration.sizeCalibration = Calibration::SizeCalibration::GEOMETRIC;
+        mCalibration.pressureCalibration = Calibration::PressureCalibration::AMPLITUDE;
+        mCalibration.orientationCalibration = Calibration::OrientationCalibration::INTERPOLATED;
+        mCalibration.distanceCalibration = Calibration::DistanceCalibration::NONE;
+        mRawPointerAxes.touchMajor.valid = true;
+        mRawPointerAxes.touchMinor.valid = true;
+        mRawPointerAxes.toolMajor.valid = true;
+        mRawPointerAxes.toolMinor.valid = true;
+        mGeometricScale = 0.75f;
+        mPressureScale = 1.0f / 255;
+        mSizeScale = 1.0f / 100;
+        mOrientationScale = M_PI_2 / 127;
+        mDistanceScale = 0;
+        mHaveTilt = false;
+        mRawToDisplay = ui::Transform(ui::Transform::ROT_90, 1080, 2400);
+        mRawRotation = ui::Transform{mRawToDisplay.getOrientation()};
+        mSource = AINPUT_SOURCE_TOUCHSCREEN;
+    }
+
+    void setRawPointerData(const RawPointerData& data) {
+        mCurrentRawState.rawPointerData = data;
+    }
+
+    void cook() { cookPointerData(); }
+
+protected:
+    bool hasStylus() const override { return false; }
+    void syncTouch(nsecs_t, RawState*) override {}
+};
+
+namespace {
+
+constexpr int32_t DEVICE_ID = END_RESERVED_ID + 1000;
+constexpr int32_t EVENTHUB_ID = 1;
+
+// One second of frames from a 240 Hz touchscreen.
+constexpr size_t FRAME_COUNT = 240;
+
+// Fingers moving around circles, each one a little out of phase with the others.
+std::vector<RawPointerData> makeFrames(uint32_t pointerCount) {
+    std::vector<RawPointerData> frames(FRAME_COUNT);
+    for (size_t frame = 0; frame < FRAME_COUNT; frame++) {
+        RawPointerData& data = frames[frame];
+        data.pointerCount = pointerCount;
+        for (uint32_t i = 0; i < pointerCount; i++) {
+            const float angle = 2 * M_PI * (frame + i * 24) / FRAME_COUNT;
+            RawPointerData::Pointer& pointer = data.pointers[i];
+            pointer.id = i;
+            pointer.x = 540 + 100 * i * cosf(angle);
+            pointer.y = 1200 + 100 * i * sinf(angle);
+            pointer.pressure = 100 + i;
+            pointer.touchMajor = 30 + i;
+            pointer.touchMinor = 20 + i;
+            pointer.toolMajor = 40 + i;
+            pointer.toolMinor = 30 + i;
+            pointer.orientation = (frame + i) % 128;
+            pointer.toolType = ToolType::FINGER;
+            data.markIdBit(i, /*isHovering=*/false);
+            data.idToIndex[i] = i;
+        }
+    }
+    return frames;
+}
+
+} // namespace
+
+static void benchmarkCookPointerData(benchmark::State& state) {
+    testing::NiceMock<MockInputReaderContext> readerContext;
+    InputDeviceIdentifier identifier;
+    InputDevice device(&readerContext, DEVICE_ID, /*generation=*/2, identifier);
+    device.addEmptyEventHubDevice(EVENTHUB_ID);
+    InputDeviceContext deviceContext(device, EVENTHUB_ID);
+    InputReaderConfiguration readerConfig;
+    CookingTouchInputMapper mapper(deviceContext, readerConfig);
+
+    const std::vector<RawPointerData> frames = makeFrames(state.range(0));
+    for (auto _ : state) {
+        for (const RawPointerData& frame : frames) {
+            mapper.setRawPointerData(frame);
+            mapper.cook();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * frames.size());
+}
+BENCHMARK(benchmarkCookPointerData)->Arg(1)->Arg(10);
+
+} // namespace android
+
+BENCHMARK_MAIN();
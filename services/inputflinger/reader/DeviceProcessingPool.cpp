@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DeviceProcessingPool.h"
+
+#include <android-base/stringprintf.h>
+
+namespace android {
+
+DeviceProcessingPool::DeviceProcessingPool(size_t threadCount) {
+    for (size_t i = 0; i < threadCount; i++) {
+        mThreads.push_back(
+                std::make_unique<InputThread>(base::StringPrintf("InputReaderDev%zu", i),
+                                              [this]() { loopOnce(); }, [this]() { stop(); }));
+    }
+}
+
+DeviceProcessingPool::~DeviceProcessingPool() {
+    mThreads.clear();
+}
+
+void DeviceProcessingPool::stop() {
+    std::scoped_lock lock(mLock);
+    mStopping = true;
+    mTaskAvailableCondition.notify_all();
+}
+
+bool DeviceProcessingPool::hasTaskLocked() const {
+    return mTasks != nullptr && mNextTask < mTasks->size();
+}
+
+void DeviceProcessingPool::loopOnce() {
+    {
+        std::unique_lock lock(mLock);
+        base::ScopedLockAssertion assumeLocked(mLock);
+        mTaskAvailableCondition.wait(lock, [this]() REQUIRES(mLock) {
+            return mStopping || hasTaskLocked();
+        });
+        if (mStopping) {
+            return;
+        }
+    }
+    runTasks();
+}
+
+void DeviceProcessingPool::runTasks() {
+    for (;;) {
+        std::function<void()>* task;
+        {
+            std::scoped_lock lock(mLock);
+            if (!hasTaskLocked()) {
+                return;
+            }
+            task = &(*mTasks)[mNextTask++];
+        }
+
+        (*task)();
+
+        std::scoped_lock lock(mLock);
+        if (--mRemainingTasks == 0) {
+            mTasksDoneCondition.notify_all();
+        }
+    }
+}
+
+void DeviceProcessingPool::run(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mLock);
+        mTasks = &tasks;
+        mNextTask = 0;
+        mRemainingTasks = tasks.size();
+        mTaskAvailableCondition.notify_all();
+    }
+
+    // Rather than sleeping until the pool is done, the calling thread runs tasks as well.
+    runTasks();
+
+    std::unique_lock lock(mLock);
+    base::ScopedLockAssertion assumeLocked(mLock);
+    mTasksDoneCondition.wait(lock, [this]() REQUIRES(mLock) { return mRemainingTasks == 0; });
+    mTasks = nullptr;
+}
+
+} // namespace android
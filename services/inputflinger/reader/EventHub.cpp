@@ -1845,11 +1845,17 @@ std::optional<int32_t> EventHub::getBatteryStatus(int32_t deviceId, int32_t batt
 }
 
 std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
+    std::vector<RawEvent> events;
+    getEventsInto(timeoutMillis, events);
+    return events;
+}
+
+void EventHub::getEventsInto(int timeoutMillis, std::vector<RawEvent>& events) {
     std::scoped_lock _l(mLock);
 
     std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
 
-    std::vector<RawEvent> events;
+    events.clear();
     bool awoken = false;
     for (;;) {
         nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
@@ -2103,9 +2109,6 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             mPendingEventCount = size_t(pollResult);
         }
     }
-
-    // All done, return the number of events we read.
-    return events;
 }
 
 std::vector<TouchVideoFrame> EventHub::getVideoFrames(int32_t deviceId) {
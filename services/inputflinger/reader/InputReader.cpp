@@ -18,6 +18,7 @@
 
 #include "InputReader.h"
 
+#include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <errno.h>
 #include <input/Keyboard.h>
@@ -38,6 +39,11 @@ using android::base::StringPrintf;
 
 namespace android {
 
+// Number of threads that process device events alongside the reader thread when parallel device
+// processing is enabled. Together they cover a touchscreen, a stylus, a touchpad and a gamepad
+// reporting at the same time.
+static constexpr size_t PARALLEL_DEVICE_PROCESSING_THREADS = 3;
+
 /**
  * Determines if the identifiers passed are a sub-devices. Sub-devices are physical devices
  * that expose multiple input device paths such a keyboard that also has a touchpad input.
@@ -69,6 +75,18 @@ static bool isStylusPointerGestureStart(const NotifyMotionArgs& motionArgs) {
     return isStylusToolType(motionArgs.pointerProperties[actionIndex].toolType);
 }
 
+/**
+ * Determines if the events of a device can be processed at the same time as those of other
+ * devices. Keyboards update the meta state and the typing state that the mappers of other devices
+ * read, and external styluses push their state into the mappers of other devices. The events of
+ * these devices are processed while no other device is being processed.
+ */
+static bool canProcessInParallel(const InputDevice& device) {
+    using namespace ftl::flag_operators;
+    return !device.getClasses().any(InputDeviceClass::KEYBOARD |
+                                     InputDeviceClass::EXTERNAL_STYLUS);
+}
+
 // --- InputReader ---
 
 InputReader::InputReader(std::shared_ptr<EventHubInterface> eventHub,
@@ -87,6 +105,11 @@ InputReader::InputReader(std::shared_ptr<EventHubInterface> eventHub,
         mConfigurationChangesToRefresh(0) {
     refreshConfigurationLocked(/*changes=*/{});
     updateGlobalMetaStateLocked();
+    // Parallel device processing is experimental and has no release flag yet, so it can only be
+    // turned on for testing on debuggable builds.
+    setParallelDeviceProcessingEnabled(
+            base::GetBoolProperty("ro.debuggable", false) &&
+            base::GetBoolProperty("debug.input.parallel_device_processing", false));
 }
 
 InputReader::~InputReader() {}
@@ -133,14 +156,14 @@ void InputReader::loopOnce() {
         }
     } // release lock
 
-    std::vector<RawEvent> events = mEventHub->getEvents(timeoutMillis);
+    mEventHub->getEventsInto(timeoutMillis, mEventBuffer);
 
     { // acquire lock
         std::scoped_lock _l(mLock);
         mReaderIsAliveCondition.notify_all();
 
-        if (!events.empty()) {
-            mPendingArgs += processEventsLocked(events.data(), events.size());
+        if (!mEventBuffer.empty()) {
+            mPendingArgs += processEventsLocked(mEventBuffer.data(), mEventBuffer.size());
         }
 
         if (mNextTimeout != LLONG_MAX) {
@@ -191,12 +214,30 @@ void InputReader::loopOnce() {
     }
 }
 
+void InputReader::setParallelDeviceProcessingEnabled(bool enabled) {
+    std::scoped_lock _l(mLock);
+    if (!enabled) {
+        mDeviceProcessingPool.reset();
+    } else if (!mDeviceProcessingPool) {
+        mDeviceProcessingPool =
+                std::make_unique<DeviceProcessingPool>(PARALLEL_DEVICE_PROCESSING_THREADS);
+    }
+}
+
 std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count) {
     std::list<NotifyArgs> out;
     for (const RawEvent* rawEvent = rawEvents; count;) {
         int32_t type = rawEvent->type;
         size_t batchSize = 1;
-        if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
+        if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT && mDeviceProcessingPool) {
+            // Take all of the device events up to the next device change, and let the devices
+            // process them at the same time.
+            while (batchSize < count &&
+                   rawEvent[batchSize].type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
+                batchSize += 1;
+            }
+            out += processEventsForDevicesInParallelLocked(rawEvent, batchSize);
+        } else if (type < EventHubInterface::FIRST_SYNTHETIC_EVENT) {
             int32_t deviceId = rawEvent->deviceId;
             while (batchSize < count) {
                 if (rawEvent[batchSize].type >= EventHubInterface::FIRST_SYNTHETIC_EVENT ||
@@ -358,6 +399,87 @@ std::list<NotifyArgs> InputReader::processEventsForDeviceLocked(int32_t eventHub
     return device->process(rawEvents, count);
 }
 
+std::list<NotifyArgs> InputReader::processEventsForDevicesInParallelLocked(
+        const RawEvent* rawEvents, size_t count) {
+    // The events are split into batches per device just like processEventsLocked does. Each batch
+    // keeps its own output, and the outputs are concatenated in batch order at the end. The
+    // listener therefore sees the same sequence of events as when processing serially.
+    struct Batch {
+        InputDevice* device;
+        const RawEvent* rawEvents;
+        size_t count;
+        std::list<NotifyArgs> out;
+    };
+    std::vector<Batch> batches;
+    for (const RawEvent* rawEvent = rawEvents; count;) {
+        const int32_t eventHubId = rawEvent->deviceId;
+        size_t batchSize = 1;
+        while (batchSize < count && rawEvent[batchSize].deviceId == eventHubId) {
+            batchSize += 1;
+        }
+
+        auto deviceIt = mDevices.find(eventHubId);
+        if (deviceIt == mDevices.end()) {
+            ALOGW("Discarding event for unknown eventHubId %d.", eventHubId);
+        } else if (!deviceIt->second->isIgnored()) {
+            batches.push_back({deviceIt->second.get(), rawEvent, batchSize, {}});
+        }
+        count -= batchSize;
+        rawEvent += batchSize;
+    }
+
+    // Runs the batches in [begin, end), which belong to devices that can be processed in
+    // parallel. Several sub-devices can make up one InputDevice, so the batches are grouped by
+    // InputDevice, and each group is processed in order by a single thread.
+    auto processInParallel = [this](auto begin, auto end) REQUIRES(mLock) {
+        std::vector<std::vector<Batch*>> groups;
+        for (auto it = begin; it != end; it++) {
+            auto groupIt = std::find_if(groups.begin(), groups.end(), [&](const auto& group) {
+                return group.front()->device == it->device;
+            });
+            if (groupIt == groups.end()) {
+                groups.push_back({&*it});
+            } else {
+                groupIt->push_back(&*it);
+            }
+        }
+        if (groups.size() == 1) {
+            for (Batch* batch : groups.front()) {
+                batch->out = batch->device->process(batch->rawEvents, batch->count);
+            }
+            return;
+        }
+
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(groups.size());
+        for (const auto& group : groups) {
+            tasks.push_back([&group]() {
+                for (Batch* batch : group) {
+                    batch->out = batch->device->process(batch->rawEvents, batch->count);
+                }
+            });
+        }
+        mDeviceProcessingPool->run(tasks);
+    };
+
+    auto parallelBegin = batches.begin();
+    for (auto it = batches.begin(); it != batches.end(); it++) {
+        if (canProcessInParallel(*it->device)) {
+            continue;
+        }
+        processInParallel(parallelBegin, it);
+        it->out = it->device->process(it->rawEvents, it->count);
+        parallelBegin = std::next(it);
+    }
+    processInParallel(parallelBegin, batches.end());
+
+    std::list<NotifyArgs> out;
+    for (Batch& batch : batches) {
+        out += std::move(batch.out);
+    }
+    return out;
+}
+
 InputDevice* InputReader::findInputDeviceLocked(int32_t deviceId) const {
     auto deviceIt =
             std::find_if(mDevices.begin(), mDevices.end(), [deviceId](const auto& devicePair) {
@@ -1020,81 +1142,97 @@ InputReader::ContextImpl::ContextImpl(InputReader* reader)
 
 void InputReader::ContextImpl::updateGlobalMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->updateGlobalMetaStateLocked();
 }
 
 int32_t InputReader::ContextImpl::getGlobalMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->getGlobalMetaStateLocked();
 }
 
 void InputReader::ContextImpl::updateLedMetaState(int32_t metaState) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->updateLedMetaStateLocked(metaState);
 }
 
 int32_t InputReader::ContextImpl::getLedMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->getLedMetaStateLocked();
 }
 
 void InputReader::ContextImpl::setPreventingTouchpadTaps(bool prevent) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->mPreventingTouchpadTaps = prevent;
 }
 
 bool InputReader::ContextImpl::isPreventingTouchpadTaps() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->mPreventingTouchpadTaps;
 }
 
 void InputReader::ContextImpl::setLastKeyDownTimestamp(nsecs_t when) {
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->mLastKeyDownTimestamp = when;
 }
 
 nsecs_t InputReader::ContextImpl::getLastKeyDownTimestamp() {
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->mLastKeyDownTimestamp;
 }
 
 void InputReader::ContextImpl::disableVirtualKeysUntil(nsecs_t time) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->disableVirtualKeysUntilLocked(time);
 }
 
 bool InputReader::ContextImpl::shouldDropVirtualKey(nsecs_t now, int32_t keyCode,
                                                     int32_t scanCode) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->shouldDropVirtualKeyLocked(now, keyCode, scanCode);
 }
 
 void InputReader::ContextImpl::fadePointer() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->fadePointerLocked();
 }
 
 std::shared_ptr<PointerControllerInterface> InputReader::ContextImpl::getPointerController(
         int32_t deviceId) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->getPointerControllerLocked(deviceId);
 }
 
 void InputReader::ContextImpl::requestTimeoutAtTime(nsecs_t when) {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->requestTimeoutAtTimeLocked(when);
 }
 
 int32_t InputReader::ContextImpl::bumpGeneration() {
     // lock is already held by the input loop
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->bumpGenerationLocked();
 }
 
 void InputReader::ContextImpl::getExternalStylusDevices(std::vector<InputDeviceInfo>& outDevices) {
     // lock is already held by whatever called refreshConfigurationLocked
+    std::scoped_lock lock(mReader->mParallelContextLock);
     mReader->getExternalStylusDevicesLocked(outDevices);
 }
 
 std::list<NotifyArgs> InputReader::ContextImpl::dispatchExternalStylusState(
         const StylusState& state) {
+    std::scoped_lock lock(mReader->mParallelContextLock);
     return mReader->dispatchExternalStylusStateLocked(state);
 }
 
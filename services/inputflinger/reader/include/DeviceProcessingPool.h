@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "InputThread.h"
+
+namespace android {
+
+/*
+ * A fixed set of threads that the InputReader uses to run the mappers of independent input
+ * devices at the same time.
+ *
+ * The threads are started once and then sleep until there is work, so handing a batch of events
+ * to them does not create any threads. The thread that calls run() also takes part in running
+ * the tasks, and run() only returns once all of them are done.
+ */
+class DeviceProcessingPool {
+public:
+    explicit DeviceProcessingPool(size_t threadCount);
+    ~DeviceProcessingPool();
+
+    DeviceProcessingPool(const DeviceProcessingPool&) = delete;
+    DeviceProcessingPool& operator=(const DeviceProcessingPool&) = delete;
+
+    // Runs all of the tasks, in no particular order, and waits for them to finish.
+    void run(std::vector<std::function<void()>>& tasks);
+
+private:
+    std::mutex mLock;
+    std::condition_variable mTaskAvailableCondition;
+    std::condition_variable mTasksDoneCondition;
+    std::vector<std::function<void()>>* mTasks GUARDED_BY(mLock) = nullptr;
+    size_t mNextTask GUARDED_BY(mLock) = 0;
+    size_t mRemainingTasks GUARDED_BY(mLock) = 0;
+    bool mStopping GUARDED_BY(mLock) = false;
+
+    std::vector<std::unique_ptr<InputThread>> mThreads;
+
+    void loopOnce();
+    void stop();
+    bool hasTaskLocked() const REQUIRES(mLock);
+    // Runs the tasks that have not been taken by another thread yet.
+    void runTasks();
+};
+
+} // namespace android
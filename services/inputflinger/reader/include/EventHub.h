@@ -308,6 +308,16 @@ public:
      * Returns the number of events obtained, or 0 if the timeout expired.
      */
     virtual std::vector<RawEvent> getEvents(int timeoutMillis) = 0;
+
+    /*
+     * Same as getEvents(int), but replaces the contents of outEvents with the events obtained
+     * instead of returning a new vector. Passing the same vector on every call reuses its
+     * storage, so polling does not allocate once the vector has grown to the largest batch.
+     */
+    virtual void getEventsInto(int timeoutMillis, std::vector<RawEvent>& outEvents) {
+        outEvents = getEvents(timeoutMillis);
+    }
+
     virtual std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) = 0;
     virtual base::Result<std::pair<InputDeviceSensorType, int32_t>> mapSensor(
             int32_t deviceId, int32_t absCode) const = 0;
@@ -563,6 +573,7 @@ public:
                                uint8_t* outFlags) const override final;
 
     std::vector<RawEvent> getEvents(int timeoutMillis) override final;
+    void getEventsInto(int timeoutMillis, std::vector<RawEvent>& outEvents) override final;
     std::vector<TouchVideoFrame> getVideoFrames(int32_t deviceId) override final;
 
     bool hasScanCode(int32_t deviceId, int32_t scanCode) const override final;
@@ -25,6 +25,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "DeviceProcessingPool.h"
 #include "EventHub.h"
 #include "InputListener.h"
 #include "InputReaderBase.h"
@@ -129,6 +130,9 @@ protected:
     // the EventHub.
     void loopOnce();
 
+    // Enables running the mappers of independent devices on separate threads.
+    void setParallelDeviceProcessingEnabled(bool enabled);
+
     class ContextImpl : public InputReaderContext {
         InputReader* mReader;
         IdGenerator mIdGenerator;
@@ -186,6 +190,19 @@ private:
     // sent to the 'mNextListener' without holding the lock.
     std::list<NotifyArgs> mPendingArgs GUARDED_BY(mLock);
 
+    // When set, the events of devices that do not affect each other are processed on these
+    // threads, one thread per device at a time.
+    std::unique_ptr<DeviceProcessingPool> mDeviceProcessingPool GUARDED_BY(mLock);
+
+    // Serializes the context calls that reach reader state while devices are processed in
+    // parallel. It is recursive because some of these calls reach back into the mappers, such as
+    // updateLedMetaState, which has the keyboard mappers read the LED meta state.
+    std::recursive_mutex mParallelContextLock;
+
+    // The raw events read from the EventHub by the last loopOnce. This is only used by the reader
+    // thread, and is kept between loops so that reading events reuses its storage.
+    std::vector<RawEvent> mEventBuffer;
+
     InputReaderConfiguration mConfig GUARDED_BY(mLock);
 
     // An input device can represent a collection of EventHub devices. This map provides a way
@@ -213,6 +230,8 @@ private:
     [[nodiscard]] std::list<NotifyArgs> processEventsForDeviceLocked(int32_t eventHubId,
                                                                      const RawEvent* rawEvents,
                                                                      size_t count) REQUIRES(mLock);
+    [[nodiscard]] std::list<NotifyArgs> processEventsForDevicesInParallelLocked(
+            const RawEvent* rawEvents, size_t count) REQUIRES(mLock);
     [[nodiscard]] std::list<NotifyArgs> timeoutExpiredLocked(nsecs_t when) REQUIRES(mLock);
 
     void handleConfigurationChangedLocked(nsecs_t when) REQUIRES(mLock);
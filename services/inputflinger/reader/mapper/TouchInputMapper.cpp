@@ -2301,177 +2301,212 @@ void TouchInputMapper::cookPointerData() {
         mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
     }
 
-    // Walk through the the active pointers and map device coordinates onto
-    // display coordinates and adjust for display orientation.
-    for (uint32_t i = 0; i < currentPointerCount; i++) {
-        const RawPointerData::Pointer& in = mCurrentRawState.rawPointerData.pointers[i];
-
-        // Size
-        float touchMajor, touchMinor, toolMajor, toolMinor, size;
-        switch (mCalibration.sizeCalibration) {
-            case Calibration::SizeCalibration::GEOMETRIC:
-            case Calibration::SizeCalibration::DIAMETER:
-            case Calibration::SizeCalibration::BOX:
-            case Calibration::SizeCalibration::AREA:
-                if (mRawPointerAxes.touchMajor.valid && mRawPointerAxes.toolMajor.valid) {
-                    touchMajor = in.touchMajor;
-                    touchMinor = mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
-                    toolMajor = in.toolMajor;
-                    toolMinor = mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
-                    size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
-                                                            : in.touchMajor;
-                } else if (mRawPointerAxes.touchMajor.valid) {
-                    toolMajor = touchMajor = in.touchMajor;
-                    toolMinor = touchMinor =
-                            mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
-                    size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
-                                                            : in.touchMajor;
-                } else if (mRawPointerAxes.toolMajor.valid) {
-                    touchMajor = toolMajor = in.toolMajor;
-                    touchMinor = toolMinor =
-                            mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
-                    size = mRawPointerAxes.toolMinor.valid ? avg(in.toolMajor, in.toolMinor)
-                                                           : in.toolMajor;
-                } else {
-                    ALOG_ASSERT(false,
-                                "No touch or tool axes.  "
-                                "Size calibration should have been resolved to NONE.");
-                    touchMajor = 0;
-                    touchMinor = 0;
-                    toolMajor = 0;
-                    toolMinor = 0;
-                    size = 0;
+    // Each axis is cooked for all of the active pointers before moving on to the next one. The
+    // calibration of an axis is the same for every pointer, so it is only looked at once per
+    // frame rather than once per pointer. The arithmetic for each pointer is unchanged.
+    const RawPointerData::Pointer* pointers = mCurrentRawState.rawPointerData.pointers.data();
+    std::array<float, MAX_POINTERS> touchMajor, touchMinor, toolMajor, toolMinor, size;
+    std::array<float, MAX_POINTERS> pressure, tilt, orientation, distance;
+    std::array<vec2, MAX_POINTERS> transformed;
+
+    // Size
+    switch (mCalibration.sizeCalibration) {
+        case Calibration::SizeCalibration::GEOMETRIC:
+        case Calibration::SizeCalibration::DIAMETER:
+        case Calibration::SizeCalibration::BOX:
+        case Calibration::SizeCalibration::AREA: {
+            const bool haveTouchMinor = mRawPointerAxes.touchMinor.valid;
+            const bool haveToolMinor = mRawPointerAxes.toolMinor.valid;
+            if (mRawPointerAxes.touchMajor.valid && mRawPointerAxes.toolMajor.valid) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    const RawPointerData::Pointer& in = pointers[i];
+                    touchMajor[i] = in.touchMajor;
+                    touchMinor[i] = haveTouchMinor ? in.touchMinor : in.touchMajor;
+                    toolMajor[i] = in.toolMajor;
+                    toolMinor[i] = haveToolMinor ? in.toolMinor : in.toolMajor;
+                    size[i] = haveTouchMinor ? avg(in.touchMajor, in.touchMinor) : in.touchMajor;
                 }
+            } else if (mRawPointerAxes.touchMajor.valid) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    const RawPointerData::Pointer& in = pointers[i];
+                    toolMajor[i] = touchMajor[i] = in.touchMajor;
+                    toolMinor[i] = touchMinor[i] = haveTouchMinor ? in.touchMinor : in.touchMajor;
+                    size[i] = haveTouchMinor ? avg(in.touchMajor, in.touchMinor) : in.touchMajor;
+                }
+            } else if (mRawPointerAxes.toolMajor.valid) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    const RawPointerData::Pointer& in = pointers[i];
+                    touchMajor[i] = toolMajor[i] = in.toolMajor;
+                    touchMinor[i] = toolMinor[i] = haveToolMinor ? in.toolMinor : in.toolMajor;
+                    size[i] = haveToolMinor ? avg(in.toolMajor, in.toolMinor) : in.toolMajor;
+                }
+            } else {
+                ALOG_ASSERT(false,
+                            "No touch or tool axes.  "
+                            "Size calibration should have been resolved to NONE.");
+                touchMajor.fill(0);
+                touchMinor.fill(0);
+                toolMajor.fill(0);
+                toolMinor.fill(0);
+                size.fill(0);
+            }
 
-                if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
-                    uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
-                    if (touchingCount > 1) {
-                        touchMajor /= touchingCount;
-                        touchMinor /= touchingCount;
-                        toolMajor /= touchingCount;
-                        toolMinor /= touchingCount;
-                        size /= touchingCount;
+            if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
+                uint32_t touchingCount = mCurrentRawState.rawPointerData.touchingIdBits.count();
+                if (touchingCount > 1) {
+                    for (uint32_t i = 0; i < currentPointerCount; i++) {
+                        touchMajor[i] /= touchingCount;
+                        touchMinor[i] /= touchingCount;
+                        toolMajor[i] /= touchingCount;
+                        toolMinor[i] /= touchingCount;
+                        size[i] /= touchingCount;
                     }
                 }
+            }
 
-                if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
-                    touchMajor *= mGeometricScale;
-                    touchMinor *= mGeometricScale;
-                    toolMajor *= mGeometricScale;
-                    toolMinor *= mGeometricScale;
-                } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::AREA) {
-                    touchMajor = touchMajor > 0 ? sqrtf(touchMajor) : 0;
-                    touchMinor = touchMajor;
-                    toolMajor = toolMajor > 0 ? sqrtf(toolMajor) : 0;
-                    toolMinor = toolMajor;
-                } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::DIAMETER) {
-                    touchMinor = touchMajor;
-                    toolMinor = toolMajor;
+            if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    touchMajor[i] *= mGeometricScale;
+                    touchMinor[i] *= mGeometricScale;
+                    toolMajor[i] *= mGeometricScale;
+                    toolMinor[i] *= mGeometricScale;
+                }
+            } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::AREA) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    touchMajor[i] = touchMajor[i] > 0 ? sqrtf(touchMajor[i]) : 0;
+                    touchMinor[i] = touchMajor[i];
+                    toolMajor[i] = toolMajor[i] > 0 ? sqrtf(toolMajor[i]) : 0;
+                    toolMinor[i] = toolMajor[i];
                 }
+            } else if (mCalibration.sizeCalibration == Calibration::SizeCalibration::DIAMETER) {
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    touchMinor[i] = touchMajor[i];
+                    toolMinor[i] = toolMajor[i];
+                }
+            }
 
-                mCalibration.applySizeScaleAndBias(touchMajor);
-                mCalibration.applySizeScaleAndBias(touchMinor);
-                mCalibration.applySizeScaleAndBias(toolMajor);
-                mCalibration.applySizeScaleAndBias(toolMinor);
-                size *= mSizeScale;
-                break;
-            case Calibration::SizeCalibration::DEFAULT:
-                LOG_ALWAYS_FATAL("Resolution should not be 'DEFAULT' at this point");
-                break;
-            case Calibration::SizeCalibration::NONE:
-                touchMajor = 0;
-                touchMinor = 0;
-                toolMajor = 0;
-                toolMinor = 0;
-                size = 0;
-                break;
+            for (uint32_t i = 0; i < currentPointerCount; i++) {
+                mCalibration.applySizeScaleAndBias(touchMajor[i]);
+                mCalibration.applySizeScaleAndBias(touchMinor[i]);
+                mCalibration.applySizeScaleAndBias(toolMajor[i]);
+                mCalibration.applySizeScaleAndBias(toolMinor[i]);
+                size[i] *= mSizeScale;
+            }
+            break;
         }
+        case Calibration::SizeCalibration::DEFAULT:
+            LOG_ALWAYS_FATAL("Resolution should not be 'DEFAULT' at this point");
+            break;
+        case Calibration::SizeCalibration::NONE:
+            touchMajor.fill(0);
+            touchMinor.fill(0);
+            toolMajor.fill(0);
+            toolMinor.fill(0);
+            size.fill(0);
+            break;
+    }
 
-        // Pressure
-        float pressure;
-        switch (mCalibration.pressureCalibration) {
-            case Calibration::PressureCalibration::PHYSICAL:
-            case Calibration::PressureCalibration::AMPLITUDE:
-                pressure = in.pressure * mPressureScale;
-                break;
-            default:
-                pressure = in.isHovering ? 0 : 1;
-                break;
-        }
+    // Pressure
+    switch (mCalibration.pressureCalibration) {
+        case Calibration::PressureCalibration::PHYSICAL:
+        case Calibration::PressureCalibration::AMPLITUDE:
+            for (uint32_t i = 0; i < currentPointerCount; i++) {
+                pressure[i] = pointers[i].pressure * mPressureScale;
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < currentPointerCount; i++) {
+                pressure[i] = pointers[i].isHovering ? 0 : 1;
+            }
+            break;
+    }
 
-        // Tilt and Orientation
-        float tilt;
-        float orientation;
-        if (mHaveTilt) {
+    // Tilt and Orientation
+    if (mHaveTilt) {
+        for (uint32_t i = 0; i < currentPointerCount; i++) {
+            const RawPointerData::Pointer& in = pointers[i];
             float tiltXAngle = (in.tiltX - mTiltXCenter) * mTiltXScale;
             float tiltYAngle = (in.tiltY - mTiltYCenter) * mTiltYScale;
-            orientation = transformAngle(mRawRotation, atan2f(-sinf(tiltXAngle), sinf(tiltYAngle)));
-            tilt = acosf(cosf(tiltXAngle) * cosf(tiltYAngle));
-        } else {
-            tilt = 0;
+            orientation[i] =
+                    transformAngle(mRawRotation, atan2f(-sinf(tiltXAngle), sinf(tiltYAngle)));
+            tilt[i] = acosf(cosf(tiltXAngle) * cosf(tiltYAngle));
+        }
+    } else {
+        tilt.fill(0);
 
-            switch (mCalibration.orientationCalibration) {
-                case Calibration::OrientationCalibration::INTERPOLATED:
-                    orientation = transformAngle(mRawRotation, in.orientation * mOrientationScale);
-                    break;
-                case Calibration::OrientationCalibration::VECTOR: {
-                    int32_t c1 = signExtendNybble((in.orientation & 0xf0) >> 4);
-                    int32_t c2 = signExtendNybble(in.orientation & 0x0f);
+        switch (mCalibration.orientationCalibration) {
+            case Calibration::OrientationCalibration::INTERPOLATED:
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    orientation[i] = transformAngle(mRawRotation,
+                                                    pointers[i].orientation * mOrientationScale);
+                }
+                break;
+            case Calibration::OrientationCalibration::VECTOR:
+                for (uint32_t i = 0; i < currentPointerCount; i++) {
+                    int32_t c1 = signExtendNybble((pointers[i].orientation & 0xf0) >> 4);
+                    int32_t c2 = signExtendNybble(pointers[i].orientation & 0x0f);
                     if (c1 != 0 || c2 != 0) {
-                        orientation = transformAngle(mRawRotation, atan2f(c1, c2) * 0.5f);
+                        orientation[i] = transformAngle(mRawRotation, atan2f(c1, c2) * 0.5f);
                         float confidence = hypotf(c1, c2);
                         float scale = 1.0f + confidence / 16.0f;
-                        touchMajor *= scale;
-                        touchMinor /= scale;
-                        toolMajor *= scale;
-                        toolMinor /= scale;
+                        touchMajor[i] *= scale;
+                        touchMinor[i] /= scale;
+                        toolMajor[i] *= scale;
+                        toolMinor[i] /= scale;
                     } else {
-                        orientation = 0;
+                        orientation[i] = 0;
                     }
-                    break;
                 }
-                default:
-                    orientation = 0;
-            }
-        }
-
-        // Distance
-        float distance;
-        switch (mCalibration.distanceCalibration) {
-            case Calibration::DistanceCalibration::SCALED:
-                distance = in.distance * mDistanceScale;
                 break;
             default:
-                distance = 0;
+                orientation.fill(0);
         }
+    }
+
+    // Distance
+    switch (mCalibration.distanceCalibration) {
+        case Calibration::DistanceCalibration::SCALED:
+            for (uint32_t i = 0; i < currentPointerCount; i++) {
+                distance[i] = pointers[i].distance * mDistanceScale;
+            }
+            break;
+        default:
+            distance.fill(0);
+    }
 
-        // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
-        vec2 transformed = {in.x, in.y};
-        mAffineTransform.applyTo(transformed.x /*byRef*/, transformed.y /*byRef*/);
-        transformed = mRawToDisplay.transform(transformed);
+    // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
+    for (uint32_t i = 0; i < currentPointerCount; i++) {
+        transformed[i] = {pointers[i].x, pointers[i].y};
+        mAffineTransform.applyTo(transformed[i].x /*byRef*/, transformed[i].y /*byRef*/);
+        transformed[i] = mRawToDisplay.transform(transformed[i]);
+    }
+
+    for (uint32_t i = 0; i < currentPointerCount; i++) {
+        const RawPointerData::Pointer& in = pointers[i];
 
-        // Write output coords.
+        // Write output coords. The axes are set in increasing order so that storing each one
+        // appends to the end of the coords instead of shifting the values already stored.
         PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
         out.clear();
-        out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed.x);
-        out.setAxisValue(AMOTION_EVENT_AXIS_Y, transformed.y);
-        out.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, pressure);
-        out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
-        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
+        out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed[i].x);
+        out.setAxisValue(AMOTION_EVENT_AXIS_Y, transformed[i].y);
+        out.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, pressure[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance[i]);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt[i]);
 
         // Write output relative fields if applicable.
         uint32_t id = in.id;
         if (mSource == AINPUT_SOURCE_TOUCHPAD &&
             mLastCookedState.cookedPointerData.hasPointerCoordsForId(id)) {
             const PointerCoords& p = mLastCookedState.cookedPointerData.pointerCoordsForId(id);
-            float dx = transformed.x - p.getAxisValue(AMOTION_EVENT_AXIS_X);
-            float dy = transformed.y - p.getAxisValue(AMOTION_EVENT_AXIS_Y);
+            float dx = transformed[i].x - p.getAxisValue(AMOTION_EVENT_AXIS_X);
+            float dy = transformed[i].y - p.getAxisValue(AMOTION_EVENT_AXIS_Y);
             out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X, dx);
             out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y, dy);
         }
@@ -398,6 +398,9 @@ protected:
 
     virtual void syncTouch(nsecs_t when, RawState* outState) = 0;
 
+    // Sets up the calibration directly, so that cookPointerData can be tested and benchmarked.
+    friend class CookingTouchInputMapper;
+
 private:
     // The current viewport.
     // The components of the viewport are specified in the display's rotated orientation.
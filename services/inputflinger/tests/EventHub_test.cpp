@@ -218,6 +218,31 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+/**
+ * Ensure that reading events into a vector replaces its previous contents, and that all of the
+ * events are delivered the same way as when a new vector is returned.
+ */
+TEST_F(EventHubTest, GetEventsInto_ReplacesPreviousEvents) {
+    std::vector<RawEvent> events(8, RawEvent{.type = EventHubInterface::FINISHED_DEVICE_SCAN});
+    ASSERT_NO_FATAL_FAILURE(mKeyboard->pressAndReleaseHomeKey());
+
+    std::vector<RawEvent> received;
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (received.size() < 4 && std::chrono::steady_clock::now() < deadline) {
+        mEventHub->getEventsInto(std::chrono::milliseconds(2s).count(), events);
+        for (const RawEvent& event : events) {
+            ASSERT_EQ(mDeviceId, event.deviceId);
+            ASSERT_NE(static_cast<int32_t>(EventHubInterface::FINISHED_DEVICE_SCAN), event.type);
+        }
+        received.insert(received.end(), events.begin(), events.end());
+    }
+    ASSERT_EQ(4U, received.size()) << "Expected to receive 2 keys and 2 syncs, total of 4 events";
+    EXPECT_EQ(EV_KEY, received[0].type);
+    EXPECT_EQ(EV_SYN, received[1].type);
+    EXPECT_EQ(EV_KEY, received[2].type);
+    EXPECT_EQ(EV_SYN, received[3].type);
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
@@ -369,6 +369,17 @@ std::vector<RawEvent> FakeEventHub::getEvents(int) {
     return buffer;
 }
 
+void FakeEventHub::getEventsInto(int, std::vector<RawEvent>& outEvents) {
+    std::scoped_lock lock(mLock);
+
+    // Hand the caller's storage back to the queue, so that neither side allocates once both
+    // vectors have grown to the largest batch.
+    outEvents.clear();
+    std::swap(outEvents, mEvents);
+
+    mEventsCondition.notify_all();
+}
+
 std::vector<TouchVideoFrame> FakeEventHub::getVideoFrames(int32_t deviceId) {
     auto it = mVideoFrames.find(deviceId);
     if (it != mVideoFrames.end()) {
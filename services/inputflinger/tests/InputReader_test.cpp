@@ -994,6 +994,55 @@ TEST_F(InputReaderTest, LoopOnce_ForwardsRawEventsToMappers) {
     ASSERT_EQ(1, event.value);
 }
 
+TEST_F(InputReaderTest, LoopOnce_ParallelDeviceProcessingKeepsEventOrder) {
+    constexpr int32_t touchDeviceId = END_RESERVED_ID + 1000;
+    constexpr int32_t touchEventHubId = 1;
+    constexpr int32_t stylusDeviceId = END_RESERVED_ID + 1001;
+    constexpr int32_t stylusEventHubId = 2;
+    constexpr int32_t keyboardDeviceId = END_RESERVED_ID + 1002;
+    constexpr int32_t keyboardEventHubId = 3;
+    FakeInputMapper& touchMapper =
+            addDeviceWithFakeInputMapper(touchDeviceId, touchEventHubId, "touch",
+                                         InputDeviceClass::TOUCH, AINPUT_SOURCE_TOUCHSCREEN,
+                                         nullptr);
+    FakeInputMapper& stylusMapper =
+            addDeviceWithFakeInputMapper(stylusDeviceId, stylusEventHubId, "stylus",
+                                         InputDeviceClass::TOUCH, AINPUT_SOURCE_STYLUS, nullptr);
+    FakeInputMapper& keyboardMapper =
+            addDeviceWithFakeInputMapper(keyboardDeviceId, keyboardEventHubId, "keyboard",
+                                         InputDeviceClass::KEYBOARD, AINPUT_SOURCE_KEYBOARD,
+                                         nullptr);
+    // Each mapper reports which device it belongs to through the switch values.
+    touchMapper.setProcessResult({NotifySwitchArgs(/*id=*/1, ARBITRARY_TIME, /*policyFlags=*/0,
+                                                   /*switchValues=*/touchEventHubId,
+                                                   /*switchMask=*/0)});
+    stylusMapper.setProcessResult({NotifySwitchArgs(/*id=*/2, ARBITRARY_TIME, /*policyFlags=*/0,
+                                                    /*switchValues=*/stylusEventHubId,
+                                                    /*switchMask=*/0)});
+    keyboardMapper.setProcessResult({NotifySwitchArgs(/*id=*/3, ARBITRARY_TIME,
+                                                      /*policyFlags=*/0,
+                                                      /*switchValues=*/keyboardEventHubId,
+                                                      /*switchMask=*/0)});
+
+    mReader->setParallelDeviceProcessingEnabled(true);
+    const std::vector<int32_t> eventHubIds = {touchEventHubId,    stylusEventHubId,
+                                              touchEventHubId,    keyboardEventHubId,
+                                              stylusEventHubId,   touchEventHubId};
+    for (int32_t eventHubId : eventHubIds) {
+        mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, eventHubId, EV_SYN,
+                                    SYN_REPORT, 0);
+    }
+    mReader->loopOnce();
+    ASSERT_NO_FATAL_FAILURE(mFakeEventHub->assertQueueIsEmpty());
+
+    // The events reach the listener in the order in which they were read.
+    for (int32_t eventHubId : eventHubIds) {
+        NotifySwitchArgs args;
+        ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifySwitchWasCalled(&args));
+        ASSERT_EQ(static_cast<uint32_t>(eventHubId), args.switchValues);
+    }
+}
+
 TEST_F(InputReaderTest, DeviceReset_RandomId) {
     constexpr int32_t deviceId = END_RESERVED_ID + 1000;
     constexpr ftl::Flags<InputDeviceClass> deviceClass = InputDeviceClass::KEYBOARD;
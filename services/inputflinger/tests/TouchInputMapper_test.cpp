@@ -0,0 +1,517 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TouchInputMapper.h"
+
+#include <android-base/stringprintf.h>
+#include <gtest/gtest.h>
+#include <input/Input.h>
+#include <ui/Transform.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "InputMapperTest.h"
+
+namespace android {
+
+using android::base::StringPrintf;
+
+namespace {
+
+inline float avg(float x, float y) {
+    return (x + y) / 2;
+}
+
+inline int32_t signExtendNybble(int32_t value) {
+    return value >= 8 ? value - 16 : value;
+}
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+} // namespace
+
+/**
+ * A TouchInputMapper whose calibration and scales are set directly by the test, so that
+ * cookPointerData can be run without configuring a device.
+ */
+class CookingTouchInputMapper : public TouchInputMapper {
+public:
+    CookingTouchInputMapper(InputDeviceContext& deviceContext,
+                            const InputReaderConfiguration& readerConfig)
+          : TouchInputMapper(deviceContext, readerConfig) {}
+
+    using TouchInputMapper::Calibration;
+    using TouchInputMapper::CookedState;
+
+    using TouchInputMapper::cookPointerData;
+    using TouchInputMapper::mAffineTransform;
+    using TouchInputMapper::mCalibration;
+    using TouchInputMapper::mCurrentCookedState;
+    using TouchInputMapper::mCurrentRawState;
+    using TouchInputMapper::mDistanceScale;
+    using TouchInputMapper::mGeometricScale;
+    using TouchInputMapper::mHaveTilt;
+    using TouchInputMapper::mLastCookedState;
+    using TouchInputMapper::mOrientationScale;
+    using TouchInputMapper::mPressureScale;
+    using TouchInputMapper::mRawPointerAxes;
+    using TouchInputMapper::mRawRotation;
+    using TouchInputMapper::mRawToDisplay;
+    using TouchInputMapper::mSizeScale;
+    using TouchInputMapper::mSource;
+    using TouchInputMapper::mTiltXCenter;
+    using TouchInputMapper::mTiltXScale;
+    using TouchInputMapper::mTiltYCenter;
+    using TouchInputMapper::mTiltYScale;
+
+    // The pointer-at-a-time cookPointerData that the per-axis version replaced, kept here as the
+    // reference that the mapper's output must match bit for bit.
+    void cookPointerDataOneByOne() {
+        uint32_t currentPointerCount = mCurrentRawState.rawPointerData.pointerCount;
+
+        mCurrentCookedState.cookedPointerData.clear();
+        mCurrentCookedState.cookedPointerData.pointerCount = currentPointerCount;
+        mCurrentCookedState.cookedPointerData.hoveringIdBits =
+                mCurrentRawState.rawPointerData.hoveringIdBits;
+        mCurrentCookedState.cookedPointerData.touchingIdBits =
+                mCurrentRawState.rawPointerData.touchingIdBits;
+        mCurrentCookedState.cookedPointerData.canceledIdBits =
+                mCurrentRawState.rawPointerData.canceledIdBits;
+
+        if (mCurrentCookedState.cookedPointerData.pointerCount == 0) {
+            mCurrentCookedState.buttonState = 0;
+        } else {
+            mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
+        }
+
+        for (uint32_t i = 0; i < currentPointerCount; i++) {
+            const RawPointerData::Pointer& in = mCurrentRawState.rawPointerData.pointers[i];
+
+            // Size
+            float touchMajor = 0, touchMinor = 0, toolMajor = 0, toolMinor = 0, size = 0;
+            switch (mCalibration.sizeCalibration) {
+                case Calibration::SizeCalibration::GEOMETRIC:
+                case Calibration::SizeCalibration::DIAMETER:
+                case Calibration::SizeCalibration::BOX:
+                case Calibration::SizeCalibration::AREA:
+                    if (mRawPointerAxes.touchMajor.valid && mRawPointerAxes.toolMajor.valid) {
+                        touchMajor = in.touchMajor;
+                        touchMinor =
+                                mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
+                        toolMajor = in.toolMajor;
+                        toolMinor = mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
+                        size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
+                                                                : in.touchMajor;
+                    } else if (mRawPointerAxes.touchMajor.valid) {
+                        toolMajor = touchMajor = in.touchMajor;
+                        toolMinor = touchMinor =
+                                mRawPointerAxes.touchMinor.valid ? in.touchMinor : in.touchMajor;
+                        size = mRawPointerAxes.touchMinor.valid ? avg(in.touchMajor, in.touchMinor)
+                                                                : in.touchMajor;
+                    } else if (mRawPointerAxes.toolMajor.valid) {
+                        touchMajor = toolMajor = in.toolMajor;
+                        touchMinor = toolMinor =
+                                mRawPointerAxes.toolMinor.valid ? in.toolMinor : in.toolMajor;
+                        size = mRawPointerAxes.toolMinor.valid ? avg(in.toolMajor, in.toolMinor)
+                                                               : in.toolMajor;
+                    }
+
+                    if (mCalibration.sizeIsSummed && *mCalibration.sizeIsSummed) {
+                        uint32_t touchingCount =
+                                mCurrentRawState.rawPointerData.touchingIdBits.count();
+                        if (touchingCount > 1) {
+                            touchMajor /= touchingCount;
+                            touchMinor /= touchingCount;
+                            toolMajor /= touchingCount;
+                            toolMinor /= touchingCount;
+                            size /= touchingCount;
+                        }
+                    }
+
+                    if (mCalibration.sizeCalibration == Calibration::SizeCalibration::GEOMETRIC) {
+                        touchMajor *= mGeometricScale;
+                        touchMinor *= mGeometricScale;
+                        toolMajor *= mGeometricScale;
+                        toolMinor *= mGeometricScale;
+                    } else if (mCalibration.sizeCalibration ==
+                               Calibration::SizeCalibration::AREA) {
+                        touchMajor = touchMajor > 0 ? sqrtf(touchMajor) : 0;
+                        touchMinor = touchMajor;
+                        toolMajor = toolMajor > 0 ? sqrtf(toolMajor) : 0;
+                        toolMinor = toolMajor;
+                    } else if (mCalibration.sizeCalibration ==
+                               Calibration::SizeCalibration::DIAMETER) {
+                        touchMinor = touchMajor;
+                        toolMinor = toolMajor;
+                    }
+
+                    mCalibration.applySizeScaleAndBias(touchMajor);
+                    mCalibration.applySizeScaleAndBias(touchMinor);
+                    mCalibration.applySizeScaleAndBias(toolMajor);
+                    mCalibration.applySizeScaleAndBias(toolMinor);
+                    size *= mSizeScale;
+                    break;
+                default:
+                    break;
+            }
+
+            // Pressure
+            float pressure;
+            switch (mCalibration.pressureCalibration) {
+                case Calibration::PressureCalibration::PHYSICAL:
+                case Calibration::PressureCalibration::AMPLITUDE:
+                    pressure = in.pressure * mPressureScale;
+                    break;
+                default:
+                    pressure = in.isHovering ? 0 : 1;
+                    break;
+            }
+
+            // Tilt and Orientation
+            float tilt;
+            float orientation;
+            if (mHaveTilt) {
+                float tiltXAngle = (in.tiltX - mTiltXCenter) * mTiltXScale;
+                float tiltYAngle = (in.tiltY - mTiltYCenter) * mTiltYScale;
+                orientation =
+                        transformAngle(mRawRotation, atan2f(-sinf(tiltXAngle), sinf(tiltYAngle)));
+                tilt = acosf(cosf(tiltXAngle) * cosf(tiltYAngle));
+            } else {
+                tilt = 0;
+
+                switch (mCalibration.orientationCalibration) {
+                    case Calibration::OrientationCalibration::INTERPOLATED:
+                        orientation =
+                                transformAngle(mRawRotation, in.orientation * mOrientationScale);
+                        break;
+                    case Calibration::OrientationCalibration::VECTOR: {
+                        int32_t c1 = signExtendNybble((in.orientation & 0xf0) >> 4);
+                        int32_t c2 = signExtendNybble(in.orientation & 0x0f);
+                        if (c1 != 0 || c2 != 0) {
+                            orientation = transformAngle(mRawRotation, atan2f(c1, c2) * 0.5f);
+                            float confidence = hypotf(c1, c2);
+                            float scale = 1.0f + confidence / 16.0f;
+                            touchMajor *= scale;
+                            touchMinor /= scale;
+                            toolMajor *= scale;
+                            toolMinor /= scale;
+                        } else {
+                            orientation = 0;
+                        }
+                        break;
+                    }
+                    default:
+                        orientation = 0;
+                }
+            }
+
+            // Distance
+            float distance;
+            switch (mCalibration.distanceCalibration) {
+                case Calibration::DistanceCalibration::SCALED:
+                    distance = in.distance * mDistanceScale;
+                    break;
+                default:
+                    distance = 0;
+            }
+
+            vec2 transformed = {in.x, in.y};
+            mAffineTransform.applyTo(transformed.x /*byRef*/, transformed.y /*byRef*/);
+            transformed = mRawToDisplay.transform(transformed);
+
+            PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
+            out.clear();
+            out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed.x);
+            out.setAxisValue(AMOTION_EVENT_AXIS_Y, transformed.y);
+            out.setAxisValue(AMOTION_EVENT_AXIS_PRESSURE, pressure);
+            out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
+            out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
+            out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
+            out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
+            out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
+            out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
+            out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
+            out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
+
+            uint32_t id = in.id;
+            if (mSource == AINPUT_SOURCE_TOUCHPAD &&
+                mLastCookedState.cookedPointerData.hasPointerCoordsForId(id)) {
+                const PointerCoords& p = mLastCookedState.cookedPointerData.pointerCoordsForId(id);
+                float dx = transformed.x - p.getAxisValue(AMOTION_EVENT_AXIS_X);
+                float dy = transformed.y - p.getAxisValue(AMOTION_EVENT_AXIS_Y);
+                out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_X, dx);
+                out.setAxisValue(AMOTION_EVENT_AXIS_RELATIVE_Y, dy);
+            }
+
+            PointerProperties& properties =
+                    mCurrentCookedState.cookedPointerData.pointerProperties[i];
+            properties.clear();
+            properties.id = id;
+            properties.toolType = in.toolType;
+
+            mCurrentCookedState.cookedPointerData.idToIndex[id] = i;
+            mCurrentCookedState.cookedPointerData.validIdBits.markBit(id);
+        }
+    }
+
+protected:
+    bool hasStylus() const override { return false; }
+    void syncTouch(nsecs_t, RawState*) override {}
+};
+
+/**
+ * Checks that cookPointerData produces exactly what it did when it cooked one pointer at a time,
+ * for every combination of calibrations and for 1 to MAX_POINTERS pointers.
+ */
+class TouchInputMapperCookPointerDataTest : public InputMapperUnitTest {
+protected:
+    using Calibration = CookingTouchInputMapper::Calibration;
+    using SizeCalibration = Calibration::SizeCalibration;
+    using PressureCalibration = Calibration::PressureCalibration;
+    using OrientationCalibration = Calibration::OrientationCalibration;
+    using DistanceCalibration = Calibration::DistanceCalibration;
+
+    // Which of the raw size axes the device reports.
+    struct SizeAxes {
+        bool touchMajor;
+        bool touchMinor;
+        bool toolMajor;
+        bool toolMinor;
+    };
+
+    struct CookCase {
+        SizeCalibration size{SizeCalibration::NONE};
+        SizeAxes sizeAxes{};
+        std::optional<bool> sizeIsSummed;
+        PressureCalibration pressure{PressureCalibration::NONE};
+        OrientationCalibration orientation{OrientationCalibration::NONE};
+        bool haveTilt{false};
+        DistanceCalibration distance{DistanceCalibration::NONE};
+        uint32_t source{AINPUT_SOURCE_TOUCHSCREEN};
+
+        std::string toString() const {
+            return StringPrintf("size=%d axes=%d%d%d%d summed=%d pressure=%d orientation=%d "
+                                "tilt=%d distance=%d source=%#x",
+                                static_cast<int>(size), sizeAxes.touchMajor, sizeAxes.touchMinor,
+                                sizeAxes.toolMajor, sizeAxes.toolMinor,
+                                sizeIsSummed ? int(*sizeIsSummed) : -1,
+                                static_cast<int>(pressure), static_cast<int>(orientation),
+                                haveTilt, static_cast<int>(distance), source);
+        }
+    };
+
+    // Every combination of the calibrations that cookPointerData looks at. Devices without any
+    // size axes are left out, because their size calibration is resolved to NONE.
+    static std::vector<CookCase> allCookCases() {
+        const SizeCalibration sizes[] = {SizeCalibration::NONE, SizeCalibration::GEOMETRIC,
+                                         SizeCalibration::DIAMETER, SizeCalibration::BOX,
+                                         SizeCalibration::AREA};
+        const SizeAxes sizeAxesCases[] = {
+                {.touchMajor = true, .touchMinor = true, .toolMajor = true, .toolMinor = true},
+                {.touchMajor = true, .touchMinor = false, .toolMajor = true, .toolMinor = false},
+                {.touchMajor = true, .touchMinor = true, .toolMajor = false, .toolMinor = false},
+                {.touchMajor = true, .touchMinor = false, .toolMajor = false, .toolMinor = false},
+                {.touchMajor = false, .touchMinor = false, .toolMajor = true, .toolMinor = true},
+                {.touchMajor = false, .touchMinor = false, .toolMajor = true, .toolMinor = false},
+        };
+        const std::optional<bool> sizeIsSummedCases[] = {std::nullopt, false, true};
+        const PressureCalibration pressures[] = {PressureCalibration::NONE,
+                                                 PressureCalibration::PHYSICAL,
+                                                 PressureCalibration::AMPLITUDE};
+        const OrientationCalibration orientations[] = {OrientationCalibration::NONE,
+                                                       OrientationCalibration::INTERPOLATED,
+                                                       OrientationCalibration::VECTOR};
+        const DistanceCalibration distances[] = {DistanceCalibration::NONE,
+                                                 DistanceCalibration::SCALED};
+        const uint32_t sources[] = {AINPUT_SOURCE_TOUCHSCREEN, AINPUT_SOURCE_TOUCHPAD};
+
+        // Start from a single case and multiply it by the values of each calibration in turn.
+        std::vector<CookCase> cases(1);
+        auto expand = [&cases](const auto& values, auto set) {
+            std::vector<CookCase> expanded;
+            for (const CookCase& cookCase : cases) {
+                for (const auto& value : values) {
+                    expanded.push_back(cookCase);
+                    set(expanded.back(), value);
+                }
+            }
+            cases = std::move(expanded);
+        };
+        expand(sizes, [](CookCase& c, SizeCalibration value) { c.size = value; });
+        expand(sizeAxesCases, [](CookCase& c, const SizeAxes& value) { c.sizeAxes = value; });
+        expand(sizeIsSummedCases,
+               [](CookCase& c, std::optional<bool> value) { c.sizeIsSummed = value; });
+        expand(pressures, [](CookCase& c, PressureCalibration value) { c.pressure = value; });
+        expand(orientations,
+               [](CookCase& c, OrientationCalibration value) { c.orientation = value; });
+        expand(std::array{false, true}, [](CookCase& c, bool value) { c.haveTilt = value; });
+        expand(distances, [](CookCase& c, DistanceCalibration value) { c.distance = value; });
+        expand(sources, [](CookCase& c, uint32_t value) { c.source = value; });
+        return cases;
+    }
+
+    void applyCookCase(const CookCase& cookCase) {
+        CookingTouchInputMapper& mapper = *mCookingMapper;
+        mapper.mCalibration.sizeCalibration = cookCase.size;
+        mapper.mRawPointerAxes.touchMajor.valid = cookCase.sizeAxes.touchMajor;
+        mapper.mRawPointerAxes.touchMinor.valid = cookCase.sizeAxes.touchMinor;
+        mapper.mRawPointerAxes.toolMajor.valid = cookCase.sizeAxes.toolMajor;
+        mapper.mRawPointerAxes.toolMinor.valid = cookCase.sizeAxes.toolMinor;
+        mapper.mCalibration.sizeIsSummed = cookCase.sizeIsSummed;
+        mapper.mCalibration.pressureCalibration = cookCase.pressure;
+        mapper.mCalibration.orientationCalibration = cookCase.orientation;
+        mapper.mHaveTilt = cookCase.haveTilt;
+        mapper.mCalibration.distanceCalibration = cookCase.distance;
+        mapper.mSource = cookCase.source;
+    }
+
+    void SetUp() override {
+        InputMapperUnitTest::SetUp();
+        createDevice();
+        mCookingMapper =
+                std::make_unique<CookingTouchInputMapper>(*mDeviceContext, mReaderConfiguration);
+
+        CookingTouchInputMapper& mapper = *mCookingMapper;
+        mapper.mGeometricScale = 0.75f;
+        mapper.mPressureScale = 1.0f / 255;
+        mapper.mSizeScale = 1.0f / 100;
+        mapper.mOrientationScale = M_PI_2 / 127;
+        mapper.mDistanceScale = 0.5f;
+        mapper.mTiltXCenter = 3;
+        mapper.mTiltXScale = M_PI / 180;
+        mapper.mTiltYCenter = -2;
+        mapper.mTiltYScale = M_PI / 180;
+        mapper.mAffineTransform = TouchAffineTransformation(1.01f, 0.02f, 3, -0.01f, 0.99f, -2);
+
+        ui::Transform scale;
+        scale.set(0.5f, 0, 0, 0.75f);
+        mapper.mRawToDisplay = ui::Transform(ui::Transform::ROT_90, 800, 480) * scale;
+        mapper.mRawRotation = ui::Transform{mapper.mRawToDisplay.getOrientation()};
+
+        mapper.mCalibration.sizeScale = 2.5f;
+        mapper.mCalibration.sizeBias = -3;
+        mapper.mCalibration.distanceScale = 0.5f;
+    }
+
+    void setRandomRawState(uint32_t pointerCount) {
+        RawPointerData& data = mCookingMapper->mCurrentRawState.rawPointerData;
+        data.clear();
+        data.pointerCount = pointerCount;
+
+        std::array<uint32_t, MAX_POINTER_ID + 1> ids;
+        std::iota(ids.begin(), ids.end(), 0);
+        std::shuffle(ids.begin(), ids.end(), mRandom);
+
+        auto random = [this](int32_t min, int32_t max) {
+            return std::uniform_int_distribution<int32_t>(min, max)(mRandom);
+        };
+        for (uint32_t i = 0; i < pointerCount; i++) {
+            RawPointerData::Pointer& pointer = data.pointers[i];
+            pointer.id = ids[i];
+            pointer.x = random(0, 1000);
+            pointer.y = random(0, 1000);
+            pointer.pressure = random(0, 255);
+            pointer.touchMajor = random(0, 100);
+            pointer.touchMinor = random(0, 100);
+            pointer.toolMajor = random(0, 100);
+            pointer.toolMinor = random(0, 100);
+            pointer.orientation = random(-128, 255);
+            pointer.distance = random(0, 50);
+            pointer.tiltX = random(-60, 60);
+            pointer.tiltY = random(-60, 60);
+            pointer.toolType = ToolType::FINGER;
+            pointer.isHovering = random(0, 3) == 0;
+            data.markIdBit(pointer.id, pointer.isHovering);
+            data.idToIndex[pointer.id] = i;
+        }
+        mCookingMapper->mCurrentRawState.buttonState = random(0, 3);
+    }
+
+    void expectSameCookedState(const CookingTouchInputMapper::CookedState& expected,
+                               const CookingTouchInputMapper::CookedState& actual) {
+        const CookedPointerData& e = expected.cookedPointerData;
+        const CookedPointerData& a = actual.cookedPointerData;
+        EXPECT_EQ(expected.buttonState, actual.buttonState);
+        ASSERT_EQ(e.pointerCount, a.pointerCount);
+        EXPECT_EQ(e.hoveringIdBits, a.hoveringIdBits);
+        EXPECT_EQ(e.touchingIdBits, a.touchingIdBits);
+        EXPECT_EQ(e.canceledIdBits, a.canceledIdBits);
+        EXPECT_EQ(e.validIdBits, a.validIdBits);
+        for (uint32_t i = 0; i < e.pointerCount; i++) {
+            SCOPED_TRACE(StringPrintf("pointer %u", i));
+            EXPECT_EQ(e.pointerProperties[i], a.pointerProperties[i]);
+            EXPECT_EQ(e.idToIndex[e.pointerProperties[i].id],
+                      a.idToIndex[a.pointerProperties[i].id]);
+
+            const PointerCoords& ec = e.pointerCoords[i];
+            const PointerCoords& ac = a.pointerCoords[i];
+            ASSERT_EQ(ec.bits, ac.bits);
+            for (uint32_t index = 0; index < BitSet64::count(ec.bits); index++) {
+                EXPECT_EQ(floatBits(ec.values[index]), floatBits(ac.values[index]))
+                        << "axis value " << index << ": expected " << ec.values[index]
+                        << ", got " << ac.values[index];
+            }
+        }
+    }
+
+    // Cooks the current raw state both ways and compares the results.
+    void expectParity() {
+        CookingTouchInputMapper& mapper = *mCookingMapper;
+        mapper.cookPointerDataOneByOne();
+        const CookingTouchInputMapper::CookedState expected = mapper.mCurrentCookedState;
+
+        mapper.mCurrentCookedState.clear();
+        mapper.cookPointerData();
+        expectSameCookedState(expected, mapper.mCurrentCookedState);
+    }
+
+    std::unique_ptr<CookingTouchInputMapper> mCookingMapper;
+    std::mt19937 mRandom{/*seed=*/42};
+};
+
+TEST_F(TouchInputMapperCookPointerDataTest, MatchesPointerAtATimeCooking) {
+    CookingTouchInputMapper& mapper = *mCookingMapper;
+    for (const CookCase& cookCase : allCookCases()) {
+        SCOPED_TRACE(cookCase.toString());
+        applyCookCase(cookCase);
+
+        for (uint32_t pointerCount = 1; pointerCount <= MAX_POINTERS; pointerCount++) {
+            SCOPED_TRACE(StringPrintf("%u pointers", pointerCount));
+
+            // The previous frame gives touchpad pointers their relative axes.
+            setRandomRawState(pointerCount);
+            mapper.cookPointerDataOneByOne();
+            mapper.mLastCookedState = mapper.mCurrentCookedState;
+
+            setRandomRawState(pointerCount);
+            ASSERT_NO_FATAL_FAILURE(expectParity());
+        }
+    }
+}
+
+} // namespace android
@@ -90,6 +90,10 @@ struct CompositionRefreshArgs {
     // If set, causes the dirty regions to flash with the delay
     std::optional<std::chrono::microseconds> devOptFlashDirtyRegionsDelay;
 
+    // If true, outputs that can be presented from another thread update and write the composition
+    // state of their layers concurrently, before any output is presented.
+    bool parallelCompositionState{false};
+
     scheduler::FrameTargets frameTargets;
 
     // The frameInterval for the next present
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <ui/Rect.h>
+
+namespace android::compositionengine {
+
+// Coarse summary of the coverage regions accumulated while computing layer visibility, used to
+// skip Region operations whose result is already known.
+//
+// The bounds are split into a grid of at most 64x64 tiles, with one 64-bit mask per row. A tile
+// is marked covered if any covered rect overlaps it, and opaque only if an opaque rect contains
+// it entirely. Queries are therefore conservative: isUncovered() and isOpaque() only return true
+// when the exact regions would agree, and false whenever the tiles cannot tell.
+class CoverageTiles {
+public:
+    static constexpr size_t kGridSize = 64;
+
+    // Resets the tiles to cover |bounds|. Empty bounds disable the tiles, so that every query
+    // returns false.
+    void setBounds(const Rect& bounds);
+
+    // Records that |rect| is covered, or opaquely covered.
+    void addCovered(const Rect& rect);
+    void addOpaque(const Rect& rect);
+
+    // Returns true if nothing recorded as covered intersects |rect|.
+    bool isUncovered(const Rect& rect) const;
+
+    // Returns true if |rect| is entirely within the area recorded as opaque.
+    bool isOpaque(const Rect& rect) const;
+
+private:
+    // The rows of the grid, and the columns within each row, that a rect spans.
+    struct Span {
+        size_t firstRow;
+        size_t lastRow;
+        uint64_t columns;
+    };
+
+    bool isEnabled() const { return mTileWidth > 0; }
+
+    // The tiles that |rect| overlaps, or that it contains entirely. |rect| must be within the
+    // bounds. Returns false if there are no such tiles.
+    bool getOverlappedTiles(const Rect& rect, Span* span) const;
+    bool getContainedTiles(const Rect& rect, Span* span) const;
+
+    Rect mBounds;
+    int64_t mTileWidth = 0;
+    int64_t mTileHeight = 0;
+    std::array<uint64_t, kGridSize> mCovered{};
+    std::array<uint64_t, kGridSize> mOpaque{};
+    // Whether any covered rect extended beyond the bounds, which the tiles cannot represent.
+    bool mCoveredOutsideBounds = false;
+};
+
+} // namespace android::compositionengine
@@ -25,6 +25,7 @@
 #include <utility>
 #include <vector>
 
+#include <compositionengine/CoverageTiles.h>
 #include <compositionengine/LayerFE.h>
 #include <ftl/future.h>
 #include <renderengine/LayerSettings.h>
@@ -157,6 +158,10 @@ public:
         // only has a value if there's something needing it, like when a TrustedPresentationListener
         // is set
         std::optional<Region> aboveCoveredLayersExcludingOverlays;
+        // Tiled summary of aboveCoveredLayers and aboveOpaqueLayers, which lets layers that are
+        // entirely uncovered or entirely occluded skip the Region operations. Disabled unless
+        // its bounds are set before any coverage is accumulated.
+        CoverageTiles tiles;
     };
 
     virtual ~Output();
@@ -274,9 +279,26 @@ public:
     // Make the next call to `present` run asynchronously.
     virtual void offloadPresentNextFrame() = 0;
 
+    // Finishes the frame if `present` left it waiting on a pipelined HWC validate, and presents it
+    // asynchronously. Must be called after `present` has been called on every output. The
+    // returned future must be waited upon; it is ready right away if there was no such frame.
+    virtual ftl::Future<std::monostate> presentPipelinedFrame(const CompositionRefreshArgs&) = 0;
+
+    // Updates, plans and writes the composition state of the output's layers ahead of
+    // `present`, which then skips those steps for this frame. This may happen asynchronously, in
+    // which case the returned future must be waited upon before any output is presented.
+    virtual ftl::Future<std::monostate> prepareCompositionState(const CompositionRefreshArgs&) = 0;
+
+    // Make the next call to `prepareCompositionState` run asynchronously.
+    virtual void offloadCompositionStateNextFrame() = 0;
+
     // Enables predicting composition strategy to run client composition earlier
     virtual void setPredictCompositionStrategy(bool) = 0;
 
+    // Enables running HWC validate on the offloaded present worker for frames that are
+    // expected to be fully device composited, so the main thread does not wait on validate
+    virtual void setPipelineHwcValidate(bool) = 0;
+
     // Enables overriding the 170M trasnfer function as sRGB
     virtual void setTreat170mAsSrgb(bool) = 0;
 
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <deque>
+#include <optional>
 
 #include <compositionengine/LayerFE.h>
 #include <renderengine/DisplaySettings.h>
@@ -43,6 +44,11 @@ public:
     ~ClientCompositionRequestCache() = default;
     bool exists(uint64_t bufferId, const renderengine::DisplaySettings& display,
                 const std::vector<LayerFE::LayerSettings>& layerSettings) const;
+    // If the request differs from the one rendered into the buffer only in layers that can be
+    // redrawn in place, returns the bounds of those layers before and after the change, in layer
+    // stack space. Otherwise the whole buffer needs to be redrawn, and nullopt is returned.
+    std::optional<Rect> getDamage(uint64_t bufferId, const renderengine::DisplaySettings& display,
+                                  const std::vector<LayerFE::LayerSettings>& layerSettings) const;
     void add(uint64_t bufferId, const renderengine::DisplaySettings& display,
              const std::vector<LayerFE::LayerSettings>& layerSettings);
     void remove(uint64_t bufferId);
@@ -56,6 +62,9 @@ private:
                                  const std::vector<LayerFE::LayerSettings>& _layerSettings);
         bool equals(const renderengine::DisplaySettings& _display,
                     const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
+        std::optional<Rect> getDamage(
+                const renderengine::DisplaySettings& _display,
+                const std::vector<LayerFE::LayerSettings>& _layerSettings) const;
     };
 
     // Cache of requests, keyed by corresponding GraphicBuffer ID.
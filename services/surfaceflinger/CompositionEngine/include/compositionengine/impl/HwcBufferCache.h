@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <stack>
+#include <string>
 #include <unordered_map>
 
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
@@ -66,8 +68,33 @@ public:
     // buffers from the cache. We add an extra slot at the end for the override buffers.
     static const constexpr size_t kOverrideBufferSlot = kMaxLayerBufferCount;
 
+    // How often buffers were found in the cache, and how often slots had to be reassigned.
+    struct Stats {
+        // Buffers that were already cached, so their handle wasn't sent to HWC again.
+        uint64_t hits = 0;
+        // Buffers that were not cached, so their handle was sent to HWC.
+        uint64_t misses = 0;
+        // Cached buffers that were evicted to make room for another buffer.
+        uint64_t evictions = 0;
+        // Cached buffers that were purged because their client discarded them.
+        uint64_t uncaches = 0;
+
+        Stats& operator+=(const Stats& other) {
+            hits += other.hits;
+            misses += other.misses;
+            evictions += other.evictions;
+            uncaches += other.uncaches;
+            return *this;
+        }
+    };
+
+    // Uses the slot budget set by debug.sf.hwc_layer_buffer_slot_budget, or all slots.
     HwcBufferCache();
 
+    // Caches at most slotBudget buffers, other than the override buffer. The budget is clamped to
+    // the number of slots available.
+    explicit HwcBufferCache(uint32_t slotBudget);
+
     //
     // Given a buffer, return the HWC cache slot and buffer to send to HWC.
     //
@@ -92,22 +119,44 @@ public:
     //
     uint32_t uncache(uint64_t graphicBufferId);
 
+    uint32_t getSlotBudget() const { return mSlotBudget; }
+    size_t getCachedBufferCount() const { return mSlotByBufferId.size(); }
+    const Stats& getStats() const { return mStats; }
+
+    void dump(std::string& out) const;
+
 private:
+    static const constexpr uint32_t kInvalidSlot = UINT32_MAX;
+
+    // Reads debug.sf.hwc_layer_buffer_slot_budget on first use, not during static initialization.
+    static uint32_t getDefaultSlotBudget();
+
     uint32_t cache(const sp<GraphicBuffer>& buffer);
     uint32_t getLeastRecentlyUsedSlot();
 
-    struct Cache {
+    // Moves a cached slot to the most recently used end of the LRU list.
+    void markMostRecentlyUsed(uint32_t slot);
+    void unlink(uint32_t slot);
+
+    // Cached slots form a doubly-linked list ordered from most to least recently used, so that
+    // slots are both refreshed and evicted in constant time. Cache entries are evicted according
+    // to least-recently-used when more than mSlotBudget unique buffers have been sent to a layer.
+    struct Slot {
         sp<GraphicBuffer> buffer;
-        uint32_t slot;
-        // Cache entries are evicted according to least-recently-used when more than
-        // kMaxLayerBufferCount unique buffers have been sent to a layer.
-        uint64_t lruCounter;
+        uint32_t moreRecentlyUsed = kInvalidSlot;
+        uint32_t lessRecentlyUsed = kInvalidSlot;
     };
 
-    std::unordered_map<uint64_t, Cache> mCacheByBufferId;
+    uint32_t mSlotBudget;
+    std::array<Slot, kMaxLayerBufferCount> mSlots;
+    uint32_t mMostRecentlyUsedSlot = kInvalidSlot;
+    uint32_t mLeastRecentlyUsedSlot = kInvalidSlot;
+
+    std::unordered_map<uint64_t, uint32_t> mSlotByBufferId;
     sp<GraphicBuffer> mLastOverrideBuffer;
     std::stack<uint32_t> mFreeSlots;
-    uint64_t mLeastRecentlyUsedCounter;
+
+    Stats mStats;
 };
 
 } // namespace compositionengine::impl
@@ -83,6 +83,9 @@ public:
     ftl::Future<std::monostate> present(const CompositionRefreshArgs&) override;
     bool supportsOffloadPresent() const override { return false; }
     void offloadPresentNextFrame() override;
+    ftl::Future<std::monostate> presentPipelinedFrame(const CompositionRefreshArgs&) override;
+    ftl::Future<std::monostate> prepareCompositionState(const CompositionRefreshArgs&) override;
+    void offloadCompositionStateNextFrame() override;
 
     void uncacheBuffers(const std::vector<uint64_t>& bufferIdsToUncache) override;
     void rebuildLayerStacks(const CompositionRefreshArgs&, LayerFESet&) override;
@@ -109,6 +112,7 @@ public:
     void cacheClientCompositionRequests(uint32_t) override;
     bool canPredictCompositionStrategy(const CompositionRefreshArgs&) override;
     void setPredictCompositionStrategy(bool) override;
+    void setPipelineHwcValidate(bool) override;
     void setTreat170mAsSrgb(bool) override;
 
     // Testing
@@ -123,7 +127,11 @@ public:
     virtual std::future<bool> chooseCompositionStrategyAsync(
             std::optional<android::HWComposer::DeviceRequestedChanges>*);
     virtual void resetCompositionStrategy();
+    virtual void applyChosenCompositionStrategy(
+            bool success, const std::optional<android::HWComposer::DeviceRequestedChanges>&);
     virtual ftl::Future<std::monostate> presentFrameAndReleaseLayersAsync();
+    virtual bool canPipelineHwcValidate(const CompositionRefreshArgs&);
+    virtual ftl::Future<std::monostate> presentFramePipelined(const CompositionRefreshArgs&);
 
 protected:
     std::unique_ptr<compositionengine::OutputLayer> createOutputLayer(const sp<LayerFE>&) const;
@@ -162,6 +170,7 @@ protected:
 
 private:
     void dirtyEntireOutput();
+    void updateAndWriteCompositionState(const compositionengine::CompositionRefreshArgs&);
     void updateCompositionStateForBorder(const compositionengine::CompositionRefreshArgs&);
     compositionengine::OutputLayer* findLayerRequestingBackgroundComposition() const;
     void finishPrepareFrame();
@@ -184,7 +193,19 @@ private:
     std::unique_ptr<HwcAsyncWorker> mHwComposerAsyncWorker;
 
     bool mPredictCompositionStrategy = false;
+    bool mPipelineHwcValidate = false;
     bool mOffloadPresent = false;
+    bool mOffloadCompositionState = false;
+
+    // A frame whose HWC validate runs on the worker, until presentPipelinedFrame finishes it.
+    struct PipelinedFrame {
+        std::future<bool> validate;
+        std::optional<android::HWComposer::DeviceRequestedChanges> changes;
+    };
+    std::optional<PipelinedFrame> mPipelinedFrame;
+
+    // Whether prepareCompositionState has run for the frame being presented.
+    bool mCompositionStatePrepared = false;
 
     // Whether the content must be recomposed this frame.
     bool mMustRecompose = false;
@@ -20,9 +20,11 @@
 #include <compositionengine/ProjectionSpace.h>
 #include <compositionengine/impl/planner/LayerState.h>
 #include <compositionengine/impl/planner/TexturePool.h>
+#include <ftl/future.h>
 #include <renderengine/RenderEngine.h>
 
 #include <chrono>
+#include <optional>
 
 namespace android {
 
@@ -65,9 +67,8 @@ public:
     size_t getLayerCount() const { return mLayers.size(); }
     const Layer& getFirstLayer() const { return mLayers[0]; }
     const Rect& getBounds() const { return mBounds; }
-    Rect getTextureBounds() const {
-        return mTexture ? mTexture->get()->getBuffer()->getBounds() : Rect::INVALID_RECT;
-    }
+    // The part of the display covered by the rendered texture.
+    Rect getTextureBounds() const { return mTexture ? mTextureBounds : Rect::INVALID_RECT; }
     const Region& getVisibleRegion() const { return mVisibleRegion; }
     size_t getAge() const { return mAge; }
     std::shared_ptr<renderengine::ExternalTexture> getBuffer() const {
@@ -101,6 +102,7 @@ public:
         mBlurLayer = nullptr;
         mHolePunchLayer = nullptr;
         mSkipCount = 0;
+        mPendingRender.reset();
 
         mLayers.insert(mLayers.end(), other.mLayers.cbegin(), other.mLayers.cend());
         Region boundingRegion;
@@ -113,9 +115,36 @@ public:
     void incrementSkipCount() { mSkipCount++; }
     size_t getSkipCount() { return mSkipCount; }
 
-    // Renders the cached set with the supplied output composition state.
+    // Renders the cached set with the supplied output composition state. If async is true, the
+    // draw is queued on RenderEngine without waiting for it, and the rendered buffer is only
+    // available once collectPendingRender() has observed its completion.
     void render(renderengine::RenderEngine& re, TexturePool& texturePool,
-                const OutputCompositionState& outputState, bool deviceHandlesColorTransform);
+                const OutputCompositionState& outputState, bool deviceHandlesColorTransform,
+                bool async = false);
+
+    // The rendered buffer of a cached set, which may outlive the layers that were drawn into it.
+    struct RenderedBuffer {
+        std::shared_ptr<TexturePool::AutoTexture> texture;
+        Rect textureBounds;
+        sp<Fence> drawFence;
+        ProjectionSpace outputSpace;
+        ui::Dataspace outputDataspace;
+        ui::Transform::RotationFlags orientation;
+    };
+
+    // Returns the rendered buffer, if it is ready to be displayed.
+    std::optional<RenderedBuffer> getRenderedBuffer() const;
+
+    // Draws this cached set from a buffer that was rendered for the same layer content, instead
+    // of rendering it again.
+    void adoptRenderedBuffer(RenderedBuffer buffer);
+
+    // True if an asynchronous render was queued and has not been collected yet.
+    bool hasPendingRender() const { return mPendingRender.has_value(); }
+
+    // Takes the result of a pending asynchronous render if RenderEngine has completed it.
+    // Returns true if the render was collected, whether or not it succeeded.
+    bool collectPendingRender();
 
     void dump(std::string& result) const;
 
@@ -166,11 +195,30 @@ private:
     // TODO(b/190411067): This is a shared pointer only because CachedSets are copied into different
     // containers in the Flattener. Logically this should have unique ownership otherwise.
     std::shared_ptr<TexturePool::AutoTexture> mTexture;
+    Rect mTextureBounds = Rect::INVALID_RECT;
     sp<Fence> mDrawFence;
     ProjectionSpace mOutputSpace;
     ui::Dataspace mOutputDataspace;
     ui::Transform::RotationFlags mOrientation = ui::Transform::ROT_0;
 
+    // A render queued on RenderEngine, along with the output state it was rendered with.
+    struct PendingRender {
+        ftl::SharedFuture<FenceResult> fenceResult;
+        std::shared_ptr<TexturePool::AutoTexture> texture;
+        Rect textureBounds;
+        ProjectionSpace outputSpace;
+        ui::Dataspace outputDataspace;
+        ui::Transform::RotationFlags orientation;
+    };
+
+    // Where a texture for this cached set is drawn on the display: mBounds, clamped to the display
+    // and grown to the size of the borrowed texture.
+    Rect getTextureBoundsOnDisplay(ui::Size textureSize, const Rect& display) const;
+
+    void finishRender(FenceResult fenceResult, PendingRender&& render);
+
+    std::optional<PendingRender> mPendingRender;
+
     static const bool sDebugHighlighLayers;
 };
 
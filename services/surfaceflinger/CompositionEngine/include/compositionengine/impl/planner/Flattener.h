@@ -21,6 +21,7 @@
 #include <compositionengine/impl/planner/LayerState.h>
 
 #include <chrono>
+#include <deque>
 #include <numeric>
 #include <vector>
 
@@ -74,6 +75,11 @@ public:
 
         static const constexpr bool kDefaultEnableHolePunch = true;
 
+        static const constexpr bool kDefaultEnableAsyncRender = false;
+
+        static const constexpr size_t kDefaultTexturePoolMemoryBudget = 128 * 1024 * 1024;
+        static const constexpr size_t kDefaultLowRamTexturePoolMemoryBudget = 16 * 1024 * 1024;
+
         // Threshold for determing whether a layer is active. A layer whose properties, including
         // the buffer, have not changed in at least this time is considered inactive and is
         // therefore a candidate for flattening.
@@ -85,6 +91,13 @@ public:
 
         // True if the hole punching feature should be enabled.
         const bool mEnableHolePunch;
+
+        // True if cached sets should be queued on RenderEngine without waiting for the draw to
+        // complete. The rendered cached set is then merged on a later frame, once the draw is done.
+        const bool mEnableAsyncRender;
+
+        // Memory that the texture pool may hold, including the textures of cached sets, in bytes.
+        const size_t mTexturePoolMemoryBudget;
     };
 
     // Constants not yet backed by a sysprop
@@ -93,23 +106,35 @@ public:
     static constexpr int kNumLayersFpsConsideration = 1;
     // Frames/Second threshold below which these CachedSets may be considered inactive.
     static constexpr float kFpsActiveThreshold = 1.f;
+    // How many rendered cached sets are kept after the layer stack changes, in case the same
+    // layers reappear elsewhere in the stack.
+    static constexpr size_t kMaxReusableCachedSets = 2;
+    // How long such a cached set is kept without being reused.
+    static constexpr std::chrono::seconds kReusableCachedSetTimeout = 10s;
 
     Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables);
 
     void setDisplaySize(ui::Size size) {
         mDisplaySize = size;
+        mReusableCachedSets.clear();
         mTexturePool.setDisplaySize(size);
     }
 
     NonBufferHash flattenLayers(const std::vector<const LayerState*>& layers, NonBufferHash,
                                 std::chrono::steady_clock::time_point now);
 
-    // Renders the newest cached sets with the supplied output composition state
+    // Renders the newest cached sets with the supplied output composition state. If rendering is
+    // asynchronous, this also collects a previously queued render of the newest cached set.
     void renderCachedSets(const OutputCompositionState& outputState,
                           std::optional<std::chrono::steady_clock::time_point> renderDeadline,
                           bool deviceHandlesColorTransform);
 
-    void setTexturePoolEnabled(bool enabled) { mTexturePool.setEnabled(enabled); }
+    void setTexturePoolEnabled(bool enabled) {
+        if (!enabled) {
+            mReusableCachedSets.clear();
+        }
+        mTexturePool.setEnabled(enabled);
+    }
 
     void dump(std::string& result) const;
     void dumpLayers(std::string& result) const;
@@ -123,9 +148,26 @@ private:
 
     NonBufferHash computeLayersHash() const;
 
+    // Collects the asynchronous render of mNewCachedSet if RenderEngine has completed it.
+    void collectPendingRender();
+
+    // Reports how many of the layers are drawn from a flattened buffer this frame.
+    void recordFlattenHitRate(size_t layerCount, size_t flattenedLayerCount);
+
     bool mergeWithCachedSets(const std::vector<const LayerState*>& layers,
                              std::chrono::steady_clock::time_point now);
 
+    // Keeps the rendered buffer of a cached set that is invalidated by a layer stack change.
+    void retainRenderedCachedSet(const CachedSet& cachedSet,
+                                 std::chrono::steady_clock::time_point now);
+
+    // Drops the retained cached sets that have not been reused in time.
+    void expireReusableCachedSets(std::chrono::steady_clock::time_point now);
+
+    // Looks for a retained cached set drawing the same content as the layers starting at first.
+    std::optional<CachedSet> reuseCachedSet(std::vector<const LayerState*>::const_iterator first,
+                                            std::vector<const LayerState*>::const_iterator last);
+
     // A Run is a sequence of CachedSets, which is a candidate for flattening into a single
     // CachedSet. Because it is wasteful to flatten 1 CachedSet, a run must contain more than
     // 1 CachedSet or be used for a hole punch.
@@ -246,6 +288,25 @@ private:
 
     std::vector<CachedSet> mLayers;
 
+    // A rendered cached set that was invalidated by a layer stack change. It is identified by
+    // the content of its layers, since the layers themselves may have been destroyed.
+    struct ReusableCachedSet {
+        size_t contentHash;
+        size_t layerCount;
+        CachedSet::RenderedBuffer buffer;
+        std::chrono::steady_clock::time_point lastUpdate;
+        std::chrono::steady_clock::time_point retainTime;
+    };
+
+    // Most recently retained first. Like mNewCachedSet, these must be destroyed before
+    // mTexturePool is.
+    std::deque<ReusableCachedSet> mReusableCachedSets;
+
+    // The output of the last renderCachedSets call. Retained cached sets are only reused if they
+    // were rendered for the same output.
+    ProjectionSpace mOutputSpace;
+    ui::Dataspace mOutputDataspace = ui::Dataspace::UNKNOWN;
+
     // Statistics
     size_t mUnflattenedDisplayCost = 0;
     size_t mFlattenedDisplayCost = 0;
@@ -254,6 +315,15 @@ private:
     size_t mCachedSetCreationCount = 0;
     size_t mCachedSetCreationCost = 0;
     std::unordered_map<size_t, size_t> mInvalidatedCachedSetAges;
+    size_t mLayerCount = 0;
+    size_t mFlattenedLayerCount = 0;
+    size_t mCachedSetRenderCount = 0;
+    std::chrono::nanoseconds mCachedSetRenderTime = 0ns;
+    size_t mCachedSetReuseCount = 0;
+    size_t mCachedSetExpiredCount = 0;
+
+    // When the render of mNewCachedSet was queued, if it is pending.
+    std::chrono::steady_clock::time_point mRenderQueueTime;
 };
 
 } // namespace compositionengine::impl::planner
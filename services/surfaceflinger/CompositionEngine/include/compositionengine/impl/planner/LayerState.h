@@ -253,6 +253,7 @@ public:
     };
 
     wp<GraphicBuffer> getBuffer() const { return mBuffer.get(); }
+    uint64_t getFrameNumber() const { return mFrameNumber.get(); }
 
     bool isProtected() const { return mIsProtected.get(); }
 
@@ -23,16 +23,21 @@
 
 #include <renderengine/ExternalTexture.h>
 #include <chrono>
+#include <limits>
 #include "android-base/macros.h"
 
 namespace android::compositionengine::impl::planner {
 
-// A pool of textures that only manages textures of a single size.
-// While it is possible to define a texture pool supporting variable-sized textures to save on
-// memory, it is a simpler implementation to only manage screen-sized textures. The texture pool is
-// unbounded - there are a minimum number of textures preallocated. Under heavy system load, new
-// textures may be allocated, but only a maximum number of retained once those textures are no
-// longer necessary.
+// A pool of textures for rendering cached sets.
+// Textures are screen-sized by default, but smaller textures may be borrowed too. Their sizes are
+// rounded up to a fraction of the screen size, so that textures of similar sizes can be reused.
+// Borrowing a texture always succeeds: under heavy system load, new textures may be allocated, but
+// only a maximum number are retained once those textures are no longer necessary.
+//
+// The number of retained textures adapts to how often cached sets are used: textures are
+// preallocated when the pool is enabled, and the pool grows when it runs out of textures, but it
+// releases its idle textures when flattening stops paying off. The retained textures are also
+// bounded by a memory budget, which includes the textures that are borrowed.
 class TexturePool {
 public:
     // RAII class helping with managing textures from the texture pool
@@ -41,10 +46,14 @@ public:
     class AutoTexture {
     public:
         AutoTexture(TexturePool& texturePool,
-                    std::shared_ptr<renderengine::ExternalTexture> texture, const sp<Fence>& fence)
-              : mTexturePool(texturePool), mTexture(texture), mFence(fence) {}
+                    std::shared_ptr<renderengine::ExternalTexture> texture, const sp<Fence>& fence,
+                    uint32_t generation)
+              : mTexturePool(texturePool),
+                mTexture(texture),
+                mFence(fence),
+                mGeneration(generation) {}
 
-        ~AutoTexture() { mTexturePool.returnTexture(std::move(mTexture), mFence); }
+        ~AutoTexture() { mTexturePool.returnTexture(std::move(mTexture), mFence, mGeneration); }
 
         sp<Fence> getReadyFence() { return mFence; }
 
@@ -61,10 +70,15 @@ public:
         TexturePool& mTexturePool;
         std::shared_ptr<renderengine::ExternalTexture> mTexture;
         sp<Fence> mFence;
+        // The display size the texture was allocated for, see TexturePool::mGeneration.
+        const uint32_t mGeneration;
     };
 
-    TexturePool(renderengine::RenderEngine& renderEngine)
-          : mRenderEngine(renderEngine), mEnabled(false) {}
+    static const constexpr size_t kUnlimitedMemoryBudget = std::numeric_limits<size_t>::max();
+
+    TexturePool(renderengine::RenderEngine& renderEngine,
+                size_t memoryBudget = kUnlimitedMemoryBudget)
+          : mRenderEngine(renderEngine), mEnabled(false), mMemoryBudget(memoryBudget) {}
 
     virtual ~TexturePool() = default;
 
@@ -73,12 +87,19 @@ public:
     // setDisplaySize must be called for the texture pool to be used.
     void setDisplaySize(ui::Size size);
 
-    // Borrows a new texture from the pool.
+    // Borrows a new screen-sized texture from the pool.
     // If the pool is currently starved of textures, then a new texture is generated.
     // When the AutoTexture object is destroyed, the scratch texture is automatically returned
     // to the pool.
     std::shared_ptr<AutoTexture> borrowTexture();
 
+    // Borrows a texture at least as large as size, which is clamped to the display size.
+    std::shared_ptr<AutoTexture> borrowTexture(ui::Size size);
+
+    // Records whether cached sets were used to compose a frame. The pool shrinks once they are
+    // rarely used, and regrows when textures are needed again.
+    void recordFrame(bool usedCachedSets);
+
     // Enables or disables the pool. When the pool is disabled, no buffers will
     // be held by the pool. This is useful when the active display changes.
     void setEnabled(bool enable);
@@ -90,6 +111,14 @@ protected:
     const static constexpr size_t kMinPoolSize = 3;
     const static constexpr size_t kMaxPoolSize = 4;
 
+    // Borrowed sizes are rounded up to a multiple of 1/kSizeBuckets of the display size.
+    const static constexpr int32_t kSizeBuckets = 4;
+
+    // Every kHitRateWindow frames, the pool releases an idle texture if less than
+    // kMinHitRatePercent of these frames used cached sets.
+    const static constexpr size_t kHitRateWindow = 300;
+    const static constexpr size_t kMinHitRatePercent = 10;
+
     struct Entry {
         std::shared_ptr<renderengine::ExternalTexture> texture;
         sp<Fence> fence;
@@ -97,15 +126,38 @@ protected:
 
     std::deque<Entry> mPool;
 
+    // How many textures the pool currently retains at most.
+    size_t mTargetPoolSize = kMinPoolSize;
+
+    ui::Size getBucketSize(ui::Size size) const;
+
+    // Memory held by textures in the pool and borrowed from it, in bytes.
+    size_t getPoolMemory() const;
+    size_t mBorrowedMemory = 0;
+
 private:
-    std::shared_ptr<renderengine::ExternalTexture> genTexture();
+    std::shared_ptr<renderengine::ExternalTexture> genTexture(ui::Size size);
     // Returns a previously borrowed texture to the pool.
     void returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
-                       const sp<Fence>& fence);
+                       const sp<Fence>& fence, uint32_t generation);
     void allocatePool();
+    // Whether one more texture of the given size can be retained.
+    bool canRetain(size_t textureMemory) const;
     renderengine::RenderEngine& mRenderEngine;
     ui::Size mSize;
     bool mEnabled;
+    const size_t mMemoryBudget;
+
+    // Incremented whenever the display size changes, so that textures allocated for a previous
+    // display size are not returned to the pool.
+    uint32_t mGeneration = 0;
+
+    size_t mWindowFrames = 0;
+    size_t mWindowHits = 0;
+
+    // Statistics
+    size_t mBorrowCount = 0;
+    size_t mAllocationCount = 0;
 };
 
 } // namespace android::compositionengine::impl::planner
@@ -84,6 +84,11 @@ public:
                  ftl::Future<std::monostate>(const compositionengine::CompositionRefreshArgs&));
     MOCK_CONST_METHOD0(supportsOffloadPresent, bool());
     MOCK_METHOD(void, offloadPresentNextFrame, ());
+    MOCK_METHOD(ftl::Future<std::monostate>, presentPipelinedFrame,
+                (const compositionengine::CompositionRefreshArgs&));
+    MOCK_METHOD(ftl::Future<std::monostate>, prepareCompositionState,
+                (const compositionengine::CompositionRefreshArgs&));
+    MOCK_METHOD(void, offloadCompositionStateNextFrame, ());
 
     MOCK_METHOD1(uncacheBuffers, void(const std::vector<uint64_t>&));
     MOCK_METHOD2(rebuildLayerStacks,
@@ -133,6 +138,7 @@ public:
     MOCK_METHOD1(cacheClientCompositionRequests, void(uint32_t));
     MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
     MOCK_METHOD1(setPredictCompositionStrategy, void(bool));
+    MOCK_METHOD1(setPipelineHwcValidate, void(bool));
     MOCK_METHOD1(setTreat170mAsSrgb, void(bool));
     MOCK_METHOD(void, setHintSessionGpuFence, (std::unique_ptr<FenceTime> && gpuFence));
     MOCK_METHOD(bool, isPowerHintSessionEnabled, ());
@@ -15,6 +15,8 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include <compositionengine/impl/ClientCompositionRequestCache.h>
 #include <renderengine/DisplaySettings.h>
@@ -64,6 +66,31 @@ bool layerSettingsAreEqual(const LayerFE::LayerSettings& lhs, const LayerFE::Lay
             equalIgnoringBuffer(lhs, rhs);
 }
 
+// Blurs sample what is drawn around them, so they can only be drawn along with everything else.
+bool hasBlur(const renderengine::LayerSettings& layer) {
+    return layer.backgroundBlurRadius > 0 || !layer.blurRegions.empty();
+}
+
+// Whether everything the layer draws is within its geometry.
+bool drawsWithinBounds(const renderengine::LayerSettings& layer) {
+    return layer.shadow.length <= 0.f && !layer.stretchEffect.hasEffect();
+}
+
+// Accumulates the bounds of the layer in layer stack space into bounds.
+void addBounds(const renderengine::LayerSettings& layer, FloatRect& bounds) {
+    const FloatRect& boundaries = layer.geometry.boundaries;
+    for (const vec2& corner : {vec2(boundaries.left, boundaries.top),
+                               vec2(boundaries.right, boundaries.top),
+                               vec2(boundaries.left, boundaries.bottom),
+                               vec2(boundaries.right, boundaries.bottom)}) {
+        const vec4 position = layer.geometry.positionTransform * vec4(corner, 0.f, 1.f);
+        bounds.left = std::min(bounds.left, position.x);
+        bounds.top = std::min(bounds.top, position.y);
+        bounds.right = std::max(bounds.right, position.x);
+        bounds.bottom = std::max(bounds.bottom, position.y);
+    }
+}
+
 } // namespace
 
 ClientCompositionRequestCache::ClientCompositionRequest::ClientCompositionRequest(
@@ -84,6 +111,55 @@ bool ClientCompositionRequestCache::ClientCompositionRequest::equals(
                        newLayerSettings.end(), layerSettingsAreEqual);
 }
 
+std::optional<Rect> ClientCompositionRequestCache::ClientCompositionRequest::getDamage(
+        const renderengine::DisplaySettings& newDisplay,
+        const std::vector<LayerFE::LayerSettings>& newLayerSettings) const {
+    if (!(newDisplay == display) || newLayerSettings.size() != layerSettings.size()) {
+        return std::nullopt;
+    }
+
+    FloatRect damage(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                     std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+    bool hasDamage = false;
+    for (size_t i = 0; i < layerSettings.size(); i++) {
+        const LayerFE::LayerSettings& cached = layerSettings[i];
+        const LayerFE::LayerSettings& current = newLayerSettings[i];
+        if (hasBlur(cached) || hasBlur(current)) {
+            return std::nullopt;
+        }
+        if (layerSettingsAreEqual(cached, current)) {
+            continue;
+        }
+        if (!drawsWithinBounds(cached) || !drawsWithinBounds(current)) {
+            return std::nullopt;
+        }
+        addBounds(cached, damage);
+        addBounds(current, damage);
+        hasDamage = true;
+    }
+
+    if (!hasDamage) {
+        return std::nullopt;
+    }
+
+    // Round outwards, and leave room for antialiased edges.
+    return Rect(static_cast<int32_t>(std::floor(damage.left)) - 1,
+                static_cast<int32_t>(std::floor(damage.top)) - 1,
+                static_cast<int32_t>(std::ceil(damage.right)) + 1,
+                static_cast<int32_t>(std::ceil(damage.bottom)) + 1);
+}
+
+std::optional<Rect> ClientCompositionRequestCache::getDamage(
+        uint64_t bufferId, const renderengine::DisplaySettings& display,
+        const std::vector<LayerFE::LayerSettings>& layerSettings) const {
+    for (const auto& [cachedBufferId, cachedRequest] : mCache) {
+        if (cachedBufferId == bufferId) {
+            return cachedRequest.getDamage(display, layerSettings);
+        }
+    }
+    return std::nullopt;
+}
+
 bool ClientCompositionRequestCache::exists(
         uint64_t bufferId, const renderengine::DisplaySettings& display,
         const std::vector<LayerFE::LayerSettings>& layerSettings) const {
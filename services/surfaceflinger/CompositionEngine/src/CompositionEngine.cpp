@@ -25,6 +25,8 @@
 #include <renderengine/RenderEngine.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
+
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -90,9 +92,11 @@ nsecs_t CompositionEngine::getLastFrameRefreshTimestamp() const {
 }
 
 namespace {
-void offloadOutputs(Outputs& outputs) {
-    if (!FlagManager::getInstance().multithreaded_present() || outputs.size() < 2) {
-        return;
+// Returns the outputs that may run on another thread this frame. The last eligible output is
+// left out so it can run on the main thread without an extra thread hop.
+ui::PhysicalDisplayVector<compositionengine::Output*> getOutputsToOffload(const Outputs& outputs) {
+    if (outputs.size() < 2) {
+        return {};
     }
 
     ui::PhysicalDisplayVector<compositionengine::Output*> outputsToOffload;
@@ -108,22 +112,60 @@ void offloadOutputs(Outputs& outputs) {
         // Only run present in multiple threads if all HWC-enabled displays
         // being refreshed support it.
         if (!output->supportsOffloadPresent()) {
-            return;
+            return {};
         }
         outputsToOffload.push_back(output.get());
     }
 
     if (outputsToOffload.size() < 2) {
-        return;
+        return {};
     }
 
     // Leave the last eligible display on the main thread, which will
     // allow it to run concurrently without an extra thread hop.
     outputsToOffload.pop_back();
+    return outputsToOffload;
+}
+
+ui::PhysicalDisplayVector<compositionengine::Output*> offloadOutputs(Outputs& outputs) {
+    if (!FlagManager::getInstance().multithreaded_present()) {
+        return {};
+    }
 
+    auto outputsToOffload = getOutputsToOffload(outputs);
     for (compositionengine::Output* output : outputsToOffload) {
         output->offloadPresentNextFrame();
     }
+    return outputsToOffload;
+}
+
+// Updates and writes the composition state of all outputs ahead of presenting them, with the
+// offloaded outputs doing so on their own worker threads. The outputs only touch their own
+// layers' state and their own HWC display, which is what makes offloading present safe too.
+// All of them must be done before the first output is presented, which validates with HWC.
+void prepareCompositionState(const CompositionRefreshArgs& args) {
+    const auto outputsToOffload = getOutputsToOffload(args.outputs);
+    if (outputsToOffload.empty()) {
+        return;
+    }
+
+    ATRACE_CALL();
+    ui::DisplayVector<ftl::Future<std::monostate>> futures;
+    for (compositionengine::Output* output : outputsToOffload) {
+        output->offloadCompositionStateNextFrame();
+        futures.push_back(output->prepareCompositionState(args));
+    }
+
+    for (const auto& output : args.outputs) {
+        if (std::find(outputsToOffload.begin(), outputsToOffload.end(), output.get()) ==
+            outputsToOffload.end()) {
+            futures.push_back(output->prepareCompositionState(args));
+        }
+    }
+
+    for (auto& future : futures) {
+        future.get();
+    }
 }
 } // namespace
 
@@ -144,16 +186,26 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
         }
     }
 
+    if (args.parallelCompositionState) {
+        prepareCompositionState(args);
+    }
+
     // Offloading the HWC call for `present` allows us to simultaneously call it
     // on multiple displays. This is desirable because these calls block and can
     // be slow.
-    offloadOutputs(args.outputs);
+    const auto offloadedOutputs = offloadOutputs(args.outputs);
 
     ui::DisplayVector<ftl::Future<std::monostate>> presentFutures;
     for (const auto& output : args.outputs) {
         presentFutures.push_back(output->present(args));
     }
 
+    // Offloaded outputs may have left HWC validate running on their worker. Their frames are
+    // finished once every output has been presented, and then presented on the worker as well.
+    for (compositionengine::Output* output : offloadedOutputs) {
+        presentFutures.push_back(output->presentPipelinedFrame(args));
+    }
+
     {
         ATRACE_NAME("Waiting on HWC");
         for (auto& future : presentFutures) {
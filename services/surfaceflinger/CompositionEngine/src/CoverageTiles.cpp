@@ -0,0 +1,174 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <compositionengine/CoverageTiles.h>
+
+namespace android::compositionengine {
+namespace {
+
+// Layer rects can be far outside of the output, so the arithmetic is done in 64 bits to avoid
+// overflowing the edges of rects such as Rect::INVALID_RECT.
+bool isEmpty(const Rect& rect) {
+    return int64_t{rect.right} <= int64_t{rect.left} || int64_t{rect.bottom} <= int64_t{rect.top};
+}
+
+bool isWithin(const Rect& rect, const Rect& bounds) {
+    return rect.left >= bounds.left && rect.top >= bounds.top && rect.right <= bounds.right &&
+            rect.bottom <= bounds.bottom;
+}
+
+// The columns [first, last] of a grid row.
+uint64_t columnMask(size_t first, size_t last) {
+    return (~uint64_t{0} >> (CoverageTiles::kGridSize - 1 - last)) & (~uint64_t{0} << first);
+}
+
+} // namespace
+
+void CoverageTiles::setBounds(const Rect& bounds) {
+    mCovered.fill(0);
+    mOpaque.fill(0);
+    mCoveredOutsideBounds = false;
+
+    if (isEmpty(bounds)) {
+        mBounds = Rect::EMPTY_RECT;
+        mTileWidth = 0;
+        mTileHeight = 0;
+        return;
+    }
+
+    constexpr auto kGridSize64 = static_cast<int64_t>(kGridSize);
+    mBounds = bounds;
+    mTileWidth = (int64_t{bounds.right} - bounds.left + kGridSize64 - 1) / kGridSize64;
+    mTileHeight = (int64_t{bounds.bottom} - bounds.top + kGridSize64 - 1) / kGridSize64;
+}
+
+void CoverageTiles::addCovered(const Rect& rect) {
+    if (!isEnabled() || isEmpty(rect)) {
+        return;
+    }
+
+    if (!isWithin(rect, mBounds)) {
+        mCoveredOutsideBounds = true;
+    }
+
+    Span span;
+    if (!getOverlappedTiles(rect, &span)) {
+        return;
+    }
+    for (size_t row = span.firstRow; row <= span.lastRow; row++) {
+        mCovered[row] |= span.columns;
+    }
+}
+
+void CoverageTiles::addOpaque(const Rect& rect) {
+    if (!isEnabled() || isEmpty(rect)) {
+        return;
+    }
+
+    Span span;
+    if (!getContainedTiles(rect, &span)) {
+        return;
+    }
+    for (size_t row = span.firstRow; row <= span.lastRow; row++) {
+        mOpaque[row] |= span.columns;
+    }
+}
+
+bool CoverageTiles::isUncovered(const Rect& rect) const {
+    if (!isEnabled()) {
+        return false;
+    }
+    if (isEmpty(rect)) {
+        return true;
+    }
+    if (mCoveredOutsideBounds && !isWithin(rect, mBounds)) {
+        return false;
+    }
+
+    Span span;
+    if (!getOverlappedTiles(rect, &span)) {
+        return true;
+    }
+    uint64_t covered = 0;
+    for (size_t row = span.firstRow; row <= span.lastRow; row++) {
+        covered |= mCovered[row] & span.columns;
+    }
+    return covered == 0;
+}
+
+bool CoverageTiles::isOpaque(const Rect& rect) const {
+    if (!isEnabled() || isEmpty(rect) || !isWithin(rect, mBounds)) {
+        return false;
+    }
+
+    Span span;
+    if (!getOverlappedTiles(rect, &span)) {
+        return false;
+    }
+    uint64_t opaque = span.columns;
+    for (size_t row = span.firstRow; row <= span.lastRow; row++) {
+        opaque &= mOpaque[row];
+    }
+    return opaque == span.columns;
+}
+
+bool CoverageTiles::getOverlappedTiles(const Rect& rect, Span* span) const {
+    const int64_t left = std::max(rect.left, mBounds.left) - int64_t{mBounds.left};
+    const int64_t top = std::max(rect.top, mBounds.top) - int64_t{mBounds.top};
+    const int64_t right = std::min(rect.right, mBounds.right) - int64_t{mBounds.left};
+    const int64_t bottom = std::min(rect.bottom, mBounds.bottom) - int64_t{mBounds.top};
+    if (right <= left || bottom <= top) {
+        return false;
+    }
+
+    span->firstRow = static_cast<size_t>(top / mTileHeight);
+    span->lastRow = static_cast<size_t>((bottom - 1) / mTileHeight);
+    span->columns = columnMask(static_cast<size_t>(left / mTileWidth),
+                               static_cast<size_t>((right - 1) / mTileWidth));
+    return true;
+}
+
+bool CoverageTiles::getContainedTiles(const Rect& rect, Span* span) const {
+    const int64_t width = int64_t{mBounds.right} - mBounds.left;
+    const int64_t height = int64_t{mBounds.bottom} - mBounds.top;
+    const int64_t left = std::max(rect.left, mBounds.left) - int64_t{mBounds.left};
+    const int64_t top = std::max(rect.top, mBounds.top) - int64_t{mBounds.top};
+    const int64_t right = std::min(rect.right, mBounds.right) - int64_t{mBounds.left};
+    const int64_t bottom = std::min(rect.bottom, mBounds.bottom) - int64_t{mBounds.top};
+    if (right <= left || bottom <= top) {
+        return false;
+    }
+
+    // The last row and column of tiles are cut short by the bounds, so they are contained once
+    // the rect reaches the edge of the bounds.
+    const int64_t firstColumn = (left + mTileWidth - 1) / mTileWidth;
+    const int64_t lastColumn = right == width ? (width - 1) / mTileWidth : right / mTileWidth - 1;
+    const int64_t firstRow = (top + mTileHeight - 1) / mTileHeight;
+    const int64_t lastRow = bottom == height ? (height - 1) / mTileHeight : bottom / mTileHeight - 1;
+    if (lastColumn < firstColumn || lastRow < firstRow) {
+        return false;
+    }
+
+    span->firstRow = static_cast<size_t>(firstRow);
+    span->lastRow = static_cast<size_t>(lastRow);
+    span->columns =
+            columnMask(static_cast<size_t>(firstColumn), static_cast<size_t>(lastColumn));
+    return true;
+}
+
+} // namespace android::compositionengine
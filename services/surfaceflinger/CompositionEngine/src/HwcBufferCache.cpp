@@ -16,24 +16,40 @@
 
 #include <compositionengine/impl/HwcBufferCache.h>
 
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
 #include <gui/BufferQueue.h>
 #include <ui/GraphicBuffer.h>
 
+#include <algorithm>
+#include <cinttypes>
+
 namespace android::compositionengine::impl {
 
-HwcBufferCache::HwcBufferCache() {
-    for (uint32_t i = kMaxLayerBufferCount; i-- > 0;) {
+uint32_t HwcBufferCache::getDefaultSlotBudget() {
+    static const uint32_t sDefaultSlotBudget =
+            base::GetUintProperty<uint32_t>(std::string("debug.sf.hwc_layer_buffer_slot_budget"),
+                                            kMaxLayerBufferCount, kMaxLayerBufferCount);
+    return sDefaultSlotBudget;
+}
+
+HwcBufferCache::HwcBufferCache() : HwcBufferCache(getDefaultSlotBudget()) {}
+
+HwcBufferCache::HwcBufferCache(uint32_t slotBudget)
+      : mSlotBudget(std::clamp(slotBudget, 1u, static_cast<uint32_t>(kMaxLayerBufferCount))) {
+    for (uint32_t i = mSlotBudget; i-- > 0;) {
         mFreeSlots.push(i);
     }
 }
 
 HwcSlotAndBuffer HwcBufferCache::getHwcSlotAndBuffer(const sp<GraphicBuffer>& buffer) {
-    if (auto i = mCacheByBufferId.find(buffer->getId()); i != mCacheByBufferId.end()) {
-        Cache& cache = i->second;
+    if (auto i = mSlotByBufferId.find(buffer->getId()); i != mSlotByBufferId.end()) {
         // mark this cache slot as more recently used so it won't get evicted anytime soon
-        cache.lruCounter = mLeastRecentlyUsedCounter++;
-        return {cache.slot, nullptr};
+        markMostRecentlyUsed(i->second);
+        ++mStats.hits;
+        return {i->second, nullptr};
     }
+    ++mStats.misses;
     return {cache(buffer), buffer};
 }
 
@@ -46,45 +62,86 @@ HwcSlotAndBuffer HwcBufferCache::getOverrideHwcSlotAndBuffer(const sp<GraphicBuf
 }
 
 uint32_t HwcBufferCache::uncache(uint64_t bufferId) {
-    if (auto i = mCacheByBufferId.find(bufferId); i != mCacheByBufferId.end()) {
-        uint32_t slot = i->second.slot;
-        mCacheByBufferId.erase(i);
+    if (auto i = mSlotByBufferId.find(bufferId); i != mSlotByBufferId.end()) {
+        uint32_t slot = i->second;
+        mSlotByBufferId.erase(i);
+        unlink(slot);
+        mSlots[slot].buffer = nullptr;
         mFreeSlots.push(slot);
+        ++mStats.uncaches;
         return slot;
     }
     if (mLastOverrideBuffer && bufferId == mLastOverrideBuffer->getId()) {
         mLastOverrideBuffer = nullptr;
+        ++mStats.uncaches;
         return kOverrideBufferSlot;
     }
     return UINT32_MAX;
 }
 
+void HwcBufferCache::dump(std::string& out) const {
+    base::StringAppendF(&out,
+                        "%zu/%u slots, %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+                        " evictions, %" PRIu64 " uncaches",
+                        getCachedBufferCount(), mSlotBudget, mStats.hits, mStats.misses,
+                        mStats.evictions, mStats.uncaches);
+}
+
 uint32_t HwcBufferCache::cache(const sp<GraphicBuffer>& buffer) {
-    Cache cache;
-    cache.slot = getLeastRecentlyUsedSlot();
-    cache.lruCounter = mLeastRecentlyUsedCounter++;
-    cache.buffer = buffer;
-    mCacheByBufferId.emplace(buffer->getId(), cache);
-    return cache.slot;
+    const uint32_t slot = getLeastRecentlyUsedSlot();
+    mSlots[slot].buffer = buffer;
+    markMostRecentlyUsed(slot);
+    mSlotByBufferId.emplace(buffer->getId(), slot);
+    return slot;
 }
 
 uint32_t HwcBufferCache::getLeastRecentlyUsedSlot() {
     if (mFreeSlots.empty()) {
-        assert(!mCacheByBufferId.empty());
+        assert(mLeastRecentlyUsedSlot != kInvalidSlot);
         // evict the least recently used cache entry
-        auto cacheToErase = mCacheByBufferId.begin();
-        for (auto i = cacheToErase; i != mCacheByBufferId.end(); ++i) {
-            if (i->second.lruCounter < cacheToErase->second.lruCounter) {
-                cacheToErase = i;
-            }
-        }
-        uint32_t slot = cacheToErase->second.slot;
-        mCacheByBufferId.erase(cacheToErase);
-        mFreeSlots.push(slot);
+        uint32_t slot = mLeastRecentlyUsedSlot;
+        unlink(slot);
+        mSlotByBufferId.erase(mSlots[slot].buffer->getId());
+        mSlots[slot].buffer = nullptr;
+        ++mStats.evictions;
+        return slot;
     }
     uint32_t slot = mFreeSlots.top();
     mFreeSlots.pop();
     return slot;
 }
 
+void HwcBufferCache::markMostRecentlyUsed(uint32_t slot) {
+    if (slot == mMostRecentlyUsedSlot) {
+        return;
+    }
+    unlink(slot);
+
+    Slot& entry = mSlots[slot];
+    entry.lessRecentlyUsed = mMostRecentlyUsedSlot;
+    if (mMostRecentlyUsedSlot != kInvalidSlot) {
+        mSlots[mMostRecentlyUsedSlot].moreRecentlyUsed = slot;
+    }
+    mMostRecentlyUsedSlot = slot;
+    if (mLeastRecentlyUsedSlot == kInvalidSlot) {
+        mLeastRecentlyUsedSlot = slot;
+    }
+}
+
+void HwcBufferCache::unlink(uint32_t slot) {
+    Slot& entry = mSlots[slot];
+    if (entry.moreRecentlyUsed != kInvalidSlot) {
+        mSlots[entry.moreRecentlyUsed].lessRecentlyUsed = entry.lessRecentlyUsed;
+    } else if (mMostRecentlyUsedSlot == slot) {
+        mMostRecentlyUsedSlot = entry.lessRecentlyUsed;
+    }
+    if (entry.lessRecentlyUsed != kInvalidSlot) {
+        mSlots[entry.lessRecentlyUsed].moreRecentlyUsed = entry.moreRecentlyUsed;
+    } else if (mLeastRecentlyUsedSlot == slot) {
+        mLeastRecentlyUsedSlot = entry.moreRecentlyUsed;
+    }
+    entry.moreRecentlyUsed = kInvalidSlot;
+    entry.lessRecentlyUsed = kInvalidSlot;
+}
+
 } // namespace android::compositionengine::impl
@@ -35,8 +35,11 @@
 #include <scheduler/FrameTargeter.h>
 #include <scheduler/Time.h>
 
+#include <cinttypes>
+#include <memory>
 #include <optional>
 #include <thread>
+#include <utility>
 
 #include "renderengine/ExternalTexture.h"
 
@@ -323,12 +326,28 @@ void Output::dumpBase(std::string& out) const {
     }
 
     base::StringAppendF(&out, "\n   %zu Layers\n", getOutputLayerCount());
+    size_t cachedBufferCount = 0;
+    size_t slotBudget = 0;
+    HwcBufferCache::Stats bufferCacheStats;
     for (const auto* outputLayer : getOutputLayersOrderedByZ()) {
         if (!outputLayer) {
             continue;
         }
         outputLayer->dump(out);
+
+        if (const auto& hwc = outputLayer->getState().hwc) {
+            cachedBufferCount += hwc->hwcBufferCache.getCachedBufferCount();
+            slotBudget += hwc->hwcBufferCache.getSlotBudget();
+            bufferCacheStats += hwc->hwcBufferCache.getStats();
+        }
     }
+
+    base::StringAppendF(&out,
+                        "\n   HWC buffer cache: %zu/%zu slots, %" PRIu64 " hits, %" PRIu64
+                        " misses, %" PRIu64 " evictions, %" PRIu64 " uncaches\n",
+                        cachedBufferCount, slotBudget, bufferCacheStats.hits,
+                        bufferCacheStats.misses, bufferCacheStats.evictions,
+                        bufferCacheStats.uncaches);
 }
 
 void Output::dumpPlannerInfo(const Vector<String16>& args, std::string& out) const {
@@ -457,10 +476,9 @@ ftl::Future<std::monostate> Output::present(
                   stringifyExpectedPresentTime().c_str());
     ALOGV(__FUNCTION__);
 
-    updateColorProfile(refreshArgs);
-    updateCompositionState(refreshArgs);
-    planComposition();
-    writeCompositionState(refreshArgs);
+    if (!std::exchange(mCompositionStatePrepared, false)) {
+        updateAndWriteCompositionState(refreshArgs);
+    }
     setColorTransform(refreshArgs);
     beginFrame();
 
@@ -468,6 +486,8 @@ ftl::Future<std::monostate> Output::present(
     const bool predictCompositionStrategy = canPredictCompositionStrategy(refreshArgs);
     if (predictCompositionStrategy) {
         result = prepareFrameAsync();
+    } else if (canPipelineHwcValidate(refreshArgs)) {
+        return presentFramePipelined(refreshArgs);
     } else {
         prepareFrame();
     }
@@ -496,6 +516,36 @@ void Output::offloadPresentNextFrame() {
     updateHwcAsyncWorker();
 }
 
+ftl::Future<std::monostate> Output::prepareCompositionState(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    mCompositionStatePrepared = true;
+    if (mOffloadCompositionState) {
+        // Only offload for this frame, like present. The worker stays in place for the next one.
+        mOffloadCompositionState = false;
+        return ftl::Future<bool>(std::move(mHwComposerAsyncWorker->send([this, &refreshArgs]() {
+                   updateAndWriteCompositionState(refreshArgs);
+                   return true;
+               })))
+                .then([](bool) { return std::monostate{}; });
+    }
+
+    updateAndWriteCompositionState(refreshArgs);
+    return ftl::yield<std::monostate>({});
+}
+
+void Output::offloadCompositionStateNextFrame() {
+    mOffloadCompositionState = true;
+    updateHwcAsyncWorker();
+}
+
+void Output::updateAndWriteCompositionState(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) {
+    updateColorProfile(refreshArgs);
+    updateCompositionState(refreshArgs);
+    planComposition();
+    writeCompositionState(refreshArgs);
+}
+
 void Output::uncacheBuffers(std::vector<uint64_t> const& bufferIdsToUncache) {
     if (bufferIdsToUncache.empty()) {
         return;
@@ -521,6 +571,7 @@ void Output::rebuildLayerStacks(const compositionengine::CompositionRefreshArgs&
     coverage.aboveCoveredLayersExcludingOverlays = refreshArgs.hasTrustedPresentationListener
             ? std::make_optional<Region>()
             : std::nullopt;
+    coverage.tiles.setBounds(outputState.layerStackSpace.getContent());
     collectVisibleLayers(refreshArgs, coverage);
 
     // Compute the resulting coverage for this output, and store it for later
@@ -630,22 +681,33 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     // TODO(b/121291683): Is it worth creating helper methods on LayerFEState
     // for computations like this?
     const Rect visibleRect(tr.transform(layerFEState->geomLayerBounds));
-    visibleRegion.set(visibleRect);
+    Rect visibleBounds(visibleRect);
 
     if (layerFEState->shadowSettings.length > 0.0f) {
         // if the layer casts a shadow, offset the layers visible region and
         // calculate the shadow region.
         const auto inset = static_cast<int32_t>(ceilf(layerFEState->shadowSettings.length) * -1.0f);
-        Rect visibleRectWithShadows(visibleRect);
-        visibleRectWithShadows.inset(inset, inset, inset, inset);
-        visibleRegion.set(visibleRectWithShadows);
+        visibleBounds.inset(inset, inset, inset, inset);
+        visibleRegion.set(visibleBounds);
         shadowRegion = visibleRegion.subtract(visibleRect);
+    } else {
+        visibleRegion.set(visibleRect);
     }
 
     if (visibleRegion.isEmpty()) {
         return;
     }
 
+    // The layer is hidden behind opaque layers above it. As the covered area
+    // always includes the opaque area, the coverage is unchanged by this layer.
+    if (!computeAboveCoveredExcludingOverlays && coverage.tiles.isOpaque(visibleBounds)) {
+        return;
+    }
+
+    // Nothing above overlaps this layer, so neither the covered nor the opaque
+    // layers above need to be intersected with or subtracted from it.
+    const bool uncovered = coverage.tiles.isUncovered(visibleBounds);
+
     // Remove the transparent area from the visible region
     if (!layerFEState->isOpaque) {
         if (tr.preserveRects()) {
@@ -691,10 +753,13 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     }
 
     // Clip the covered region to the visible region
-    coveredRegion = coverage.aboveCoveredLayers.intersect(visibleRegion);
+    if (!uncovered) {
+        coveredRegion = coverage.aboveCoveredLayers.intersect(visibleRegion);
+    }
 
     // Update accumAboveCoveredLayers for next (lower) layer
     coverage.aboveCoveredLayers.orSelf(visibleRegion);
+    coverage.tiles.addCovered(visibleBounds);
 
     if (CC_UNLIKELY(computeAboveCoveredExcludingOverlays)) {
         coveredRegionExcludingDisplayOverlays =
@@ -703,7 +768,9 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     }
 
     // subtract the opaque region covered by the layers above us
-    visibleRegion.subtractSelf(coverage.aboveOpaqueLayers);
+    if (!uncovered) {
+        visibleRegion.subtractSelf(coverage.aboveOpaqueLayers);
+    }
 
     if (visibleRegion.isEmpty()) {
         return;
@@ -748,13 +815,23 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
         const Region oldExposed = oldVisibleRegion - oldCoveredRegion;
         dirty = (visibleRegion & oldCoveredRegion) | (newExposed - oldExposed);
     }
-    dirty.subtractSelf(coverage.aboveOpaqueLayers);
+    // When the content is dirty, the dirty region also includes the old visible
+    // region, which may be under opaque layers even if the new bounds are not.
+    const bool dirtyUncovered = uncovered &&
+            (!layerFEState->contentDirty ||
+             coverage.tiles.isUncovered(oldVisibleRegion.getBounds()));
+    if (!dirtyUncovered) {
+        dirty.subtractSelf(coverage.aboveOpaqueLayers);
+    }
 
     // accumulate to the screen dirty region
     coverage.dirtyRegion.orSelf(dirty);
 
     // Update accumAboveOpaqueLayers for next (lower) layer
     coverage.aboveOpaqueLayers.orSelf(opaqueRegion);
+    if (!opaqueRegion.isEmpty()) {
+        coverage.tiles.addOpaque(visibleRect);
+    }
 
     // Compute the visible non-transparent region
     Region visibleNonTransparentRegion = visibleRegion.subtract(transparentRegion);
@@ -1137,6 +1214,12 @@ void Output::prepareFrame() {
 
     std::optional<android::HWComposer::DeviceRequestedChanges> changes;
     bool success = chooseCompositionStrategy(&changes);
+    applyChosenCompositionStrategy(success, changes);
+}
+
+void Output::applyChosenCompositionStrategy(
+        bool success, const std::optional<android::HWComposer::DeviceRequestedChanges>& changes) {
+    auto& outputState = editState();
     resetCompositionStrategy();
     outputState.strategyPrediction = CompositionStrategyPredictionState::DISABLED;
     outputState.previousDeviceRequestedChanges = changes;
@@ -1155,6 +1238,69 @@ ftl::Future<std::monostate> Output::presentFrameAndReleaseLayersAsync() {
             .then([](bool) { return std::monostate{}; });
 }
 
+bool Output::canPipelineHwcValidate(const CompositionRefreshArgs& refreshArgs) {
+    // Validate only moves to the worker on frames that also offload present, so that the
+    // HWC calls for this display keep their order and stay off the main thread together.
+    if (!mPipelineHwcValidate || !mOffloadPresent || !getState().isEnabled) {
+        return false;
+    }
+
+    if (refreshArgs.devOptFlashDirtyRegionsDelay) {
+        return false;
+    }
+
+    // A pipelined frame is composed only once the other outputs have been presented. For
+    // client composition, starting the GPU that late costs more than validating early saves.
+    if (anyLayersRequireClientComposition()) {
+        return false;
+    }
+
+    // If HWC changed composition types last frame, it is likely to fall back to client
+    // composition again.
+    const auto& previousChanges = getState().previousDeviceRequestedChanges;
+    if (previousChanges && !previousChanges->changedTypes.empty()) {
+        return false;
+    }
+
+    return true;
+}
+
+ftl::Future<std::monostate> Output::presentFramePipelined(const CompositionRefreshArgs&) {
+    ATRACE_CALL();
+    ALOGV(__FUNCTION__);
+
+    // Like an offloaded present, this only applies to this frame.
+    mOffloadPresent = false;
+
+    // Only validate runs on the worker for now. Applying its result and finishing the frame touch
+    // state shared with the other outputs, such as the PowerAdvisor and the RenderEngine, so
+    // presentPipelinedFrame does them on the main thread once every output has been presented.
+    auto& frame = mPipelinedFrame.emplace();
+    frame.validate = chooseCompositionStrategyAsync(&frame.changes);
+    return ftl::yield<std::monostate>({});
+}
+
+ftl::Future<std::monostate> Output::presentPipelinedFrame(
+        const CompositionRefreshArgs& refreshArgs) {
+    if (!mPipelinedFrame) {
+        return ftl::yield<std::monostate>({});
+    }
+
+    ATRACE_FORMAT("%s for %s", __func__, mNamePlusId.c_str());
+    ALOGV(__FUNCTION__);
+    // The worker writes the changes until validate is done.
+    const bool success = mPipelinedFrame->validate.get();
+    applyChosenCompositionStrategy(success, mPipelinedFrame->changes);
+    mPipelinedFrame.reset();
+    finishFrame({});
+
+    // Present goes back to the worker, which keeps the HWC calls for this display in order. It is
+    // not waited upon here, so that it overlaps with the other outputs' presents.
+    auto future = presentFrameAndReleaseLayersAsync();
+    renderCachedSets(refreshArgs);
+    return future;
+}
+
 std::future<bool> Output::chooseCompositionStrategyAsync(
         std::optional<android::HWComposer::DeviceRequestedChanges>* changes) {
     return mHwComposerAsyncWorker->send(
@@ -1370,8 +1516,27 @@ std::optional<base::unique_fd> Output::composeSurfaces(
             return base::unique_fd(std::move(fd));
         }
         ATRACE_NAME("ClientCompositionCacheMiss");
+        const auto damage =
+                mClientCompositionRequestCache->getDamage(tex->getBuffer()->getId(),
+                                                          clientCompositionDisplay,
+                                                          clientCompositionLayers);
         mClientCompositionRequestCache->add(tex->getBuffer()->getId(), clientCompositionDisplay,
                                             clientCompositionLayers);
+
+        // If only some layers changed since the buffer was rendered, the rest of the buffer
+        // already holds what would be drawn there, so only redraw around the changed layers.
+        if (damage) {
+            ATRACE_NAME("ClientCompositionPartialRedraw");
+            const Rect damageInFramebuffer =
+                    outputState.layerStackSpace.getTransform(outputState.framebufferSpace)
+                            .transform(*damage, true /* roundOutwards */);
+            Rect scissor;
+            if (!damageInFramebuffer.intersect(clientCompositionDisplay.physicalDisplay,
+                                               &scissor)) {
+                scissor = Rect::EMPTY_RECT;
+            }
+            clientCompositionDisplay.scissor = scissor;
+        }
     }
 
     // We boost GPU frequency here because there will be color spaces conversion
@@ -1476,7 +1641,8 @@ std::vector<LayerFE::LayerSettings> Output::generateClientCompositionRequests(
     ALOGV("Rendering client layers");
 
     const auto& outputState = getState();
-    const Region viewportRegion(outputState.layerStackSpace.getContent());
+    const Rect& viewport = outputState.layerStackSpace.getContent();
+    const Region viewportRegion(viewport);
     bool firstLayer = true;
 
     bool disableBlurs = false;
@@ -1488,13 +1654,13 @@ std::vector<LayerFE::LayerSettings> Output::generateClientCompositionRequests(
         auto& layerFE = layer->getLayerFE();
         layerFE.setWasClientComposed(nullptr);
 
-        const Region clip(viewportRegion.intersect(layerState.visibleRegion));
         ALOGV("Layer: %s", layerFE.getDebugName());
-        if (clip.isEmpty()) {
+        if (!layerState.visibleRegion.intersects(viewport)) {
             ALOGV("  Skipping for empty clip");
             firstLayer = false;
             continue;
         }
+        const Region clip(viewportRegion.intersect(layerState.visibleRegion));
 
         disableBlurs |= layerFEState->sidebandStream != nullptr;
 
@@ -1693,8 +1859,13 @@ void Output::setPredictCompositionStrategy(bool predict) {
     updateHwcAsyncWorker();
 }
 
+void Output::setPipelineHwcValidate(bool pipeline) {
+    // The worker is created along with an offloaded present, which pipelining requires.
+    mPipelineHwcValidate = pipeline;
+}
+
 void Output::updateHwcAsyncWorker() {
-    if (mPredictCompositionStrategy || mOffloadPresent) {
+    if (mPredictCompositionStrategy || mOffloadPresent || mOffloadCompositionState) {
         if (!mHwComposerAsyncWorker) {
             mHwComposerAsyncWorker = std::make_unique<HwcAsyncWorker>();
         }
@@ -40,6 +40,10 @@ void dumpHwc(const OutputLayerCompositionState::Hwc& hwc, std::string& out) {
     }
 
     dumpVal(out, "composition", toString(hwc.hwcCompositionType), hwc.hwcCompositionType);
+
+    out.append("buffer cache=[");
+    hwc.hwcBufferCache.dump(out);
+    out.append("] ");
 }
 
 } // namespace
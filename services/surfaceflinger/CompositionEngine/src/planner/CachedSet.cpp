@@ -159,8 +159,8 @@ void CachedSet::updateAge(std::chrono::steady_clock::time_point now) {
 }
 
 void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& texturePool,
-                       const OutputCompositionState& outputState,
-                       bool deviceHandlesColorTransform) {
+                       const OutputCompositionState& outputState, bool deviceHandlesColorTransform,
+                       bool async) {
     ATRACE_CALL();
     if (outputState.powerCallback) {
         outputState.powerCallback->notifyCpuLoadUp();
@@ -263,8 +263,24 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         layerSettings.emplace_back(highlight);
     }
 
-    auto texture = texturePool.borrowTexture();
-    LOG_ALWAYS_FATAL_IF(texture->get()->getBuffer()->initCheck() != OK);
+    // Only the bounds of the cached set need a texture. The bounds are in display space, so the
+    // texture is screen-sized if the framebuffer is scaled.
+    const Rect framebuffer = outputState.framebufferSpace.getBoundsAsRect();
+    Rect textureArea = framebuffer;
+    if (outputState.displaySpace.getBoundsAsRect() == framebuffer &&
+        !framebuffer.intersect(mBounds, &textureArea)) {
+        textureArea = framebuffer;
+    }
+    auto texture =
+            texturePool.borrowTexture(ui::Size(textureArea.getWidth(), textureArea.getHeight()));
+    const auto& buffer = texture->get()->getBuffer();
+    LOG_ALWAYS_FATAL_IF(buffer->initCheck() != OK);
+    const Rect textureBounds =
+            getTextureBoundsOnDisplay(ui::Size(static_cast<int32_t>(buffer->getWidth()),
+                                               static_cast<int32_t>(buffer->getHeight())),
+                                      framebuffer);
+    // Draw the display so that the texture's origin lands on the top-left of its bounds.
+    displaySettings.physicalDisplay.offsetBy(-textureBounds.left, -textureBounds.top);
 
     base::unique_fd bufferFence;
     if (texture->getReadyFence()) {
@@ -275,25 +291,94 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         bufferFence.reset(texture->getReadyFence()->dup());
     }
 
-    auto fenceResult = renderEngine
-                               .drawLayers(displaySettings, layerSettings, texture->get(),
-                                           std::move(bufferFence))
-                               .get();
+    // The layer settings are copied into the draw call, so nothing prepared here needs to outlive
+    // it when the draw is queued asynchronously.
+    PendingRender render{
+            .fenceResult = renderEngine
+                                   .drawLayers(displaySettings, layerSettings, texture->get(),
+                                               std::move(bufferFence))
+                                   .share(),
+            .texture = std::move(texture),
+            .textureBounds = textureBounds,
+            .outputSpace = outputState.framebufferSpace,
+            .outputDataspace = outputDataspace,
+            .orientation = orientation,
+    };
+    if (async) {
+        mPendingRender = std::move(render);
+        return;
+    }
+    finishRender(render.fenceResult.get(), std::move(render));
+}
+
+Rect CachedSet::getTextureBoundsOnDisplay(ui::Size textureSize, const Rect& display) const {
+    // Textures are rounded up in size, so shift them back onto the display where they would
+    // overhang its right or bottom edge.
+    const auto place = [](int32_t start, int32_t length, int32_t displayStart,
+                          int32_t displayEnd) {
+        return std::max(displayStart, std::min(start, displayEnd - length));
+    };
+    const int32_t left = place(mBounds.left, textureSize.getWidth(), display.left, display.right);
+    const int32_t top = place(mBounds.top, textureSize.getHeight(), display.top, display.bottom);
+    return Rect(left, top, left + textureSize.getWidth(), top + textureSize.getHeight());
+}
 
+bool CachedSet::collectPendingRender() {
+    if (!mPendingRender) {
+        return false;
+    }
+    if (mPendingRender->fenceResult.wait_for(std::chrono::seconds::zero()) !=
+        std::future_status::ready) {
+        return false;
+    }
+
+    ATRACE_CALL();
+    PendingRender render = std::move(*mPendingRender);
+    mPendingRender.reset();
+    finishRender(render.fenceResult.get(), std::move(render));
+    return true;
+}
+
+void CachedSet::finishRender(FenceResult fenceResult, PendingRender&& render) {
     if (fenceStatus(fenceResult) == NO_ERROR) {
         mDrawFence = std::move(fenceResult).value_or(Fence::NO_FENCE);
-        mOutputSpace = outputState.framebufferSpace;
-        mTexture = texture;
+        mOutputSpace = render.outputSpace;
+        mTexture = std::move(render.texture);
+        mTextureBounds = render.textureBounds;
         mTexture->setReadyFence(mDrawFence);
-        mOutputSpace.setOrientation(outputState.framebufferSpace.getOrientation());
-        mOutputDataspace = outputDataspace;
-        mOrientation = orientation;
+        mOutputDataspace = render.outputDataspace;
+        mOrientation = render.orientation;
         mSkipCount = 0;
     } else {
         mTexture.reset();
     }
 }
 
+std::optional<CachedSet::RenderedBuffer> CachedSet::getRenderedBuffer() const {
+    if (!hasReadyBuffer()) {
+        return std::nullopt;
+    }
+    return RenderedBuffer{
+            .texture = mTexture,
+            .textureBounds = mTextureBounds,
+            .drawFence = mDrawFence,
+            .outputSpace = mOutputSpace,
+            .outputDataspace = mOutputDataspace,
+            .orientation = mOrientation,
+    };
+}
+
+void CachedSet::adoptRenderedBuffer(RenderedBuffer buffer) {
+    mPendingRender.reset();
+    mTexture = std::move(buffer.texture);
+    mTextureBounds = buffer.textureBounds;
+    mDrawFence = std::move(buffer.drawFence);
+    mOutputSpace = buffer.outputSpace;
+    mOutputDataspace = buffer.outputDataspace;
+    mOrientation = buffer.orientation;
+    mSkipCount = 0;
+}
+
 bool CachedSet::requiresHolePunch() const {
     // In order for the hole punch to be beneficial, the layer must be updating
     // regularly, meaning  it should not have been merged with other layers.
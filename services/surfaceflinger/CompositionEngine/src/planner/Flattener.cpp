@@ -70,14 +70,29 @@ bool isSameStack(const std::vector<const LayerState*>& incomingLayers,
     return true;
 }
 
+// Identifies what is drawn for a layer: nonBufferHash is the hash of its state other than the
+// buffer, which is identified along with the frame that was queued to it.
+size_t getContentHash(size_t nonBufferHash, const LayerState& layer) {
+    size_t hash = nonBufferHash;
+    if (const sp<GraphicBuffer> buffer = layer.getBuffer().promote()) {
+        android::hashCombineSingle(hash, buffer->getId());
+    }
+    android::hashCombineSingle(hash, layer.getFrameNumber());
+    return hash;
+}
+
 } // namespace
 
 Flattener::Flattener(renderengine::RenderEngine& renderEngine, const Tunables& tunables)
-      : mRenderEngine(renderEngine), mTunables(tunables), mTexturePool(mRenderEngine) {}
+      : mRenderEngine(renderEngine),
+        mTunables(tunables),
+        mTexturePool(mRenderEngine, tunables.mTexturePoolMemoryBudget) {}
 
 NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& layers,
                                        NonBufferHash hash, time_point now) {
     ATRACE_CALL();
+    expireReusableCachedSets(now);
+
     const size_t unflattenedDisplayCost = calculateDisplayCost(layers);
     mUnflattenedDisplayCost += unflattenedDisplayCost;
 
@@ -89,11 +104,16 @@ NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& lay
     if (mCurrentGeometry != hash || (!mLayers.empty() && !isSameStack(layers, mLayers))) {
         resetActivities(hash, now);
         mFlattenedDisplayCost += unflattenedDisplayCost;
+        recordFlattenHitRate(layers.size(), 0);
         return hash;
     }
 
     ++mInitialLayerCounts[layers.size()];
 
+    // Pick up a cached set that finished rendering since the last frame, so that it can be
+    // merged below.
+    collectPendingRender();
+
     // Only buildCachedSets if these layers are already stored in mLayers.
     // Otherwise (i.e. mergeWithCachedSets returns false), the time has not
     // changed, so buildCachedSets will never find any runs.
@@ -101,8 +121,20 @@ NonBufferHash Flattener::flattenLayers(const std::vector<const LayerState*>& lay
 
     ++mFinalLayerCounts[mLayers.size()];
 
+    size_t flattenedLayerCount = 0;
+    for (const CachedSet& cachedSet : mLayers) {
+        if (cachedSet.hasRenderedBuffer()) {
+            flattenedLayerCount += cachedSet.getLayerCount();
+        }
+    }
+    recordFlattenHitRate(layers.size(), flattenedLayerCount);
+
     if (alreadyHadCachedSets) {
         buildCachedSets(now);
+    }
+
+    // Cached sets that were reused from before the layer stack changed also flatten the layers.
+    if (alreadyHadCachedSets || flattenedLayerCount > 0) {
         hash = computeLayersHash();
     }
 
@@ -115,10 +147,20 @@ void Flattener::renderCachedSets(
         bool deviceHandlesColorTransform) {
     ATRACE_CALL();
 
+    mOutputSpace = outputState.framebufferSpace;
+    mOutputDataspace = outputState.dataspace;
+
     if (!mNewCachedSet) {
         return;
     }
 
+    // A render that is still in flight will be merged once it completes, so don't queue another.
+    if (mNewCachedSet->hasPendingRender()) {
+        ATRACE_NAME("mNewCachedSet->hasPendingRender()");
+        collectPendingRender();
+        return;
+    }
+
     // Ensure that a cached set has a valid buffer first
     if (mNewCachedSet->hasRenderedBuffer()) {
         ATRACE_NAME("mNewCachedSet->hasRenderedBuffer()");
@@ -149,7 +191,44 @@ void Flattener::renderCachedSets(
         }
     }
 
-    mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform);
+    mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform,
+                          mTunables.mEnableAsyncRender);
+
+    // The time composition was held up by rendering, which is the whole render unless it was
+    // queued asynchronously.
+    const auto renderTime = std::chrono::steady_clock::now() - now;
+    ATRACE_INT64("CachedSetRenderNs", renderTime.count());
+    if (mNewCachedSet->hasPendingRender()) {
+        mRenderQueueTime = now;
+    } else if (mNewCachedSet->hasRenderedBuffer()) {
+        ++mCachedSetRenderCount;
+        mCachedSetRenderTime += renderTime;
+    }
+}
+
+void Flattener::collectPendingRender() {
+    if (!mNewCachedSet || !mNewCachedSet->collectPendingRender()) {
+        return;
+    }
+
+    // This includes the time until the completion was noticed, so it is an upper bound on how
+    // long RenderEngine took.
+    const auto renderTime = std::chrono::steady_clock::now() - mRenderQueueTime;
+    ATRACE_INT64("CachedSetRenderLatencyNs", renderTime.count());
+    if (mNewCachedSet->hasRenderedBuffer()) {
+        ++mCachedSetRenderCount;
+        mCachedSetRenderTime += renderTime;
+    }
+}
+
+void Flattener::recordFlattenHitRate(size_t layerCount, size_t flattenedLayerCount) {
+    mLayerCount += layerCount;
+    mFlattenedLayerCount += flattenedLayerCount;
+    mTexturePool.recordFrame(flattenedLayerCount > 0);
+    if (layerCount > 0) {
+        ATRACE_INT("FlattenHitPercent",
+                   static_cast<int32_t>(flattenedLayerCount * 100 / layerCount));
+    }
 }
 
 void Flattener::dumpLayers(std::string& result) const {
@@ -200,6 +279,22 @@ void Flattener::dump(std::string& result) const {
     base::StringAppendF(&result, "\n    Cached sets created: %zd\n", mCachedSetCreationCount);
     base::StringAppendF(&result, "    Cost: %.2f\n",
                         static_cast<float>(mCachedSetCreationCost) / displayArea);
+    base::StringAppendF(&result, "    Rendered%s: %zd",
+                        mTunables.mEnableAsyncRender ? " (async)" : "", mCachedSetRenderCount);
+    if (mCachedSetRenderCount > 0) {
+        const auto renderTime = std::chrono::duration<float, std::milli>(mCachedSetRenderTime);
+        base::StringAppendF(&result, ", average %.2f ms",
+                            renderTime.count() / static_cast<float>(mCachedSetRenderCount));
+    }
+    base::StringAppendF(&result, "\n    Layers drawn from cached sets: %.2f%%\n",
+                        mLayerCount > 0
+                                ? 100.f * static_cast<float>(mFlattenedLayerCount) /
+                                        static_cast<float>(mLayerCount)
+                                : 0.f);
+    base::StringAppendF(&result,
+                        "    Cached sets reused after a layer stack change: %zd, expired: %zd, "
+                        "retained: %zu\n",
+                        mCachedSetReuseCount, mCachedSetExpiredCount, mReusableCachedSets.size());
 
     const auto lastUpdate =
             std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastGeometryUpdate);
@@ -248,6 +343,7 @@ void Flattener::resetActivities(NonBufferHash hash, time_point now) {
     for (const CachedSet& cachedSet : mLayers) {
         if (cachedSet.getLayerCount() > 1) {
             ++mInvalidatedCachedSetAges[cachedSet.getAge()];
+            retainRenderedCachedSet(cachedSet, now);
         }
     }
 
@@ -259,6 +355,80 @@ void Flattener::resetActivities(NonBufferHash hash, time_point now) {
     }
 }
 
+void Flattener::retainRenderedCachedSet(const CachedSet& cachedSet, time_point now) {
+    // The buffer is stale if a layer was updated, and hole punches and blurs depend on the layers
+    // around the cached set, so those cannot be drawn elsewhere in the stack.
+    if (cachedSet.hasBufferUpdate() || cachedSet.getHolePunchLayer() || cachedSet.getBlurLayer()) {
+        return;
+    }
+
+    auto buffer = cachedSet.getRenderedBuffer();
+    if (!buffer) {
+        return;
+    }
+
+    // The layer hashes were taken when the cached set was built, so they match what was rendered
+    // even if the layers changed since.
+    size_t contentHash = 0;
+    for (const CachedSet::Layer& layer : cachedSet.getConstituentLayers()) {
+        android::hashCombineSingleHashed(contentHash,
+                                         getContentHash(layer.getHash(), *layer.getState()));
+    }
+
+    mReusableCachedSets.push_front(ReusableCachedSet{
+            .contentHash = contentHash,
+            .layerCount = cachedSet.getLayerCount(),
+            .buffer = std::move(*buffer),
+            .lastUpdate = cachedSet.getLastUpdate(),
+            .retainTime = now,
+    });
+
+    while (mReusableCachedSets.size() > kMaxReusableCachedSets) {
+        mReusableCachedSets.pop_back();
+        ++mCachedSetExpiredCount;
+    }
+}
+
+void Flattener::expireReusableCachedSets(time_point now) {
+    while (!mReusableCachedSets.empty() &&
+           now - mReusableCachedSets.back().retainTime > kReusableCachedSetTimeout) {
+        mReusableCachedSets.pop_back();
+        ++mCachedSetExpiredCount;
+    }
+}
+
+std::optional<CachedSet> Flattener::reuseCachedSet(
+        std::vector<const LayerState*>::const_iterator first,
+        std::vector<const LayerState*>::const_iterator last) {
+    const auto availableLayers = static_cast<size_t>(std::distance(first, last));
+    for (auto entry = mReusableCachedSets.begin(); entry != mReusableCachedSets.end(); ++entry) {
+        if (entry->layerCount > availableLayers || !(entry->buffer.outputSpace == mOutputSpace) ||
+            entry->buffer.outputDataspace != mOutputDataspace) {
+            continue;
+        }
+
+        const auto end = first + static_cast<std::ptrdiff_t>(entry->layerCount);
+        size_t contentHash = 0;
+        for (auto layer = first; layer != end; ++layer) {
+            android::hashCombineSingleHashed(contentHash,
+                                             getContentHash((*layer)->getHash(), **layer));
+        }
+        if (contentHash != entry->contentHash) {
+            continue;
+        }
+
+        CachedSet cachedSet(*first, entry->lastUpdate);
+        for (auto layer = std::next(first); layer != end; ++layer) {
+            cachedSet.addLayer(*layer, entry->lastUpdate);
+        }
+        cachedSet.adoptRenderedBuffer(std::move(entry->buffer));
+        mReusableCachedSets.erase(entry);
+        ++mCachedSetReuseCount;
+        return cachedSet;
+    }
+    return std::nullopt;
+}
+
 NonBufferHash Flattener::computeLayersHash() const{
     size_t hash = 0;
     for (const auto& layer : mLayers) {
@@ -276,8 +446,30 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
 
     if (mLayers.empty()) {
         merged.reserve(layers.size());
-        for (const LayerState* layer : layers) {
-            merged.emplace_back(layer, now);
+        for (auto layer = layers.cbegin(); layer != layers.cend();) {
+            // The layers may have been drawn into a cached set before the layer stack changed.
+            if (auto reused = reuseCachedSet(layer, layers.cend()); reused) {
+                ALOGV("[%s] Reusing cached set of %zu layers", __func__, reused->getLayerCount());
+                for (size_t i = 0; i < reused->getLayerCount(); ++i) {
+                    OutputLayer::CompositionState& state = (*layer)->getOutputLayer()->editState();
+                    state.overrideInfo = {
+                            .buffer = reused->getBuffer(),
+                            .acquireFence = reused->getDrawFence(),
+                            .displayFrame = reused->getTextureBounds(),
+                            .dataspace = reused->getOutputDataspace(),
+                            .displaySpace = reused->getOutputSpace(),
+                            .damageRegion = Region::INVALID_REGION,
+                            .visibleRegion = reused->getVisibleRegion(),
+                            .peekThroughLayer = nullptr,
+                            .disableBackgroundBlur = false,
+                    };
+                    ++layer;
+                }
+                merged.emplace_back(std::move(*reused));
+            } else {
+                merged.emplace_back(*layer, now);
+                ++layer;
+            }
             mFlattenedDisplayCost += merged.back().getDisplayCost();
         }
         mLayers = std::move(merged);
@@ -61,10 +61,20 @@ Flattener::Tunables buildFlattenerTuneables() {
     const auto enableHolePunch =
             base::GetBoolProperty(std::string("debug.sf.enable_hole_punch_pip"),
                                   Flattener::Tunables::kDefaultEnableHolePunch);
+    const auto enableAsyncRender =
+            base::GetBoolProperty(std::string("debug.sf.enable_async_cached_set_render"),
+                                  Flattener::Tunables::kDefaultEnableAsyncRender);
+    const auto texturePoolMemoryBudget = base::GetUintProperty<
+            size_t>(std::string("debug.sf.planner_texture_pool_budget_bytes"),
+                    base::GetBoolProperty(std::string("ro.config.low_ram"), false)
+                            ? Flattener::Tunables::kDefaultLowRamTexturePoolMemoryBudget
+                            : Flattener::Tunables::kDefaultTexturePoolMemoryBudget);
     return Flattener::Tunables{
             .mActiveLayerTimeout = activeLayerTimeout,
             .mRenderScheduling = buildRenderSchedulingTunables(),
             .mEnableHolePunch = enableHolePunch,
+            .mEnableAsyncRender = enableAsyncRender,
+            .mTexturePoolMemoryBudget = texturePoolMemoryBudget,
     };
 }
 
@@ -23,15 +23,41 @@
 #include <renderengine/impl/ExternalTexture.h>
 #include <utils/Log.h>
 
+#include <algorithm>
+
 namespace android::compositionengine::impl::planner {
 
+namespace {
+
+// Textures are RGBA_8888.
+constexpr size_t kBytesPerPixel = 4;
+
+size_t getTextureMemory(uint32_t width, uint32_t height) {
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * kBytesPerPixel;
+}
+
+size_t getTextureMemory(const renderengine::ExternalTexture& texture) {
+    return getTextureMemory(texture.getBuffer()->getWidth(), texture.getBuffer()->getHeight());
+}
+
+size_t getTextureMemory(ui::Size size) {
+    return getTextureMemory(static_cast<uint32_t>(size.getWidth()),
+                            static_cast<uint32_t>(size.getHeight()));
+}
+
+float toMiB(size_t bytes) {
+    return static_cast<float>(bytes) / (1024.f * 1024.f);
+}
+
+} // namespace
+
 void TexturePool::allocatePool() {
     mPool.clear();
     if (mEnabled && mSize.isValid()) {
-        mPool.resize(kMinPoolSize);
-        std::generate_n(mPool.begin(), kMinPoolSize, [&]() {
-            return Entry{genTexture(), nullptr};
-        });
+        const size_t textureMemory = getTextureMemory(mSize);
+        while (mPool.size() < kMinPoolSize && canRetain(textureMemory)) {
+            mPool.push_back(Entry{genTexture(mSize), nullptr});
+        }
     }
 }
 
@@ -40,29 +66,76 @@ void TexturePool::setDisplaySize(ui::Size size) {
         return;
     }
     mSize = size;
+    ++mGeneration;
     allocatePool();
 }
 
 std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture() {
-    if (mPool.empty()) {
-        return std::make_shared<AutoTexture>(*this, genTexture(), nullptr);
+    return borrowTexture(mSize);
+}
+
+std::shared_ptr<TexturePool::AutoTexture> TexturePool::borrowTexture(ui::Size size) {
+    ++mBorrowCount;
+    const ui::Size bucketSize = getBucketSize(size);
+    const auto entry = std::find_if(mPool.begin(), mPool.end(), [&](const Entry& candidate) {
+        const auto& buffer = candidate.texture->getBuffer();
+        return static_cast<int32_t>(buffer->getWidth()) == bucketSize.getWidth() &&
+                static_cast<int32_t>(buffer->getHeight()) == bucketSize.getHeight();
+    });
+
+    if (entry == mPool.end()) {
+        // The pool is starved, so retain one more texture once it is returned.
+        mTargetPoolSize = std::min(mTargetPoolSize + 1, kMaxPoolSize);
+        auto texture = genTexture(bucketSize);
+        mBorrowedMemory += getTextureMemory(*texture);
+        return std::make_shared<AutoTexture>(*this, std::move(texture), nullptr, mGeneration);
     }
 
-    const auto entry = mPool.front();
-    mPool.pop_front();
-    return std::make_shared<AutoTexture>(*this, entry.texture, entry.fence);
+    const Entry borrowed = *entry;
+    mPool.erase(entry);
+    mBorrowedMemory += getTextureMemory(*borrowed.texture);
+    return std::make_shared<AutoTexture>(*this, borrowed.texture, borrowed.fence, mGeneration);
+}
+
+void TexturePool::recordFrame(bool usedCachedSets) {
+    ++mWindowFrames;
+    if (usedCachedSets) {
+        ++mWindowHits;
+    }
+    if (mWindowFrames < kHitRateWindow) {
+        return;
+    }
+
+    if (mWindowHits * 100 < mWindowFrames * kMinHitRatePercent) {
+        // Flattening rarely pays off, so the idle textures are wasted memory.
+        if (mTargetPoolSize > 0) {
+            --mTargetPoolSize;
+        }
+        while (mPool.size() > mTargetPoolSize) {
+            ALOGV("Deallocating texture from Planner's pool - low hit rate [%zu/%zu]", mWindowHits,
+                  mWindowFrames);
+            mPool.pop_back();
+        }
+    } else {
+        mTargetPoolSize = std::max(mTargetPoolSize, kMinPoolSize);
+    }
+
+    mWindowFrames = 0;
+    mWindowHits = 0;
 }
 
 void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&& texture,
-                                const sp<Fence>& fence) {
+                                const sp<Fence>& fence, uint32_t generation) {
+    const size_t textureMemory = getTextureMemory(*texture);
+    mBorrowedMemory -= textureMemory;
+
     // Drop the texture on the floor if the pool is not enabled
     if (!mEnabled) {
         return;
     }
 
     // Or the texture on the floor if the pool is no longer tracking textures of the same size.
-    if (static_cast<int32_t>(texture->getBuffer()->getWidth()) != mSize.getWidth() ||
-        static_cast<int32_t>(texture->getBuffer()->getHeight()) != mSize.getHeight()) {
+    if (generation != mGeneration) {
         ALOGV("Deallocating texture from Planner's pool - display size changed (previous: (%dx%d), "
               "current: (%dx%d))",
               texture->getBuffer()->getWidth(), texture->getBuffer()->getHeight(), mSize.getWidth(),
@@ -70,23 +143,63 @@ void TexturePool::returnTexture(std::shared_ptr<renderengine::ExternalTexture>&&
         return;
     }
 
-    // Also ensure the pool does not grow beyond a maximum size.
-    if (mPool.size() == kMaxPoolSize) {
-        ALOGD("Deallocating texture from Planner's pool - max size [%" PRIu64 "] reached",
-              static_cast<uint64_t>(kMaxPoolSize));
+    // Textures of other sizes may fill the pool, so release the ones idle the longest to make room,
+    // unless the returned texture would not fit in an empty pool either.
+    const bool fitsEmptyPool = std::min(mTargetPoolSize, kMaxPoolSize) > 0 &&
+            mBorrowedMemory <= mMemoryBudget && textureMemory <= mMemoryBudget - mBorrowedMemory;
+    while (fitsEmptyPool && !canRetain(textureMemory)) {
+        ALOGV("Deallocating idle texture from Planner's pool to retain a more recent one");
+        mPool.pop_front();
+    }
+
+    // Also ensure the pool does not grow beyond its current size or memory budget.
+    if (!canRetain(textureMemory)) {
+        ALOGV("Deallocating texture from Planner's pool - max size [%zu] or budget [%zu] reached",
+              std::min(mTargetPoolSize, kMaxPoolSize), mMemoryBudget);
         return;
     }
 
     mPool.push_back({std::move(texture), fence});
 }
 
-std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
-    LOG_ALWAYS_FATAL_IF(!mSize.isValid(), "Attempted to generate texture with invalid size");
+bool TexturePool::canRetain(size_t textureMemory) const {
+    if (mPool.size() >= std::min(mTargetPoolSize, kMaxPoolSize)) {
+        return false;
+    }
+    const size_t poolMemory = getPoolMemory();
+    return poolMemory <= mMemoryBudget && textureMemory <= mMemoryBudget - poolMemory;
+}
+
+ui::Size TexturePool::getBucketSize(ui::Size size) const {
+    if (!mSize.isValid()) {
+        return mSize;
+    }
+
+    const auto roundUp = [](int32_t value, int32_t limit) {
+        const int32_t step = (limit + kSizeBuckets - 1) / kSizeBuckets;
+        const int32_t clamped = std::clamp(value, 1, limit);
+        return std::min((clamped + step - 1) / step * step, limit);
+    };
+    return ui::Size(roundUp(size.getWidth(), mSize.getWidth()),
+                    roundUp(size.getHeight(), mSize.getHeight()));
+}
+
+size_t TexturePool::getPoolMemory() const {
+    size_t memory = mBorrowedMemory;
+    for (const Entry& entry : mPool) {
+        memory += getTextureMemory(*entry.texture);
+    }
+    return memory;
+}
+
+std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture(ui::Size size) {
+    LOG_ALWAYS_FATAL_IF(!size.isValid(), "Attempted to generate texture with invalid size");
+    ++mAllocationCount;
     return std::make_shared<
             renderengine::impl::
                     ExternalTexture>(sp<GraphicBuffer>::
-                                             make(static_cast<uint32_t>(mSize.getWidth()),
-                                                  static_cast<uint32_t>(mSize.getHeight()),
+                                             make(static_cast<uint32_t>(size.getWidth()),
+                                                  static_cast<uint32_t>(size.getHeight()),
                                                   HAL_PIXEL_FORMAT_RGBA_8888, 1U,
                                                   static_cast<uint64_t>(
                                                           GraphicBuffer::USAGE_HW_RENDER |
@@ -100,6 +213,11 @@ std::shared_ptr<renderengine::ExternalTexture> TexturePool::genTexture() {
 
 void TexturePool::setEnabled(bool enabled) {
     mEnabled = enabled;
+    if (enabled) {
+        mTargetPoolSize = kMinPoolSize;
+        mWindowFrames = 0;
+        mWindowHits = 0;
+    }
     allocatePool();
 }
 
@@ -107,6 +225,16 @@ void TexturePool::dump(std::string& out) const {
     base::StringAppendF(&out,
                         "TexturePool (%s) has %zu buffers of size [%" PRId32 ", %" PRId32 "]\n",
                         mEnabled ? "enabled" : "disabled", mPool.size(), mSize.width, mSize.height);
+    const size_t pooledMemory = getPoolMemory() - mBorrowedMemory;
+    base::StringAppendF(&out, "    Memory: %.2f MiB pooled, %.2f MiB borrowed, budget ",
+                        toMiB(pooledMemory), toMiB(mBorrowedMemory));
+    if (mMemoryBudget == kUnlimitedMemoryBudget) {
+        out.append("unlimited\n");
+    } else {
+        base::StringAppendF(&out, "%.2f MiB\n", toMiB(mMemoryBudget));
+    }
+    base::StringAppendF(&out, "    Retaining up to %zu buffers, %zu borrows, %zu allocations\n",
+                        std::min(mTargetPoolSize, kMaxPoolSize), mBorrowCount, mAllocationCount);
 }
 
-} // namespace android::compositionengine::impl::planner
\ No newline at end of file
+} // namespace android::compositionengine::impl::planner
@@ -38,11 +38,13 @@ namespace {
 
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::ExpectationSet;
 using ::testing::InSequence;
 using ::testing::Ref;
 using ::testing::Return;
 using ::testing::ReturnRef;
 using ::testing::SaveArg;
+using ::testing::Sequence;
 using ::testing::StrictMock;
 
 struct CompositionEngineTest : public testing::Test {
@@ -329,6 +331,8 @@ TEST_F(CompositionEngineOffloadTest, basic) {
     EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
 
     EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mDisplay2, offloadPresentNextFrame).Times(0);
 
     SET_FLAG_FOR_TEST(flags::multithreaded_present, true);
@@ -393,6 +397,8 @@ TEST_F(CompositionEngineOffloadTest, virtualDisplay) {
     EXPECT_CALL(*mVirtualDisplay, supportsOffloadPresent).Times(0);
 
     EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mDisplay2, offloadPresentNextFrame).Times(0);
     EXPECT_CALL(*mVirtualDisplay, offloadPresentNextFrame).Times(0);
 
@@ -420,6 +426,8 @@ TEST_F(CompositionEngineOffloadTest, halVirtual) {
     EXPECT_CALL(*mHalVirtualDisplay, supportsOffloadPresent).WillOnce(Return(true));
 
     EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mHalVirtualDisplay, offloadPresentNextFrame).Times(0);
 
     SET_FLAG_FOR_TEST(flags::multithreaded_present, true);
@@ -436,7 +444,11 @@ TEST_F(CompositionEngineOffloadTest, ordering) {
 
     EXPECT_CALL(*mVirtualDisplay, offloadPresentNextFrame).Times(0);
     EXPECT_CALL(*mHalVirtualDisplay, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mHalVirtualDisplay, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mDisplay2, offloadPresentNextFrame).Times(0);
 
     SET_FLAG_FOR_TEST(flags::multithreaded_present, true);
@@ -474,6 +486,8 @@ TEST_F(CompositionEngineOffloadTest, disabledDisplaysDoNotPreventOthersFromOfflo
     EXPECT_CALL(*mHalVirtualDisplay, supportsOffloadPresent).WillOnce(Return(true));
 
     EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
     EXPECT_CALL(*mDisplay2, offloadPresentNextFrame).Times(0);
     EXPECT_CALL(*mHalVirtualDisplay, offloadPresentNextFrame).Times(0);
 
@@ -483,5 +497,122 @@ TEST_F(CompositionEngineOffloadTest, disabledDisplaysDoNotPreventOthersFromOfflo
     mEngine.present(mRefreshArgs);
 }
 
+TEST_F(CompositionEngineOffloadTest, pipelinedFramesArePresentedAfterAllOutputs) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay1, offloadPresentNextFrame).Times(1);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, true);
+    InSequence seq;
+    for (auto& output : {mDisplay1, mDisplay2}) {
+        EXPECT_CALL(*output, prepare(Ref(mRefreshArgs), _)).Times(1);
+        mRefreshArgs.outputs.push_back(output);
+    }
+    EXPECT_CALL(*mDisplay1, present(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+    EXPECT_CALL(*mDisplay2, present(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+    EXPECT_CALL(*mDisplay1, presentPipelinedFrame(Ref(mRefreshArgs)))
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+
+    mEngine.present(mRefreshArgs);
+}
+
+struct CompositionEngineParallelCompositionStateTest : public CompositionEngineOffloadTest {
+    void SetUp() override {
+        CompositionEngineOffloadTest::SetUp();
+        mRefreshArgs.parallelCompositionState = true;
+    }
+
+    // Expects every output to be prepared and presented, with all of them prepared before any of
+    // them is presented.
+    void setOutputsWithPreparedCompositionState(
+            std::initializer_list<std::shared_ptr<mock::Output>> outputs) {
+        ExpectationSet prepared;
+        for (auto& output : outputs) {
+            prepared += EXPECT_CALL(*output, prepareCompositionState(Ref(mRefreshArgs)))
+                                .WillOnce(Return(ftl::yield<std::monostate>({})));
+        }
+        for (auto& output : outputs) {
+            EXPECT_CALL(*output, prepare(Ref(mRefreshArgs), _)).Times(1);
+            EXPECT_CALL(*output, present(Ref(mRefreshArgs)))
+                    .After(prepared)
+                    .WillOnce(Return(ftl::yield<std::monostate>({})));
+
+            mRefreshArgs.outputs.push_back(std::move(output));
+        }
+    }
+};
+
+TEST_F(CompositionEngineParallelCompositionStateTest, basic) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+
+    EXPECT_CALL(*mDisplay1, offloadCompositionStateNextFrame).Times(1);
+    EXPECT_CALL(*mDisplay2, offloadCompositionStateNextFrame).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    setOutputsWithPreparedCompositionState({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineParallelCompositionStateTest, dependsOnRefreshArgs) {
+    mRefreshArgs.parallelCompositionState = false;
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).Times(0);
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).Times(0);
+
+    EXPECT_CALL(*mDisplay1, prepareCompositionState).Times(0);
+    EXPECT_CALL(*mDisplay2, prepareCompositionState).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineParallelCompositionStateTest, dependsOnSupport) {
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(false));
+
+    EXPECT_CALL(*mDisplay1, prepareCompositionState).Times(0);
+    EXPECT_CALL(*mDisplay2, prepareCompositionState).Times(0);
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    setOutputs({mDisplay1, mDisplay2});
+
+    mEngine.present(mRefreshArgs);
+}
+
+TEST_F(CompositionEngineParallelCompositionStateTest, offloadedOutputsArePreparedFirst) {
+    EXPECT_CALL(*mVirtualDisplay, supportsOffloadPresent).Times(0);
+    EXPECT_CALL(*mDisplay1, supportsOffloadPresent).WillOnce(Return(true));
+    EXPECT_CALL(*mDisplay2, supportsOffloadPresent).WillOnce(Return(true));
+
+    // mDisplay1 is kicked off on its worker before the outputs that are prepared on the main
+    // thread, in the order they are refreshed.
+    Sequence seq;
+    EXPECT_CALL(*mDisplay1, offloadCompositionStateNextFrame).InSequence(seq);
+    EXPECT_CALL(*mDisplay1, prepareCompositionState(Ref(mRefreshArgs)))
+            .InSequence(seq)
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+    EXPECT_CALL(*mVirtualDisplay, prepareCompositionState(Ref(mRefreshArgs)))
+            .InSequence(seq)
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+    EXPECT_CALL(*mDisplay2, prepareCompositionState(Ref(mRefreshArgs)))
+            .InSequence(seq)
+            .WillOnce(Return(ftl::yield<std::monostate>({})));
+
+    SET_FLAG_FOR_TEST(flags::multithreaded_present, false);
+    for (auto& output : {mVirtualDisplay, mDisplay1, mDisplay2}) {
+        EXPECT_CALL(*output, prepare(Ref(mRefreshArgs), _)).Times(1);
+        EXPECT_CALL(*output, present(Ref(mRefreshArgs)))
+                .WillOnce(Return(ftl::yield<std::monostate>({})));
+        mRefreshArgs.outputs.push_back(output);
+    }
+
+    mEngine.present(mRefreshArgs);
+}
+
 } // namespace
 } // namespace android::compositionengine
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+
+#include <compositionengine/CoverageTiles.h>
+#include <gtest/gtest.h>
+#include <ui/Region.h>
+
+namespace android::compositionengine {
+namespace {
+
+// 1080 is not a multiple of the grid size, so the last column of tiles is cut short.
+const Rect kBounds(0, 0, 1080, 2400);
+
+class CoverageTilesTest : public testing::Test {
+public:
+    CoverageTilesTest() { mTiles.setBounds(kBounds); }
+
+protected:
+    CoverageTiles mTiles;
+};
+
+TEST_F(CoverageTilesTest, disabledWithoutBounds) {
+    CoverageTiles tiles;
+    EXPECT_FALSE(tiles.isUncovered(Rect(0, 0, 10, 10)));
+    EXPECT_FALSE(tiles.isOpaque(Rect(0, 0, 10, 10)));
+
+    tiles.setBounds(Rect::EMPTY_RECT);
+    tiles.addCovered(Rect(0, 0, 10, 10));
+    tiles.addOpaque(Rect(0, 0, 10, 10));
+    EXPECT_FALSE(tiles.isUncovered(Rect(20, 20, 30, 30)));
+    EXPECT_FALSE(tiles.isOpaque(Rect(0, 0, 10, 10)));
+}
+
+TEST_F(CoverageTilesTest, initiallyUncoveredAndNotOpaque) {
+    EXPECT_TRUE(mTiles.isUncovered(kBounds));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 0, 1, 1)));
+}
+
+TEST_F(CoverageTilesTest, coveredRectOnlyCoversOverlappingTiles) {
+    mTiles.addCovered(Rect(0, 0, 1080, 100));
+
+    EXPECT_FALSE(mTiles.isUncovered(Rect(500, 50, 600, 150)));
+    EXPECT_FALSE(mTiles.isUncovered(Rect(0, 0, 1, 1)));
+    EXPECT_TRUE(mTiles.isUncovered(Rect(0, 200, 1080, 2400)));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 0, 1080, 100)));
+}
+
+TEST_F(CoverageTilesTest, opaqueRectOnlyMarksContainedTiles) {
+    // The tiles are 17x38, so this contains rows 0-1 and only part of row 2.
+    mTiles.addOpaque(Rect(0, 0, 1080, 100));
+
+    EXPECT_TRUE(mTiles.isOpaque(Rect(0, 0, 1080, 76)));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 0, 1080, 77)));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 90, 10, 100)));
+}
+
+TEST_F(CoverageTilesTest, opaqueRectReachingTheBoundsMarksTheLastTiles) {
+    mTiles.addOpaque(Rect(1060, 2390, 1080, 2400));
+    EXPECT_TRUE(mTiles.isOpaque(Rect(1071, 2394, 1080, 2400)));
+
+    mTiles.addOpaque(Rect(-100, -100, 2000, 3000));
+    EXPECT_TRUE(mTiles.isOpaque(kBounds));
+}
+
+TEST_F(CoverageTilesTest, rectsOutsideTheBoundsAreNotOpaque) {
+    mTiles.addOpaque(kBounds);
+
+    EXPECT_FALSE(mTiles.isOpaque(Rect(-1, 0, 1080, 2400)));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 0, 1080, 2401)));
+}
+
+TEST_F(CoverageTilesTest, coverageOutsideTheBoundsIsTracked) {
+    EXPECT_TRUE(mTiles.isUncovered(Rect(-100, -100, -50, -50)));
+
+    mTiles.addCovered(Rect(-200, -200, -150, -150));
+
+    EXPECT_FALSE(mTiles.isUncovered(Rect(-100, -100, -50, -50)));
+    EXPECT_FALSE(mTiles.isUncovered(Rect(-100, 500, 100, 600)));
+    EXPECT_TRUE(mTiles.isUncovered(Rect(0, 500, 100, 600)));
+}
+
+TEST_F(CoverageTilesTest, handlesExtremeRects) {
+    const Rect huge(INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX);
+    mTiles.addOpaque(huge);
+    mTiles.addCovered(huge);
+
+    EXPECT_FALSE(mTiles.isUncovered(Rect(0, 0, 1, 1)));
+    EXPECT_TRUE(mTiles.isOpaque(kBounds));
+    EXPECT_FALSE(mTiles.isOpaque(huge));
+}
+
+TEST_F(CoverageTilesTest, setBoundsResetsCoverage) {
+    mTiles.addCovered(Rect(-10, 0, 1080, 2400));
+    mTiles.addOpaque(kBounds);
+
+    mTiles.setBounds(kBounds);
+
+    EXPECT_TRUE(mTiles.isUncovered(Rect(-10, 0, 1080, 2400)));
+    EXPECT_FALSE(mTiles.isOpaque(Rect(0, 0, 1, 1)));
+}
+
+// The tiles must never claim more than the exact regions they summarize.
+TEST_F(CoverageTilesTest, agreesWithRegions) {
+    std::mt19937 random(0);
+    auto randomRect = [&random] {
+        std::uniform_int_distribution<int32_t> x(-200, 1280);
+        std::uniform_int_distribution<int32_t> y(-200, 2600);
+        std::uniform_int_distribution<int32_t> size(1, 800);
+        const int32_t left = x(random);
+        const int32_t top = y(random);
+        return Rect(left, top, left + size(random), top + size(random));
+    };
+
+    Region covered;
+    Region opaque;
+    for (int i = 0; i < 200; i++) {
+        const Rect layer = randomRect();
+        const bool uncovered = mTiles.isUncovered(layer);
+        const bool occluded = mTiles.isOpaque(layer);
+        if (uncovered) {
+            EXPECT_TRUE(covered.intersect(layer).isEmpty()) << to_string(layer);
+        }
+        if (occluded) {
+            EXPECT_TRUE(Region(layer).subtract(opaque).isEmpty()) << to_string(layer);
+        }
+
+        covered.orSelf(layer);
+        mTiles.addCovered(layer);
+        if (i % 3 == 0) {
+            opaque.orSelf(layer);
+            mTiles.addOpaque(layer);
+        }
+    }
+}
+
+} // namespace
+} // namespace android::compositionengine
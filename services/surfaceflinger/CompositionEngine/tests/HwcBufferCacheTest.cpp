@@ -19,6 +19,8 @@
 #include <gui/BufferQueue.h>
 #include <ui/GraphicBuffer.h>
 
+#include <vector>
+
 namespace android::compositionengine {
 namespace {
 
@@ -85,6 +87,52 @@ TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_whenSlotsFull_evictsOldestCachedB
     EXPECT_EQ(cache.uncache(graphicBuffers[0]->getId()), UINT32_MAX);
 }
 
+TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_whenSlotsFull_evictsLeastRecentlyUsedBuffer) {
+    HwcBufferCache cache(2);
+    sp<GraphicBuffer> buffer3 = sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u);
+
+    HwcSlotAndBuffer slotAndBufferFor1 = cache.getHwcSlotAndBuffer(mBuffer1);
+    HwcSlotAndBuffer slotAndBufferFor2 = cache.getHwcSlotAndBuffer(mBuffer2);
+    // using the 1st buffer again makes the 2nd buffer the least recently used
+    EXPECT_EQ(cache.getHwcSlotAndBuffer(mBuffer1).buffer, nullptr);
+
+    HwcSlotAndBuffer slotAndBufferFor3 = cache.getHwcSlotAndBuffer(buffer3);
+    EXPECT_EQ(slotAndBufferFor3.slot, slotAndBufferFor2.slot);
+    EXPECT_EQ(slotAndBufferFor3.buffer, buffer3);
+
+    EXPECT_EQ(cache.uncache(mBuffer2->getId()), UINT32_MAX);
+    EXPECT_EQ(cache.uncache(mBuffer1->getId()), slotAndBufferFor1.slot);
+}
+
+TEST_F(HwcBufferCacheTest, getHwcSlotAndBuffer_staysWithinSlotBudget) {
+    HwcBufferCache cache(3);
+    EXPECT_EQ(cache.getSlotBudget(), 3u);
+
+    std::vector<sp<GraphicBuffer>> graphicBuffers;
+    for (int i = 0; i < 10; ++i) {
+        graphicBuffers.push_back(
+                sp<GraphicBuffer>::make(1u, 1u, HAL_PIXEL_FORMAT_RGBA_8888, 1u, 0u));
+        EXPECT_LT(cache.getHwcSlotAndBuffer(graphicBuffers.back()).slot, 3u);
+    }
+    EXPECT_EQ(cache.getCachedBufferCount(), 3u);
+}
+
+TEST_F(HwcBufferCacheTest, stats_countHitsMissesEvictionsAndUncaches) {
+    HwcBufferCache cache(1);
+
+    cache.getHwcSlotAndBuffer(mBuffer1);
+    cache.getHwcSlotAndBuffer(mBuffer1);
+    cache.getHwcSlotAndBuffer(mBuffer2);
+    cache.uncache(mBuffer2->getId());
+    cache.uncache(mBuffer2->getId());
+
+    const HwcBufferCache::Stats& stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.uncaches, 1u);
+}
+
 TEST_F(HwcBufferCacheTest, uncache_whenCached_returnsSlotNumber) {
     HwcBufferCache cache;
     sp<GraphicBuffer> outBuffer;
@@ -34,8 +34,11 @@
 #include <ui/Rect.h>
 #include <ui/Region.h>
 
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <future>
+#include <thread>
 #include <variant>
 
 #include <common/FlagManager.h>
@@ -1914,6 +1917,97 @@ TEST_F(OutputEnsureOutputLayerIfVisibleTest, takesNotSoEarlyOutifLayerWithShadow
     ensureOutputLayerIfVisible();
 }
 
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, takesEarlyOutIfCoverageTilesShowLayerIsOccluded) {
+    mCoverageState.tiles.setBounds(Rect(0, 0, 200, 300));
+    mCoverageState.aboveCoveredLayers = Region(Rect(0, 0, 200, 300));
+    mCoverageState.aboveOpaqueLayers = Region(Rect(0, 0, 200, 300));
+    mCoverageState.tiles.addCovered(Rect(0, 0, 200, 300));
+    mCoverageState.tiles.addOpaque(Rect(0, 0, 200, 300));
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_THAT(mCoverageState.dirtyRegion, RegionEq(kEmptyRegion));
+    EXPECT_THAT(mCoverageState.aboveCoveredLayers, RegionEq(Region(Rect(0, 0, 200, 300))));
+    EXPECT_THAT(mCoverageState.aboveOpaqueLayers, RegionEq(Region(Rect(0, 0, 200, 300))));
+}
+
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, coverageTilesSkipRegionOpsForUncoveredLayer) {
+    mLayer.layerFEState.isOpaque = true;
+    mLayer.layerFEState.contentDirty = true;
+
+    mCoverageState.tiles.setBounds(Rect(0, 0, 200, 300));
+    mCoverageState.aboveCoveredLayers = Region(Rect(150, 0, 200, 300));
+    mCoverageState.aboveOpaqueLayers = Region(Rect(150, 0, 200, 300));
+    mCoverageState.tiles.addCovered(Rect(150, 0, 200, 300));
+    mCoverageState.tiles.addOpaque(Rect(150, 0, 200, 300));
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    const Region kExpectedAboveRegion =
+            Region(Rect(150, 0, 200, 300)).orSelf(kFullBoundsNoRotation);
+
+    EXPECT_THAT(mCoverageState.dirtyRegion, RegionEq(kFullBoundsNoRotation));
+    EXPECT_THAT(mCoverageState.aboveCoveredLayers, RegionEq(kExpectedAboveRegion));
+    EXPECT_THAT(mCoverageState.aboveOpaqueLayers, RegionEq(kExpectedAboveRegion));
+    EXPECT_TRUE(mCoverageState.tiles.isOpaque(Rect(0, 0, 100, 200)));
+
+    EXPECT_THAT(mLayer.outputLayerState.visibleRegion, RegionEq(kFullBoundsNoRotation));
+    EXPECT_THAT(mLayer.outputLayerState.coveredRegion, RegionEq(kEmptyRegion));
+    EXPECT_THAT(mLayer.outputLayerState.outputSpaceVisibleRegion, RegionEq(kFullBoundsNoRotation));
+}
+
+TEST_F(OutputEnsureOutputLayerIfVisibleTest,
+       coverageTilesSubtractOpaqueFromOldVisibleRegionOfUncoveredLayer) {
+    mLayer.layerFEState.isOpaque = true;
+    mLayer.layerFEState.contentDirty = true;
+    // The layer moved left, out from under the opaque layer that now covers its old position.
+    mLayer.outputLayerState.visibleRegion = Region(Rect(100, 0, 200, 200));
+    mLayer.outputLayerState.coveredRegion = kEmptyRegion;
+
+    mCoverageState.tiles.setBounds(Rect(0, 0, 200, 300));
+    mCoverageState.aboveCoveredLayers = Region(Rect(150, 0, 200, 300));
+    mCoverageState.aboveOpaqueLayers = Region(Rect(150, 0, 200, 300));
+    mCoverageState.tiles.addCovered(Rect(150, 0, 200, 300));
+    mCoverageState.tiles.addOpaque(Rect(150, 0, 200, 300));
+    ASSERT_TRUE(mCoverageState.tiles.isUncovered(Rect(0, 0, 100, 200)));
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    // The part of the old visible region under the opaque layer is not dirty.
+    EXPECT_THAT(mCoverageState.dirtyRegion, RegionEq(Region(Rect(0, 0, 150, 200))));
+    EXPECT_THAT(mLayer.outputLayerState.visibleRegion, RegionEq(kFullBoundsNoRotation));
+}
+
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, coverageTilesFallBackToRegionsForCoveredLayer) {
+    mLayer.layerFEState.isOpaque = false;
+    mLayer.layerFEState.contentDirty = true;
+
+    mCoverageState.tiles.setBounds(Rect(0, 0, 200, 300));
+    mCoverageState.dirtyRegion = Region(Rect(0, 0, 500, 500));
+    mCoverageState.aboveCoveredLayers = Region(Rect(50, 0, 150, 200));
+    mCoverageState.aboveOpaqueLayers = Region(Rect(50, 0, 150, 200));
+    mCoverageState.tiles.addCovered(Rect(50, 0, 150, 200));
+    mCoverageState.tiles.addOpaque(Rect(50, 0, 150, 200));
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_THAT(mCoverageState.aboveCoveredLayers, RegionEq(Region(Rect(0, 0, 150, 200))));
+    EXPECT_THAT(mCoverageState.aboveOpaqueLayers, RegionEq(Region(Rect(50, 0, 150, 200))));
+    EXPECT_FALSE(mCoverageState.tiles.isUncovered(Rect(0, 0, 10, 10)));
+
+    EXPECT_THAT(mLayer.outputLayerState.visibleRegion, RegionEq(Region(Rect(0, 0, 50, 200))));
+    EXPECT_THAT(mLayer.outputLayerState.coveredRegion, RegionEq(Region(Rect(50, 0, 100, 200))));
+}
+
 TEST_F(OutputEnsureOutputLayerIfVisibleTest, displayDecorSetsBlockingFromTransparentRegion) {
     mLayer.layerFEState.isOpaque = false;
     mLayer.layerFEState.contentDirty = true;
@@ -2017,6 +2111,10 @@ struct OutputPresentTest : public testing::Test {
         MOCK_METHOD0(presentFrameAndReleaseLayers, void());
         MOCK_METHOD1(renderCachedSets, void(const compositionengine::CompositionRefreshArgs&));
         MOCK_METHOD1(canPredictCompositionStrategy, bool(const CompositionRefreshArgs&));
+        MOCK_METHOD1(chooseCompositionStrategy,
+                     bool(std::optional<android::HWComposer::DeviceRequestedChanges>*));
+        MOCK_METHOD2(applyChosenCompositionStrategy,
+                     void(bool, const std::optional<android::HWComposer::DeviceRequestedChanges>&));
     };
 
     StrictMock<OutputPartialMock> mOutput;
@@ -2062,6 +2160,174 @@ TEST_F(OutputPresentTest, predictingCompositionStrategyInvokesPrepareFrameAsync)
     mOutput.present(args);
 }
 
+TEST_F(OutputPresentTest, skipsCompositionStateStepsWhenAlreadyPrepared) {
+    CompositionRefreshArgs args;
+
+    InSequence seq;
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, setColorTransform(Ref(args)));
+    EXPECT_CALL(mOutput, beginFrame());
+    EXPECT_CALL(mOutput, canPredictCompositionStrategy(Ref(args))).WillOnce(Return(false));
+    EXPECT_CALL(mOutput, prepareFrame());
+    EXPECT_CALL(mOutput, devOptRepaintFlash(Ref(args)));
+    EXPECT_CALL(mOutput, finishFrame(_));
+    EXPECT_CALL(mOutput, presentFrameAndReleaseLayers());
+    EXPECT_CALL(mOutput, renderCachedSets(Ref(args)));
+
+    mOutput.prepareCompositionState(args).get();
+    mOutput.present(args);
+}
+
+TEST_F(OutputPresentTest, offloadedCompositionStateRunsOnWorkerForOneFrame) {
+    CompositionRefreshArgs args;
+    const auto mainThreadId = std::this_thread::get_id();
+    std::thread::id updateThreadId;
+
+    InSequence seq;
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)))
+            .WillOnce([&updateThreadId](const CompositionRefreshArgs&) {
+                updateThreadId = std::this_thread::get_id();
+            });
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)))
+            .WillOnce([mainThreadId](const CompositionRefreshArgs&) {
+                EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+            });
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+
+    mOutput.offloadCompositionStateNextFrame();
+    mOutput.prepareCompositionState(args).get();
+    EXPECT_NE(mainThreadId, updateThreadId);
+
+    mOutput.prepareCompositionState(args).get();
+}
+
+TEST_F(OutputPresentTest, pipelinedHwcValidateKeepsFrameWorkOnMainThread) {
+    CompositionRefreshArgs args;
+    const auto mainThreadId = std::this_thread::get_id();
+    std::thread::id validateThreadId;
+    std::thread::id presentThreadId;
+
+    mOutput.editState().isEnabled = true;
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+
+    InSequence seq;
+    EXPECT_CALL(mOutput, updateColorProfile(Ref(args)));
+    EXPECT_CALL(mOutput, updateCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, planComposition());
+    EXPECT_CALL(mOutput, writeCompositionState(Ref(args)));
+    EXPECT_CALL(mOutput, setColorTransform(Ref(args)));
+    EXPECT_CALL(mOutput, beginFrame());
+    EXPECT_CALL(mOutput, canPredictCompositionStrategy(Ref(args))).WillOnce(Return(false));
+    EXPECT_CALL(mOutput, chooseCompositionStrategy(_)).WillOnce([&validateThreadId](auto*) {
+        validateThreadId = std::this_thread::get_id();
+        return true;
+    });
+    EXPECT_CALL(mOutput, applyChosenCompositionStrategy(true, _))
+            .WillOnce([mainThreadId](bool, const auto&) {
+                EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+            });
+    EXPECT_CALL(mOutput, finishFrame(_)).WillOnce([mainThreadId](GpuCompositionResult&&) {
+        EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+    });
+    EXPECT_CALL(mOutput, presentFrameAndReleaseLayers()).WillOnce([&presentThreadId]() {
+        presentThreadId = std::this_thread::get_id();
+    });
+    EXPECT_CALL(mOutput, renderCachedSets(Ref(args))).WillOnce([mainThreadId](const auto&) {
+        EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+    });
+
+    mOutput.setPipelineHwcValidate(true);
+    mOutput.offloadPresentNextFrame();
+    mOutput.present(args).get();
+    mOutput.presentPipelinedFrame(args).get();
+
+    EXPECT_NE(mainThreadId, validateThreadId);
+    EXPECT_EQ(validateThreadId, presentThreadId);
+}
+
+TEST_F(OutputPresentTest, pipelinedFramesValidateAndPresentConcurrentlyAcrossOutputs) {
+    CompositionRefreshArgs args;
+    const auto mainThreadId = std::this_thread::get_id();
+    StrictMock<OutputPartialMock> secondOutput;
+
+    // Stand-ins for the HWC: each validate waits for the other output's validate to start, and
+    // each present for the other output's present, so the test only passes if the main thread
+    // moves on to the second output without waiting for either call on the first.
+    struct HwcCalls {
+        std::promise<void> validateStarted;
+        std::promise<void> presentStarted;
+    };
+    HwcCalls first;
+    HwcCalls second;
+
+    const auto expectPipelinedFrame = [&](OutputPartialMock& output, HwcCalls& calls,
+                                          HwcCalls& otherCalls) {
+        output.editState().isEnabled = true;
+        EXPECT_CALL(output, getOutputLayerCount()).WillRepeatedly(Return(0u));
+
+        auto otherValidateStarted = otherCalls.validateStarted.get_future().share();
+        auto otherPresentStarted = otherCalls.presentStarted.get_future().share();
+
+        InSequence seq;
+        EXPECT_CALL(output, updateColorProfile(Ref(args)));
+        EXPECT_CALL(output, updateCompositionState(Ref(args)));
+        EXPECT_CALL(output, planComposition());
+        EXPECT_CALL(output, writeCompositionState(Ref(args)));
+        EXPECT_CALL(output, setColorTransform(Ref(args)));
+        EXPECT_CALL(output, beginFrame());
+        EXPECT_CALL(output, canPredictCompositionStrategy(Ref(args))).WillOnce(Return(false));
+        EXPECT_CALL(output, chooseCompositionStrategy(_))
+                .WillOnce([mainThreadId, &calls, otherValidateStarted](auto*) {
+                    EXPECT_NE(mainThreadId, std::this_thread::get_id());
+                    calls.validateStarted.set_value();
+                    EXPECT_EQ(std::future_status::ready,
+                              otherValidateStarted.wait_for(std::chrono::seconds(5)));
+                    return true;
+                });
+        EXPECT_CALL(output, applyChosenCompositionStrategy(true, _))
+                .WillOnce([mainThreadId](bool, const auto&) {
+                    EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+                });
+        EXPECT_CALL(output, finishFrame(_)).WillOnce([mainThreadId](GpuCompositionResult&&) {
+            EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+        });
+        EXPECT_CALL(output, presentFrameAndReleaseLayers())
+                .WillOnce([mainThreadId, &calls, otherPresentStarted]() {
+                    EXPECT_NE(mainThreadId, std::this_thread::get_id());
+                    calls.presentStarted.set_value();
+                    EXPECT_EQ(std::future_status::ready,
+                              otherPresentStarted.wait_for(std::chrono::seconds(5)));
+                });
+        EXPECT_CALL(output, renderCachedSets(Ref(args))).WillOnce([mainThreadId](const auto&) {
+            EXPECT_EQ(mainThreadId, std::this_thread::get_id());
+        });
+
+        output.setPipelineHwcValidate(true);
+        output.offloadPresentNextFrame();
+    };
+
+    expectPipelinedFrame(mOutput, first, second);
+    expectPipelinedFrame(secondOutput, second, first);
+
+    // The same steps as CompositionEngine::present.
+    std::vector<ftl::Future<std::monostate>> futures;
+    futures.push_back(mOutput.present(args));
+    futures.push_back(secondOutput.present(args));
+    futures.push_back(mOutput.presentPipelinedFrame(args));
+    futures.push_back(secondOutput.presentPipelinedFrame(args));
+    for (auto& future : futures) {
+        future.get();
+    }
+}
+
 /*
  * Output::updateColorProfile()
  */
@@ -3665,6 +3931,88 @@ TEST_F(OutputComposeSurfacesTest, clientCompositionIfRequestChanges) {
     EXPECT_FALSE(mOutput.mState.reusedClientComposition);
 }
 
+TEST_F(OutputComposeSurfacesTest, clientCompositionRedrawsOnlyChangedLayers) {
+    LayerFE::LayerSettings r1;
+    LayerFE::LayerSettings r2;
+    LayerFE::LayerSettings r3;
+
+    r1.geometry.boundaries = FloatRect{1, 2, 3, 4};
+    r2.geometry.boundaries = FloatRect{5, 6, 7, 8};
+    r3.geometry.boundaries = FloatRect{5, 6, 7, 9};
+
+    EXPECT_CALL(mOutput, getSkipColorTransform()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplayColorProfile, hasWideColorGamut()).WillRepeatedly(Return(true));
+    EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mRenderEngine, isProtected()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mOutput, generateClientCompositionRequests(_, kDefaultOutputDataspace, _))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{r1, r2}))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{r1, r3}));
+    EXPECT_CALL(mOutput, appendRegionFlashRequests(RegionEq(kDebugRegion), _))
+            .WillRepeatedly(Return());
+
+    EXPECT_CALL(*mRenderSurface, dequeueBuffer(_)).WillRepeatedly(Return(mOutputBuffer));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, ElementsAre(r1, r2), _, _))
+            .WillOnce([&](const renderengine::DisplaySettings& display,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&,
+                          base::unique_fd&&) -> ftl::Future<FenceResult> {
+                // The buffer is drawn for the first time, so it is fully drawn.
+                EXPECT_FALSE(display.scissor.isValid());
+                return ftl::yield<FenceResult>(Fence::NO_FENCE);
+            });
+    EXPECT_CALL(mRenderEngine, drawLayers(_, ElementsAre(r1, r3), _, _))
+            .WillOnce([&](const renderengine::DisplaySettings& display,
+                          const std::vector<renderengine::LayerSettings>&,
+                          const std::shared_ptr<renderengine::ExternalTexture>&,
+                          base::unique_fd&&) -> ftl::Future<FenceResult> {
+                // Only the layer that changed is redrawn.
+                EXPECT_TRUE(display.scissor.isValid());
+                EXPECT_NE(display.scissor, display.physicalDisplay);
+                return ftl::yield<FenceResult>(Fence::NO_FENCE);
+            });
+
+    verify().execute().expectAFenceWasReturned();
+    EXPECT_FALSE(mOutput.mState.reusedClientComposition);
+
+    verify().execute().expectAFenceWasReturned();
+    EXPECT_FALSE(mOutput.mState.reusedClientComposition);
+}
+
+TEST_F(OutputComposeSurfacesTest, clientCompositionRedrawsEverythingWithBlur) {
+    LayerFE::LayerSettings r1;
+    LayerFE::LayerSettings r2;
+    LayerFE::LayerSettings r3;
+
+    r1.geometry.boundaries = FloatRect{1, 2, 3, 4};
+    r1.backgroundBlurRadius = 10;
+    r2.geometry.boundaries = FloatRect{5, 6, 7, 8};
+    r3.geometry.boundaries = FloatRect{5, 6, 7, 9};
+
+    EXPECT_CALL(mOutput, getSkipColorTransform()).WillRepeatedly(Return(false));
+    EXPECT_CALL(*mDisplayColorProfile, hasWideColorGamut()).WillRepeatedly(Return(true));
+    EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mRenderEngine, isProtected()).WillRepeatedly(Return(false));
+    EXPECT_CALL(mOutput, generateClientCompositionRequests(_, kDefaultOutputDataspace, _))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{r1, r2}))
+            .WillOnce(Return(std::vector<LayerFE::LayerSettings>{r1, r3}));
+    EXPECT_CALL(mOutput, appendRegionFlashRequests(RegionEq(kDebugRegion), _))
+            .WillRepeatedly(Return());
+
+    EXPECT_CALL(*mRenderSurface, dequeueBuffer(_)).WillRepeatedly(Return(mOutputBuffer));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .Times(2)
+            .WillRepeatedly([&](const renderengine::DisplaySettings& display,
+                                const std::vector<renderengine::LayerSettings>&,
+                                const std::shared_ptr<renderengine::ExternalTexture>&,
+                                base::unique_fd&&) -> ftl::Future<FenceResult> {
+                EXPECT_FALSE(display.scissor.isValid());
+                return ftl::yield<FenceResult>(Fence::NO_FENCE);
+            });
+
+    verify().execute().expectAFenceWasReturned();
+    verify().execute().expectAFenceWasReturned();
+}
+
 struct OutputComposeSurfacesTest_UsesExpectedDisplaySettings : public OutputComposeSurfacesTest {
     OutputComposeSurfacesTest_UsesExpectedDisplaySettings() {
         EXPECT_CALL(mRenderEngine, supportsProtectedContent()).WillRepeatedly(Return(false));
@@ -26,12 +26,14 @@
 #include <renderengine/mock/RenderEngine.h>
 #include <ui/GraphicTypes.h>
 #include <utils/Errors.h>
+#include <future>
 #include <memory>
 
 namespace android::compositionengine {
 using namespace std::chrono_literals;
 
 using testing::_;
+using testing::ByMove;
 using testing::DoAll;
 using testing::Invoke;
 using testing::Return;
@@ -382,6 +384,42 @@ TEST_F(CachedSetTest, renderUnsecureOutput) {
     cachedSet.append(CachedSet(layer3));
 }
 
+TEST_F(CachedSetTest, rendersIntoTextureSizedToBounds) {
+    CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE1 = mTestLayers[1]->layerFE;
+    CachedSet::Layer& layer2 = *mTestLayers[2]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE2 = mTestLayers[2]->layerFE;
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+    EXPECT_EQ(Rect(1, 1, 3, 3), cachedSet.getBounds());
+
+    // Textures are rounded up to a quarter of the display size, which is 2x2 here.
+    const ui::Size displaySize(8, 8);
+    mTexturePool.setDisplaySize(displaySize);
+    mOutputState.framebufferSpace = ProjectionSpace(displaySize, Rect(displaySize));
+    mOutputState.displaySpace = ProjectionSpace(displaySize, Rect(displaySize));
+
+    const auto drawLayers = [&](const renderengine::DisplaySettings& displaySettings,
+                                const std::vector<renderengine::LayerSettings>&,
+                                const std::shared_ptr<renderengine::ExternalTexture>& texture,
+                                base::unique_fd&&) -> ftl::Future<FenceResult> {
+        EXPECT_EQ(2u, texture->getBuffer()->getWidth());
+        EXPECT_EQ(2u, texture->getBuffer()->getHeight());
+        EXPECT_EQ(Rect(-1, -1, 7, 7), displaySettings.physicalDisplay);
+        EXPECT_EQ(mOutputState.layerStackSpace.getContent(), displaySettings.clip);
+        return ftl::yield<FenceResult>(Fence::NO_FENCE);
+    };
+
+    EXPECT_CALL(*layerFE1, prepareClientComposition(_)).WillOnce(Return(std::nullopt));
+    EXPECT_CALL(*layerFE2, prepareClientComposition(_)).WillOnce(Return(std::nullopt));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).WillOnce(Invoke(drawLayers));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true);
+    expectReadyBuffer(cachedSet);
+
+    EXPECT_EQ(Rect(1, 1, 3, 3), cachedSet.getTextureBounds());
+}
+
 TEST_F(CachedSetTest, renderSecureOutput) {
     // Skip the 0th layer to ensure that the bounding box of the layers is offset from (0, 0)
     CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
@@ -577,6 +615,73 @@ TEST_F(CachedSetTest, rendersWithOffsetFramebufferContent) {
     cachedSet.append(CachedSet(layer3));
 }
 
+TEST_F(CachedSetTest, renderAsync) {
+    CachedSet::Layer& layer1 = *mTestLayers[0]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE1 = mTestLayers[0]->layerFE;
+    CachedSet::Layer& layer2 = *mTestLayers[1]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE2 = mTestLayers[1]->layerFE;
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+
+    std::optional<compositionengine::LayerFE::LayerSettings> clientComp;
+    clientComp.emplace();
+
+    std::promise<FenceResult> fenceResult;
+    EXPECT_CALL(*layerFE1, prepareClientComposition(_)).WillOnce(Return(clientComp));
+    EXPECT_CALL(*layerFE2, prepareClientComposition(_)).WillOnce(Return(clientComp));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::Future<FenceResult>(fenceResult.get_future()))));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true, true);
+
+    // The draw has been queued, but the buffer is not used until it completes.
+    EXPECT_TRUE(cachedSet.hasPendingRender());
+    EXPECT_FALSE(cachedSet.collectPendingRender());
+    expectNoBuffer(cachedSet);
+    EXPECT_FALSE(cachedSet.hasRenderedBuffer());
+
+    fenceResult.set_value(Fence::NO_FENCE);
+    EXPECT_TRUE(cachedSet.collectPendingRender());
+    EXPECT_FALSE(cachedSet.hasPendingRender());
+    expectReadyBuffer(cachedSet);
+    EXPECT_EQ(mOutputState.framebufferSpace, cachedSet.getOutputSpace());
+}
+
+TEST_F(CachedSetTest, renderAsync_failedDrawHasNoBuffer) {
+    CachedSet::Layer& layer1 = *mTestLayers[0]->cachedSetLayer.get();
+    CachedSet::Layer& layer2 = *mTestLayers[1]->cachedSetLayer.get();
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(base::unexpected(BAD_VALUE)))));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true, true);
+
+    EXPECT_TRUE(cachedSet.collectPendingRender());
+    expectNoBuffer(cachedSet);
+    EXPECT_FALSE(cachedSet.hasRenderedBuffer());
+}
+
+TEST_F(CachedSetTest, append_dropsPendingRender) {
+    CachedSet::Layer& layer1 = *mTestLayers[0]->cachedSetLayer.get();
+    CachedSet::Layer& layer2 = *mTestLayers[1]->cachedSetLayer.get();
+    CachedSet::Layer& layer3 = *mTestLayers[2]->cachedSetLayer.get();
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::yield<FenceResult>(Fence::NO_FENCE))));
+    cachedSet.render(mRenderEngine, mTexturePool, mOutputState, true, true);
+    EXPECT_TRUE(cachedSet.hasPendingRender());
+
+    cachedSet.append(CachedSet(layer3));
+    EXPECT_FALSE(cachedSet.hasPendingRender());
+    EXPECT_FALSE(cachedSet.collectPendingRender());
+    expectNoBuffer(cachedSet);
+}
+
 TEST_F(CachedSetTest, cachingHintIncludesLayersByDefault) {
     CachedSet cachedSet(*mTestLayers[0]->cachedSetLayer.get());
     EXPECT_FALSE(cachedSet.cachingHintExcludesLayers());
@@ -29,6 +29,7 @@
 #include <renderengine/impl/ExternalTexture.h>
 #include <renderengine/mock/RenderEngine.h>
 #include <chrono>
+#include <future>
 
 namespace android::compositionengine {
 using namespace std::chrono_literals;
@@ -36,6 +37,7 @@ using impl::planner::CachedSet;
 using impl::planner::Flattener;
 using impl::planner::LayerState;
 using impl::planner::NonBufferHash;
+using impl::planner::TexturePool;
 
 using testing::_;
 using testing::ByMove;
@@ -63,6 +65,8 @@ public:
                     .mActiveLayerTimeout = 100ms,
                     .mRenderScheduling = std::nullopt,
                     .mEnableHolePunch = true,
+                    .mEnableAsyncRender = false,
+                    .mTexturePoolMemoryBudget = TexturePool::kUnlimitedMemoryBudget,
             }) {}
     void SetUp() override;
 
@@ -421,6 +425,94 @@ TEST_F(FlattenerTest, flattenLayers_addLayerToFlattenedCauseReset) {
     EXPECT_EQ(nullptr, overrideBuffer3);
 }
 
+TEST_F(FlattenerTest, flattenLayers_reusesCachedSetAfterLayerStackChange) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState3 = mTestLayers[2]->layerState;
+    const auto& overrideBuffer3 = layerState3->getOutputLayer()->getState().overrideInfo.buffer;
+
+    std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+    expectAllLayersFlattened(layers);
+    const auto flattenedBuffer = overrideBuffer1;
+
+    // add a new layer below the flattened layers, this will cause the flattener to reset
+    layers.insert(layers.begin(), layerState3.get());
+
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+    EXPECT_EQ(nullptr, overrideBuffer3);
+
+    // the layers are drawn from the same buffer at their new position, without rendering again
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).Times(0);
+    initializeOverrideBuffer(layers);
+    EXPECT_NE(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    EXPECT_EQ(nullptr, overrideBuffer3);
+    EXPECT_NE(nullptr, overrideBuffer1);
+    EXPECT_EQ(flattenedBuffer, overrideBuffer1);
+    EXPECT_EQ(overrideBuffer1, overrideBuffer2);
+}
+
+TEST_F(FlattenerTest, flattenLayers_doesNotReuseCachedSetAfterBufferUpdate) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState3 = mTestLayers[2]->layerState;
+
+    std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+    expectAllLayersFlattened(layers);
+
+    layers.insert(layers.begin(), layerState3.get());
+
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    // Layer 1 queues a new frame into the same buffer, so the cached set is stale
+    mTestLayers[0]->layerFECompositionState.frameNumber++;
+    layerState1->update(&mTestLayers[0]->outputLayer);
+    layerState1->resetFramesSinceBufferUpdate();
+
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+}
+
 TEST_F(FlattenerTest, flattenLayers_BufferUpdateToFlatten) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -1103,7 +1195,10 @@ public:
                                                                          kCachedSetRenderDuration,
                                                                  .maxDeferRenderAttempts =
                                                                          kMaxDeferRenderAttempts},
-                                        .mEnableHolePunch = true}) {}
+                                        .mEnableHolePunch = true,
+                                        .mEnableAsyncRender = false,
+                                        .mTexturePoolMemoryBudget =
+                                                TexturePool::kUnlimitedMemoryBudget}) {}
 };
 
 TEST_F(FlattenerRenderSchedulingTest, flattenLayers_renderCachedSets_defersUpToMaxAttempts) {
@@ -1140,6 +1235,100 @@ TEST_F(FlattenerRenderSchedulingTest, flattenLayers_renderCachedSets_defersUpToM
                                  true);
 }
 
+class FlattenerAsyncRenderTest : public FlattenerTest {
+public:
+    FlattenerAsyncRenderTest()
+          : FlattenerTest(Flattener::Tunables{
+                    .mActiveLayerTimeout = 100ms,
+                    .mRenderScheduling = std::nullopt,
+                    .mEnableHolePunch = true,
+                    .mEnableAsyncRender = true,
+                    .mTexturePoolMemoryBudget = TexturePool::kUnlimitedMemoryBudget,
+            }) {}
+};
+
+TEST_F(FlattenerAsyncRenderTest, flattenLayers_mergesCachedSetOnceRenderCompletes) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // Mark the layers inactive
+    mTime += 200ms;
+
+    // The draw is queued, but doesn't complete yet.
+    std::promise<FenceResult> fenceResult;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::Future<FenceResult>(fenceResult.get_future()))));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    ASSERT_TRUE(mFlattener->getNewCachedSetForTesting());
+    EXPECT_TRUE(mFlattener->getNewCachedSetForTesting()->hasPendingRender());
+
+    // While the draw is pending, the layers are composed as before and nothing is redrawn.
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).Times(0);
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+
+    // Once the draw completes, the next frame uses the cached set.
+    fenceResult.set_value(Fence::NO_FENCE);
+    initializeOverrideBuffer(layers);
+    EXPECT_NE(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    EXPECT_NE(nullptr, overrideBuffer1);
+    EXPECT_EQ(overrideBuffer1, overrideBuffer2);
+}
+
+TEST_F(FlattenerAsyncRenderTest, flattenLayers_dropsPendingCachedSetOnBufferUpdate) {
+    auto& layerState1 = mTestLayers[0]->layerState;
+    const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
+
+    auto& layerState2 = mTestLayers[1]->layerState;
+    const auto& overrideBuffer2 = layerState2->getOutputLayer()->getState().overrideInfo.buffer;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+    };
+
+    initializeFlattener(layers);
+
+    mTime += 200ms;
+
+    std::promise<FenceResult> fenceResult;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::Future<FenceResult>(fenceResult.get_future()))));
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    // A layer of the cached set updates before the draw completes, so the cached set is stale.
+    fenceResult.set_value(Fence::NO_FENCE);
+    layerState1->resetFramesSinceBufferUpdate();
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    EXPECT_FALSE(mFlattener->getNewCachedSetForTesting());
+    EXPECT_EQ(nullptr, overrideBuffer1);
+    EXPECT_EQ(nullptr, overrideBuffer2);
+}
+
 TEST_F(FlattenerTest, flattenLayers_skipsLayersDisabledFromCaching) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -30,10 +30,13 @@ const ui::Size kDisplaySizeTwo(2, 2);
 
 class TestableTexturePool : public TexturePool {
 public:
-    TestableTexturePool(renderengine::RenderEngine& renderEngine) : TexturePool(renderEngine) {}
+    TestableTexturePool(renderengine::RenderEngine& renderEngine,
+                        size_t memoryBudget = kUnlimitedMemoryBudget)
+          : TexturePool(renderEngine, memoryBudget) {}
 
     size_t getMinPoolSize() const { return kMinPoolSize; }
     size_t getMaxPoolSize() const { return kMaxPoolSize; }
+    size_t getHitRateWindow() const { return kHitRateWindow; }
     size_t getPoolSize() const { return mPool.size(); }
 };
 
@@ -170,5 +173,107 @@ TEST_F(TexturePoolTest, reallocatesWhenReEnabled) {
     EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
 }
 
+TEST_F(TexturePoolTest, releasesBuffersWhenRarelyUsed) {
+    EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
+    for (size_t i = 0; i < mTexturePool.getHitRateWindow(); i++) {
+        mTexturePool.recordFrame(false);
+    }
+    EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize() - 1);
+
+    // Starving the pool lets it grow again.
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < mTexturePool.getMinPoolSize(); i++) {
+        textures.emplace_back(mTexturePool.borrowTexture());
+    }
+    textures.clear();
+    EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
+}
+
+TEST_F(TexturePoolTest, keepsBuffersWhenFrequentlyUsed) {
+    for (size_t i = 0; i < mTexturePool.getHitRateWindow(); i++) {
+        mTexturePool.recordFrame(true);
+    }
+    EXPECT_EQ(mTexturePool.getPoolSize(), mTexturePool.getMinPoolSize());
+}
+
+TEST_F(TexturePoolTest, roundsUpSmallerTextures) {
+    const ui::Size displaySize(400, 400);
+    mTexturePool.setDisplaySize(displaySize);
+
+    auto texture = mTexturePool.borrowTexture(ui::Size(90, 150));
+    EXPECT_EQ(100u, texture->get()->getBuffer()->getWidth());
+    EXPECT_EQ(200u, texture->get()->getBuffer()->getHeight());
+    const uint64_t bufferId = texture->get()->getBuffer()->getId();
+    texture.reset();
+
+    texture = mTexturePool.borrowTexture(ui::Size(100, 101));
+    EXPECT_EQ(bufferId, texture->get()->getBuffer()->getId());
+
+    texture = mTexturePool.borrowTexture(ui::Size(800, 800));
+    EXPECT_EQ(400u, texture->get()->getBuffer()->getWidth());
+    EXPECT_EQ(400u, texture->get()->getBuffer()->getHeight());
+}
+
+TEST_F(TexturePoolTest, staysWithinMemoryBudget) {
+    // Enough memory for two 1x1 RGBA_8888 textures.
+    TestableTexturePool texturePool(mRenderEngine, 8);
+    texturePool.setEnabled(true);
+    texturePool.setDisplaySize(kDisplaySize);
+    EXPECT_EQ(texturePool.getPoolSize(), 2u);
+
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < texturePool.getMaxPoolSize(); i++) {
+        textures.emplace_back(texturePool.borrowTexture());
+    }
+    textures.clear();
+    EXPECT_EQ(texturePool.getPoolSize(), 2u);
+}
+
+TEST_F(TexturePoolTest, retainsSmallerTexturesWithinBudgetSmallerThanDisplay) {
+    // Enough memory for a 200x200 RGBA_8888 texture, but not for a display-sized one.
+    TestableTexturePool texturePool(mRenderEngine, 200 * 200 * 4);
+    texturePool.setEnabled(true);
+    texturePool.setDisplaySize(ui::Size(400, 400));
+    EXPECT_EQ(texturePool.getPoolSize(), 0u);
+
+    auto texture = texturePool.borrowTexture(ui::Size(150, 180));
+    EXPECT_EQ(200u, texture->get()->getBuffer()->getWidth());
+    EXPECT_EQ(200u, texture->get()->getBuffer()->getHeight());
+    const uint64_t bufferId = texture->get()->getBuffer()->getId();
+    texture.reset();
+    EXPECT_EQ(texturePool.getPoolSize(), 1u);
+
+    texture = texturePool.borrowTexture(ui::Size(200, 200));
+    EXPECT_EQ(bufferId, texture->get()->getBuffer()->getId());
+    texture.reset();
+
+    // Display-sized textures are still lent, but never retained.
+    texture = texturePool.borrowTexture();
+    EXPECT_EQ(400u, texture->get()->getBuffer()->getWidth());
+    texture.reset();
+    EXPECT_EQ(texturePool.getPoolSize(), 1u);
+}
+
+TEST_F(TexturePoolTest, releasesIdleTexturesOfOtherSizes) {
+    const ui::Size displaySize(400, 400);
+    mTexturePool.setDisplaySize(displaySize);
+    EXPECT_EQ(mTexturePool.getMinPoolSize(), mTexturePool.getPoolSize());
+
+    std::unordered_set<uint64_t> bufferIds;
+    std::vector<std::shared_ptr<TexturePool::AutoTexture>> textures;
+    for (size_t i = 0; i < mTexturePool.getMaxPoolSize(); i++) {
+        textures.emplace_back(mTexturePool.borrowTexture(ui::Size(100, 100)));
+        bufferIds.insert(textures.back()->get()->getBuffer()->getId());
+    }
+    textures.clear();
+    EXPECT_EQ(mTexturePool.getMaxPoolSize(), mTexturePool.getPoolSize());
+
+    // The smaller textures replaced the idle screen-sized ones.
+    for (size_t i = 0; i < mTexturePool.getMaxPoolSize(); i++) {
+        textures.emplace_back(mTexturePool.borrowTexture(ui::Size(100, 100)));
+        EXPECT_EQ(1u, bufferIds.count(textures.back()->get()->getBuffer()->getId()));
+    }
+}
+
 } // namespace
 } // namespace android::compositionengine::impl::planner
@@ -326,6 +326,7 @@ bool PowerAdvisor::startPowerHintSession(std::vector<int32_t>&& threadIds) {
 }
 
 void PowerAdvisor::setGpuFenceTime(DisplayId displayId, std::unique_ptr<FenceTime>&& fenceTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     if (displayData.gpuEndFenceTime) {
         nsecs_t signalTime = displayData.gpuEndFenceTime->getSignalTime();
@@ -352,6 +353,7 @@ void PowerAdvisor::setGpuFenceTime(DisplayId displayId, std::unique_ptr<FenceTim
 
 void PowerAdvisor::setHwcValidateTiming(DisplayId displayId, TimePoint validateStartTime,
                                         TimePoint validateEndTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     displayData.hwcValidateStartTime = validateStartTime;
     displayData.hwcValidateEndTime = validateEndTime;
@@ -359,17 +361,20 @@ void PowerAdvisor::setHwcValidateTiming(DisplayId displayId, TimePoint validateS
 
 void PowerAdvisor::setHwcPresentTiming(DisplayId displayId, TimePoint presentStartTime,
                                        TimePoint presentEndTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     DisplayTimingData& displayData = mDisplayTimingData[displayId];
     displayData.hwcPresentStartTime = presentStartTime;
     displayData.hwcPresentEndTime = presentEndTime;
 }
 
 void PowerAdvisor::setSkippedValidate(DisplayId displayId, bool skipped) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].skippedValidate = skipped;
 }
 
 void PowerAdvisor::setRequiresClientComposition(DisplayId displayId,
                                                 bool requiresClientComposition) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].usedClientComposition = requiresClientComposition;
 }
 
@@ -387,6 +392,7 @@ void PowerAdvisor::setFrameDelay(Duration frameDelayDuration) {
 }
 
 void PowerAdvisor::setHwcPresentDelayedTime(DisplayId displayId, TimePoint earliestFrameStartTime) {
+    std::lock_guard lock(mDisplayTimingDataMutex);
     mDisplayTimingData[displayId].hwcPresentDelayedTime = earliestFrameStartTime;
 }
 
@@ -408,14 +414,16 @@ void PowerAdvisor::setTotalFrameTargetWorkDuration(Duration targetDuration) {
 
 std::vector<DisplayId> PowerAdvisor::getOrderedDisplayIds(
         std::optional<TimePoint> DisplayTimingData::*sortBy) {
+    // The thread safety analysis does not see the lock held for the lambdas below.
+    auto& displayTimingData = mDisplayTimingData;
     std::vector<DisplayId> sortedDisplays;
     std::copy_if(mDisplayIds.begin(), mDisplayIds.end(), std::back_inserter(sortedDisplays),
                  [&](DisplayId id) {
-                     return mDisplayTimingData.count(id) &&
-                             (mDisplayTimingData[id].*sortBy).has_value();
+                     return displayTimingData.count(id) &&
+                             (displayTimingData[id].*sortBy).has_value();
                  });
     std::sort(sortedDisplays.begin(), sortedDisplays.end(), [&](DisplayId idA, DisplayId idB) {
-        return *(mDisplayTimingData[idA].*sortBy) < *(mDisplayTimingData[idB].*sortBy);
+        return *(displayTimingData[idA].*sortBy) < *(displayTimingData[idB].*sortBy);
     });
     return sortedDisplays;
 }
@@ -441,6 +449,7 @@ std::optional<Duration> PowerAdvisor::estimateWorkDuration() {
 
     // The timing info for the previously calculated display, if there was one
     std::optional<DisplayTimeline> previousDisplayTiming;
+    std::lock_guard lock(mDisplayTimingDataMutex);
     std::vector<DisplayId>&& displayIds =
             getOrderedDisplayIds(&DisplayTimingData::hwcPresentStartTime);
     DisplayTimeline displayTiming;
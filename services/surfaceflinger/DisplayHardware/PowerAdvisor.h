@@ -223,7 +223,7 @@ private:
 
     // Filter and sort the display ids by a given property
     std::vector<DisplayId> getOrderedDisplayIds(
-            std::optional<TimePoint> DisplayTimingData::*sortBy);
+            std::optional<TimePoint> DisplayTimingData::*sortBy) REQUIRES(mDisplayTimingDataMutex);
     // Estimates a frame's total work duration including gpu time.
     std::optional<Duration> estimateWorkDuration();
     // There are two different targets and actual work durations we care about,
@@ -231,7 +231,10 @@ private:
     Duration combineTimingEstimates(Duration totalDuration, Duration flingerDuration);
 
     bool ensurePowerHintSessionRunning() REQUIRES(mHintSessionMutex);
-    std::unordered_map<DisplayId, DisplayTimingData> mDisplayTimingData;
+    // Displays that present on their HwcAsyncWorker report their HWC timing from that thread.
+    std::mutex mDisplayTimingDataMutex;
+    std::unordered_map<DisplayId, DisplayTimingData> mDisplayTimingData
+            GUARDED_BY(mDisplayTimingDataMutex);
 
     // Current frame's delay
     Duration mFrameDelayDuration{0ns};
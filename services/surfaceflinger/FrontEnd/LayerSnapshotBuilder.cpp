@@ -333,6 +333,20 @@ uint32_t getPrimaryDisplayRotationFlags(
     return 0;
 }
 
+// Snapshot changes that are propagated from a parent snapshot to its children.
+constexpr ftl::Flags<RequestedLayerState::Changes> kChangesAffectingChildren =
+        RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
+        RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
+        RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
+        RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode;
+
+// Changes that may modify the shape of the hierarchy or the set of snapshots.
+constexpr ftl::Flags<RequestedLayerState::Changes> kChangesAffectingHierarchy =
+        RequestedLayerState::Changes::Created | RequestedLayerState::Changes::Destroyed |
+        RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Z |
+        RequestedLayerState::Changes::Mirror | RequestedLayerState::Changes::Parent |
+        RequestedLayerState::Changes::RelativeParent;
+
 } // namespace
 
 LayerSnapshot LayerSnapshotBuilder::getRootSnapshot() {
@@ -370,6 +384,7 @@ LayerSnapshotBuilder::LayerSnapshotBuilder() {}
 LayerSnapshotBuilder::LayerSnapshotBuilder(Args args) : LayerSnapshotBuilder() {
     args.forceUpdate = ForceUpdateFlags::ALL;
     updateSnapshots(args);
+    updatePackedSnapshots(args);
 }
 
 bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
@@ -415,6 +430,151 @@ bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
     return true;
 }
 
+bool LayerSnapshotBuilder::canUpdateDirtySubtrees(const Args& args) const {
+    if (!args.updateDirtySubtreesOnly || !mCanUpdateDirtySubtrees) {
+        return false;
+    }
+
+    if (args.forceUpdate != ForceUpdateFlags::NONE || args.displayChanges || args.parentCrop ||
+        !args.excludeLayerIds.empty() || args.root.getLayer()) {
+        return false;
+    }
+
+    if (args.layerLifecycleManager.getGlobalChanges().any(kChangesAffectingHierarchy)) {
+        return false;
+    }
+
+    // The recorded hierarchy nodes are only valid if the top level subtrees have not changed.
+    if (args.root.mChildren.size() != mRootSubtrees.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < mRootSubtrees.size(); i++) {
+        if (args.root.mChildren[i].first != mRootSubtrees[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LayerSnapshotBuilder::recordHierarchyNode(const LayerHierarchy& hierarchy,
+                                               const LayerHierarchy::TraversalPath& traversalPath) {
+    if (traversalPath.isClone()) {
+        // Cloned snapshots are not reachable by walking up from the mirrored layer so we cannot
+        // tell if they are dirty.
+        mHierarchyHasMirrors = true;
+        return;
+    }
+
+    auto [it, inserted] =
+            mIdToHierarchyNode.try_emplace(hierarchy.getLayer()->id,
+                                           HierarchyNode{&hierarchy, mCurrentRootIndex});
+    if (!inserted && it->second.rootIndex != mCurrentRootIndex) {
+        // The layer is reachable from two top level subtrees via relative parenting so both
+        // subtrees write to the same snapshots.
+        mRootSubtreeIsShared[it->second.rootIndex] = true;
+        mRootSubtreeIsShared[mCurrentRootIndex] = true;
+    }
+}
+
+void LayerSnapshotBuilder::markDirtySubtrees(const Args& args) {
+    mDirtyHierarchies.clear();
+    std::vector<const LayerHierarchy*> pending;
+    for (const RequestedLayerState* requested : args.layerLifecycleManager.getChangedLayers()) {
+        auto it = mIdToHierarchyNode.find(requested->id);
+        if (it == mIdToHierarchyNode.end()) {
+            // Offscreen layers are not part of the hierarchy we walk.
+            continue;
+        }
+        // A layer can be reached through its parent and its relative parent, so mark both
+        // paths up to the root.
+        pending.push_back(it->second.hierarchy);
+        while (!pending.empty()) {
+            const LayerHierarchy* hierarchy = pending.back();
+            pending.pop_back();
+            if (!hierarchy || !mDirtyHierarchies.insert(hierarchy).second) {
+                continue;
+            }
+            pending.push_back(hierarchy->getParent());
+            pending.push_back(hierarchy->getRelativeParent());
+        }
+    }
+}
+
+bool LayerSnapshotBuilder::subtreeNeedsUpdate(const LayerHierarchy& hierarchy,
+                                              const LayerSnapshot& parentSnapshot) const {
+    return parentSnapshot.changes.any(kChangesAffectingChildren) ||
+            (parentSnapshot.clientChanges & layer_state_t::AFFECTS_CHILDREN) ||
+            mDirtyHierarchies.find(&hierarchy) != mDirtyHierarchies.end();
+}
+
+bool LayerSnapshotBuilder::tryDirtySubtreeUpdate(const Args& args) {
+    if (!canUpdateDirtySubtrees(args)) {
+        return false;
+    }
+
+    ATRACE_NAME("DirtySubtreeUpdate");
+    markDirtySubtrees(args);
+
+    if (args.subtreeWorkerCount == 0) {
+        mWorkerPool.reset();
+    } else if (!mWorkerPool || mWorkerPool->getThreadCount() != args.subtreeWorkerCount) {
+        mWorkerPool = std::make_unique<WorkerPool>(args.subtreeWorkerCount, "SnapshotWorker");
+    }
+
+    // The hierarchy has not changed so every snapshot keeps its reachability and we only need to
+    // visit the subtrees that contain changed layers.
+    const LayerSnapshot& rootSnapshot = args.rootSnapshot;
+    std::atomic<size_t> visitedCount = 0;
+    auto updateRootSubtree = [this, &args, &rootSnapshot, &visitedCount](size_t rootIndex) {
+        const auto& [childHierarchy, variant] = args.root.mChildren[rootIndex];
+        LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        size_t subtreeVisitedCount = 0;
+        updateSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0,
+                                   subtreeVisitedCount);
+        visitedCount.fetch_add(subtreeVisitedCount, std::memory_order_relaxed);
+    };
+
+    std::vector<WorkerPool::Task> tasks;
+    std::vector<size_t> serialRootIndices;
+    for (size_t i = 0; i < mRootSubtrees.size(); i++) {
+        if (mDirtyHierarchies.find(mRootSubtrees[i]) == mDirtyHierarchies.end()) {
+            continue;
+        }
+        if (mWorkerPool && !mRootSubtreeIsShared[i]) {
+            tasks.emplace_back([&updateRootSubtree, i]() { updateRootSubtree(i); });
+        } else {
+            serialRootIndices.push_back(i);
+        }
+    }
+    if (!serialRootIndices.empty()) {
+        // Subtrees sharing snapshots are updated in z-order on a single thread.
+        tasks.emplace_back([&updateRootSubtree, &serialRootIndices]() {
+            for (size_t i : serialRootIndices) {
+                updateRootSubtree(i);
+            }
+        });
+    }
+
+    mUpdatingDirtySubtrees = true;
+    if (mWorkerPool && tasks.size() > 1) {
+        mWorkerPool->runAndWait(tasks);
+    } else {
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+    mUpdatingDirtySubtrees = false;
+    mDirtyHierarchies.clear();
+    mVisitedHierarchyCount = visitedCount;
+
+    updateTouchableRegionCrop(args);
+    sortSnapshotsByZ(args);
+    return true;
+}
+
 void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     ATRACE_NAME("UpdateSnapshots");
     LayerSnapshot rootSnapshot = args.rootSnapshot;
@@ -439,21 +599,38 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
         }
     }
 
+    mRecordingHierarchy = args.updateDirtySubtreesOnly && !args.root.getLayer();
+    mIdToHierarchyNode.clear();
+    mRootSubtrees.clear();
+    mRootSubtreeIsShared.clear();
+    mHierarchyHasMirrors = false;
+
     LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
+    size_t visitedCount = 0;
     if (args.root.getLayer()) {
         // The hierarchy can have a root layer when used for screenshots otherwise, it will have
         // multiple children.
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root, args.root.getLayer()->id,
                                                                 LayerHierarchy::Variant::Attached);
-        updateSnapshotsInHierarchy(args, args.root, root, rootSnapshot, /*depth=*/0);
+        updateSnapshotsInHierarchy(args, args.root, root, rootSnapshot, /*depth=*/0,
+                                   visitedCount);
     } else {
         for (auto& [childHierarchy, variant] : args.root.mChildren) {
+            if (mRecordingHierarchy) {
+                mCurrentRootIndex = mRootSubtrees.size();
+                mRootSubtrees.push_back(childHierarchy);
+                mRootSubtreeIsShared.push_back(false);
+            }
             LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
                                                                     childHierarchy->getLayer()->id,
                                                                     variant);
-            updateSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0);
+            updateSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0,
+                                       visitedCount);
         }
     }
+    mVisitedHierarchyCount = visitedCount;
+    mCanUpdateDirtySubtrees = mRecordingHierarchy && !mHierarchyHasMirrors;
+    mRecordingHierarchy = false;
 
     // Update touchable region crops outside the main update pass. This is because a layer could be
     // cropped by any other layer and it requires both snapshots to be updated.
@@ -508,25 +685,54 @@ void LayerSnapshotBuilder::update(const Args& args) {
         clearChanges(*snapshot);
     }
 
-    if (tryFastUpdate(args)) {
+    mVisitedHierarchyCount = 0;
+    if (!tryFastUpdate(args) && !tryDirtySubtreeUpdate(args)) {
+        updateSnapshots(args);
+    }
+    updatePackedSnapshots(args);
+}
+
+void LayerSnapshotBuilder::updatePackedSnapshots(const Args& args) {
+    if (!args.buildPackedSnapshots) {
+        if (mUsePackedSnapshots) {
+            mPackedSnapshots.clear();
+            mUsePackedSnapshots = false;
+        }
         return;
     }
-    updateSnapshots(args);
+
+    if (mUsePackedSnapshots && args.layerLifecycleManager.getGlobalChanges().get() == 0 &&
+        args.forceUpdate == ForceUpdateFlags::NONE && !args.displayChanges) {
+        // Nothing changed so the packed copy is still up to date.
+        return;
+    }
+    mPackedSnapshots.update(mSnapshots, static_cast<size_t>(mNumInterestingSnapshots));
+    mUsePackedSnapshots = true;
 }
 
 const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         const Args& args, const LayerHierarchy& hierarchy,
         LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot,
-        int depth) {
+        int depth, size_t& visitedCount) {
     LLOG_ALWAYS_FATAL_WITH_TRACE_IF(depth > 50,
                                     "Cycle detected in LayerSnapshotBuilder. See "
                                     "builder_stack_overflow_transactions.winscope");
 
+    if (mRecordingHierarchy) {
+        recordHierarchyNode(hierarchy, traversalPath);
+    }
+    visitedCount++;
+
     const RequestedLayerState* layer = hierarchy.getLayer();
     LayerSnapshot* snapshot = getSnapshot(traversalPath);
     const bool newSnapshot = snapshot == nullptr;
     uint32_t primaryDisplayRotationFlags = getPrimaryDisplayRotationFlags(args.displays);
     if (newSnapshot) {
+        // Snapshots may be updated from multiple threads when updating dirty subtrees, so they
+        // must not be created there. The hierarchy is unchanged so this should never happen.
+        LLOG_ALWAYS_FATAL_WITH_TRACE_IF(mUpdatingDirtySubtrees,
+                                        "Missing snapshot for %s while updating dirty subtrees",
+                                        traversalPath.toString().c_str());
         snapshot = createSnapshot(traversalPath, *layer, parentSnapshot);
         snapshot->merge(*layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
                         primaryDisplayRotationFlags);
@@ -544,12 +750,16 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
     }
 
     for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        if (mUpdatingDirtySubtrees && !subtreeNeedsUpdate(*childHierarchy, *snapshot)) {
+            // Nothing in this subtree changed and there is nothing to propagate from the parent.
+            continue;
+        }
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
                                                                 childHierarchy->getLayer()->id,
                                                                 variant);
         const LayerSnapshot& childSnapshot =
                 updateSnapshotsInHierarchy(args, *childHierarchy, traversalPath, *snapshot,
-                                           depth + 1);
+                                           depth + 1, visitedCount);
         updateFrameRateFromChildSnapshot(*snapshot, childSnapshot, args);
     }
 
@@ -705,11 +915,8 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
                                           const LayerSnapshot& parentSnapshot,
                                           const LayerHierarchy::TraversalPath& path) {
     // Always update flags and visibility
-    ftl::Flags<RequestedLayerState::Changes> parentChanges = parentSnapshot.changes &
-            (RequestedLayerState::Changes::Hierarchy | RequestedLayerState::Changes::Geometry |
-             RequestedLayerState::Changes::Visibility | RequestedLayerState::Changes::Metadata |
-             RequestedLayerState::Changes::AffectsChildren | RequestedLayerState::Changes::Input |
-             RequestedLayerState::Changes::FrameRate | RequestedLayerState::Changes::GameMode);
+    ftl::Flags<RequestedLayerState::Changes> parentChanges =
+            parentSnapshot.changes & kChangesAffectingChildren;
     snapshot.changes |= parentChanges;
     if (args.displayChanges) snapshot.changes |= RequestedLayerState::Changes::Geometry;
     snapshot.reachablilty = LayerSnapshot::Reachablilty::Reachable;
@@ -1089,6 +1296,7 @@ void LayerSnapshotBuilder::updateInput(LayerSnapshot& snapshot,
     }
 
     if (requested.touchCropId != UNASSIGNED_LAYER_ID || path.isClone()) {
+        std::scoped_lock lock(mTouchableRegionCropMutex);
         mNeedsTouchableRegionCrop.insert(path);
     }
     auto cropLayerSnapshot = getSnapshot(requested.touchCropId);
@@ -1122,6 +1330,12 @@ std::vector<std::unique_ptr<LayerSnapshot>>& LayerSnapshotBuilder::getSnapshots(
 }
 
 void LayerSnapshotBuilder::forEachVisibleSnapshot(const ConstVisitor& visitor) const {
+    if (mUsePackedSnapshots) {
+        mPackedSnapshots.forEachWithFlag(PackedLayerSnapshots::Visible, [&](size_t i) {
+            visitor(*mPackedSnapshots.getSnapshot(i));
+        });
+        return;
+    }
     for (int i = 0; i < mNumInterestingSnapshots; i++) {
         LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
         if (!snapshot.isVisible) continue;
@@ -1152,6 +1366,13 @@ void LayerSnapshotBuilder::forEachVisibleSnapshot(const Visitor& visitor) {
 }
 
 void LayerSnapshotBuilder::forEachInputSnapshot(const ConstVisitor& visitor) const {
+    if (mUsePackedSnapshots) {
+        mPackedSnapshots.forEachWithFlagReversed(PackedLayerSnapshots::HasInputInfo,
+                                                 [&](size_t i) {
+                                                     visitor(*mPackedSnapshots.getSnapshot(i));
+                                                 });
+        return;
+    }
     for (int i = mNumInterestingSnapshots - 1; i >= 0; i--) {
         LayerSnapshot& snapshot = *mSnapshots[(size_t)i];
         if (!snapshot.hasInputInfo()) continue;
@@ -1159,6 +1380,22 @@ void LayerSnapshotBuilder::forEachInputSnapshot(const ConstVisitor& visitor) con
     }
 }
 
+void LayerSnapshotBuilder::forEachVisibleBounds(const VisibleBoundsVisitor& visitor) const {
+    if (mUsePackedSnapshots) {
+        const auto& layerIds = mPackedSnapshots.getLayerIds();
+        const auto& outputFilters = mPackedSnapshots.getOutputFilters();
+        const auto& visibleBounds = mPackedSnapshots.getVisibleBounds();
+        mPackedSnapshots.forEachWithFlag(PackedLayerSnapshots::Visible, [&](size_t i) {
+            visitor(layerIds[i], outputFilters[i], visibleBounds[i]);
+        });
+        return;
+    }
+    forEachVisibleSnapshot([&visitor](const LayerSnapshot& snapshot) {
+        visitor(snapshot.path.id, snapshot.outputFilter,
+                snapshot.transformedBoundsWithoutTransparentRegion);
+    });
+}
+
 void LayerSnapshotBuilder::updateTouchableRegionCrop(const Args& args) {
     if (mNeedsTouchableRegionCrop.empty()) {
         return;
@@ -16,11 +16,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerLifecycleManager.h"
 #include "LayerHierarchy.h"
 #include "LayerSnapshot.h"
+#include "PackedLayerSnapshots.h"
 #include "RequestedLayerState.h"
+#include "WorkerPool.h"
 
 namespace android::surfaceflinger::frontend {
 
@@ -32,6 +37,10 @@ namespace android::surfaceflinger::frontend {
 
 // The builder also uses a fast path to update
 // snapshots when there are only buffer updates.
+
+// When there are no hierarchy changes, the builder can optionally skip
+// subtrees that do not contain any changed layers and update independent
+// top level subtrees on a pool of worker threads.
 class LayerSnapshotBuilder {
 private:
     static LayerSnapshot getRootSnapshot();
@@ -59,6 +68,14 @@ public:
         const std::unordered_map<std::string, uint32_t>& genericLayerMetadataKeyMap;
         bool skipRoundCornersWhenProtected = false;
         LayerSnapshot rootSnapshot = getRootSnapshot();
+        // Only walk the subtrees that contain changed layers if the hierarchy has not changed
+        // since the last update.
+        bool updateDirtySubtreesOnly = false;
+        // Number of worker threads used to update independent top level subtrees in parallel
+        // when updating dirty subtrees. 0 updates all subtrees on the calling thread.
+        size_t subtreeWorkerCount = 0;
+        // Maintain a packed copy of the hot snapshot fields. See getPackedSnapshots.
+        bool buildPackedSnapshots = false;
     };
     LayerSnapshotBuilder();
 
@@ -74,6 +91,11 @@ public:
     LayerSnapshot* getSnapshot(uint32_t layerId) const;
     LayerSnapshot* getSnapshot(const LayerHierarchy::TraversalPath& id) const;
 
+    // Packed copy of the hot fields of the interesting snapshots in z-order, used by
+    // forEachVisibleSnapshot, forEachVisibleBounds and forEachInputSnapshot. Empty unless
+    // Args::buildPackedSnapshots is set. Only valid until the next update.
+    const PackedLayerSnapshots& getPackedSnapshots() const { return mPackedSnapshots; }
+
     typedef std::function<void(const LayerSnapshot& snapshot)> ConstVisitor;
 
     // Visit each visible snapshot in z-order
@@ -89,6 +111,13 @@ public:
     // Visit each snapshot interesting to input reverse z-order
     void forEachInputSnapshot(const ConstVisitor& visitor) const;
 
+    typedef std::function<void(uint32_t layerId, const ui::LayerFilter& outputFilter,
+                               const Rect& visibleBounds)>
+            VisibleBoundsVisitor;
+    // Visit the layer id, output filter and bounds without the transparent region of each
+    // visible snapshot in z-order. Reads the packed columns when they are built.
+    void forEachVisibleBounds(const VisibleBoundsVisitor& visitor) const;
+
 private:
     friend class LayerSnapshotTest;
 
@@ -96,11 +125,23 @@ private:
     // the fast path.
     bool tryFastUpdate(const Args& args);
 
+    // return true if we were able to update the snapshots by only walking
+    // the subtrees containing changed layers.
+    bool tryDirtySubtreeUpdate(const Args& args);
+    bool canUpdateDirtySubtrees(const Args& args) const;
+    void markDirtySubtrees(const Args& args);
+    void recordHierarchyNode(const LayerHierarchy& hierarchy,
+                             const LayerHierarchy::TraversalPath& traversalPath);
+    bool subtreeNeedsUpdate(const LayerHierarchy& hierarchy,
+                            const LayerSnapshot& parentSnapshot) const;
+
     void updateSnapshots(const Args& args);
+    void updatePackedSnapshots(const Args& args);
 
     const LayerSnapshot& updateSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
                                                     LayerHierarchy::TraversalPath& traversalPath,
-                                                    const LayerSnapshot& parentSnapshot, int depth);
+                                                    const LayerSnapshot& parentSnapshot, int depth,
+                                                    size_t& visitedCount);
     void updateSnapshot(LayerSnapshot&, const Args&, const RequestedLayerState&,
                         const LayerSnapshot& parentSnapshot, const LayerHierarchy::TraversalPath&);
     static void updateRelativeState(LayerSnapshot& snapshot, const LayerSnapshot& parentSnapshot,
@@ -132,9 +173,36 @@ private:
     // Track snapshots that needs touchable region crop from other snapshots
     std::unordered_set<LayerHierarchy::TraversalPath, LayerHierarchy::TraversalPathHash>
             mNeedsTouchableRegionCrop;
+    std::mutex mTouchableRegionCropMutex;
     std::vector<std::unique_ptr<LayerSnapshot>> mSnapshots;
-    bool mResortSnapshots = false;
+    // Set from worker threads when updating dirty subtrees in parallel.
+    std::atomic_bool mResortSnapshots = false;
     int mNumInterestingSnapshots = 0;
+
+    // Hierarchy nodes recorded during the last full walk, used to find the
+    // subtrees affected by changed layers. See tryDirtySubtreeUpdate.
+    struct HierarchyNode {
+        const LayerHierarchy* hierarchy;
+        size_t rootIndex;
+    };
+    std::unordered_map<uint32_t, HierarchyNode> mIdToHierarchyNode;
+    // Top level subtrees in the order they were walked, and whether they share snapshots with
+    // another top level subtree through relative parenting.
+    std::vector<const LayerHierarchy*> mRootSubtrees;
+    std::vector<bool> mRootSubtreeIsShared;
+    std::unordered_set<const LayerHierarchy*> mDirtyHierarchies;
+    size_t mCurrentRootIndex = 0;
+    bool mRecordingHierarchy = false;
+    bool mHierarchyHasMirrors = false;
+    bool mCanUpdateDirtySubtrees = false;
+    bool mUpdatingDirtySubtrees = false;
+    // Number of hierarchy nodes walked by the last update, for tests. Each walk counts locally
+    // and the total is stored once the update is done.
+    size_t mVisitedHierarchyCount = 0;
+    std::unique_ptr<WorkerPool> mWorkerPool;
+
+    PackedLayerSnapshots mPackedSnapshots;
+    bool mUsePackedSnapshots = false;
 };
 
 } // namespace android::surfaceflinger::frontend
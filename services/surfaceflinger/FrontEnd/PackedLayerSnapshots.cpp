@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+#undef LOG_TAG
+#define LOG_TAG "SurfaceFlinger"
+
+#include <gui/TraceUtils.h>
+
+#include "PackedLayerSnapshots.h"
+
+namespace android::surfaceflinger::frontend {
+
+void PackedLayerSnapshots::update(const std::vector<std::unique_ptr<LayerSnapshot>>& snapshots,
+                                  size_t count) {
+    ATRACE_CALL();
+    count = std::min(count, snapshots.size());
+    // resize keeps the capacity so steady state updates do not allocate.
+    mLayerIds.resize(count);
+    mOutputFilters.resize(count);
+    mVisibleBounds.resize(count);
+    mFlags.resize(count);
+    mSnapshots.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        LayerSnapshot& snapshot = *snapshots[i];
+        mLayerIds[i] = snapshot.path.id;
+        mOutputFilters[i] = snapshot.outputFilter;
+        mVisibleBounds[i] = snapshot.transformedBoundsWithoutTransparentRegion;
+
+        uint8_t flags = 0;
+        if (snapshot.isVisible) flags |= Visible;
+        if (snapshot.hasInputInfo()) flags |= HasInputInfo;
+        mFlags[i] = flags;
+        mSnapshots[i] = &snapshot;
+    }
+}
+
+void PackedLayerSnapshots::clear() {
+    mLayerIds.clear();
+    mOutputFilters.clear();
+    mVisibleBounds.clear();
+    mFlags.clear();
+    mSnapshots.clear();
+}
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <ui/LayerStack.h>
+#include <ui/Rect.h>
+
+#include "LayerSnapshot.h"
+
+namespace android::surfaceflinger::frontend {
+
+// Structure of arrays copy of the LayerSnapshot fields that are read every frame, stored in
+// z-order so the index of a snapshot is its z. The visible and input snapshot walks test the
+// packed flags, and passes that only need the layer id, output filter and visible bounds read
+// those columns, instead of dereferencing every LayerSnapshot, which are large and scattered
+// across the heap. The LayerSnapshot remains the source of truth and can be reached via
+// getSnapshot(). The arrays are only valid until the next LayerSnapshotBuilder::update.
+class PackedLayerSnapshots {
+public:
+    enum Flags : uint8_t {
+        Visible = 1 << 0,
+        HasInputInfo = 1 << 1,
+    };
+
+    // Copies the hot fields of the first |count| snapshots, which are expected to be sorted
+    // in z-order.
+    void update(const std::vector<std::unique_ptr<LayerSnapshot>>& snapshots, size_t count);
+    void clear();
+
+    size_t size() const { return mSnapshots.size(); }
+    bool empty() const { return mSnapshots.empty(); }
+
+    const std::vector<uint32_t>& getLayerIds() const { return mLayerIds; }
+    const std::vector<ui::LayerFilter>& getOutputFilters() const { return mOutputFilters; }
+    // LayerSnapshot::transformedBoundsWithoutTransparentRegion
+    const std::vector<Rect>& getVisibleBounds() const { return mVisibleBounds; }
+    LayerSnapshot* getSnapshot(size_t index) const { return mSnapshots[index]; }
+
+    bool test(size_t index, Flags flag) const { return (mFlags[index] & flag) != 0; }
+
+    // Calls visitor with the z-order index of each snapshot that has |flag| set.
+    template <typename Visitor>
+    void forEachWithFlag(Flags flag, Visitor&& visitor) const {
+        const size_t count = mFlags.size();
+        for (size_t i = 0; i < count; i++) {
+            if (mFlags[i] & flag) visitor(i);
+        }
+    }
+
+    // Same as forEachWithFlag but walks from the top of the z-order down.
+    template <typename Visitor>
+    void forEachWithFlagReversed(Flags flag, Visitor&& visitor) const {
+        for (size_t i = mFlags.size(); i > 0; i--) {
+            if (mFlags[i - 1] & flag) visitor(i - 1);
+        }
+    }
+
+private:
+    std::vector<uint32_t> mLayerIds;
+    std::vector<ui::LayerFilter> mOutputFilters;
+    std::vector<Rect> mVisibleBounds;
+    std::vector<uint8_t> mFlags;
+    std::vector<LayerSnapshot*> mSnapshots;
+};
+
+} // namespace android::surfaceflinger::frontend
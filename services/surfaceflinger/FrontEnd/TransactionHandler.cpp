@@ -29,20 +29,25 @@
 namespace android::surfaceflinger::frontend {
 
 void TransactionHandler::queueTransaction(TransactionState&& state) {
+    if (mPrecomputeReadiness) {
+        state.pollAcquireFences();
+    }
     mLocklessTransactionQueue.push(std::move(state));
     mPendingTransactionCount.fetch_add(1);
     ATRACE_INT("TransactionQueue", static_cast<int>(mPendingTransactionCount.load()));
 }
 
 void TransactionHandler::collectTransactions() {
+    const nsecs_t startTime = systemTime();
     while (!mLocklessTransactionQueue.isEmpty()) {
         auto maybeTransaction = mLocklessTransactionQueue.pop();
         if (!maybeTransaction.has_value()) {
             break;
         }
-        auto transaction = maybeTransaction.value();
+        auto& transaction = maybeTransaction.value();
         mPendingTransactionQueues[transaction.applyToken].emplace(std::move(transaction));
     }
+    ATRACE_INT64("CollectTransactionsDurationNs", systemTime() - startTime);
 }
 
 std::vector<TransactionState> TransactionHandler::flushTransactions() {
@@ -180,6 +185,10 @@ int TransactionHandler::flushPendingTransactionQueues(std::vector<TransactionSta
     return transactionsPendingBarrier;
 }
 
+void TransactionHandler::enableReadinessPrecompute() {
+    mPrecomputeReadiness = true;
+}
+
 void TransactionHandler::addTransactionReadyFilter(TransactionFilter&& filter) {
     mTransactionReadyFilters.emplace_back(std::move(filter));
 }
@@ -17,11 +17,13 @@
 #pragma once
 
 #include <semaphore.h>
+#include <atomic>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <vector>
 
-#include <LocklessQueue.h>
+#include <LocklessRingQueue.h>
 #include <TransactionState.h>
 #include <android-base/thread_annotations.h>
 #include <ftl/small_map.h>
@@ -65,6 +67,10 @@ public:
     void addTransactionReadyFilter(TransactionFilter&&);
     void queueTransaction(TransactionState&&);
 
+    // Polls buffer acquire fences on the binder thread when a transaction is queued, so the
+    // readiness filters on the main thread only query the fences that were still unsignaled.
+    void enableReadinessPrecompute();
+
     struct StalledTransactionInfo {
         pid_t pid;
         uint32_t layerId;
@@ -88,10 +94,15 @@ private:
     TransactionReadiness applyFilters(TransactionFlushState&);
     std::unordered_map<sp<IBinder>, std::queue<TransactionState>, IListenerHash>
             mPendingTransactionQueues;
-    LocklessQueue<TransactionState> mLocklessTransactionQueue;
+    // Sized to absorb a burst of transactions between two commits without allocating. Pushes
+    // beyond this still succeed but allocate.
+    static constexpr size_t kTransactionQueueCapacity = 256;
+    LocklessRingQueue<TransactionState, kTransactionQueueCapacity> mLocklessTransactionQueue;
     std::atomic<size_t> mPendingTransactionCount = 0;
     ftl::SmallVector<TransactionFilter, 2> mTransactionReadyFilters;
 
+    std::atomic_bool mPrecomputeReadiness = false;
+
     std::mutex mStalledMutex;
     std::unordered_map<uint64_t /* transactionId */, StalledTransactionInfo> mStalledTransactions
             GUARDED_BY(mStalledMutex);
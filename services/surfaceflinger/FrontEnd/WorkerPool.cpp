@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "SurfaceFlinger"
+
+#include <pthread.h>
+
+#include "WorkerPool.h"
+
+namespace android::surfaceflinger::frontend {
+
+WorkerPool::WorkerPool(size_t threadCount, std::string name) {
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        mThreads.emplace_back([this] { threadMain(); });
+        // Thread names are limited to 16 characters including the null terminator.
+        const std::string threadName = (name + std::to_string(i)).substr(0, 15);
+        pthread_setname_np(mThreads.back().native_handle(), threadName.c_str());
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::scoped_lock lock(mMutex);
+        mDone = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::runAndWait(std::vector<Task>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mMutex);
+        mTasks = &tasks;
+        mNextTask = 0;
+        mRemainingTasks = tasks.size();
+        mGeneration++;
+    }
+    mWorkAvailable.notify_all();
+
+    drainTasks();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWorkDone.wait(lock, [this]() REQUIRES(mMutex) { return mRemainingTasks == 0; });
+    mTasks = nullptr;
+}
+
+void WorkerPool::drainTasks() {
+    while (true) {
+        Task* task;
+        {
+            std::scoped_lock lock(mMutex);
+            if (!mTasks || mNextTask >= mTasks->size()) {
+                return;
+            }
+            task = &(*mTasks)[mNextTask++];
+        }
+
+        (*task)();
+
+        std::scoped_lock lock(mMutex);
+        if (--mRemainingTasks == 0) {
+            mWorkDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::threadMain() {
+    uint64_t lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkAvailable.wait(lock, [&]() REQUIRES(mMutex) {
+                return mDone || mGeneration != lastGeneration;
+            });
+            if (mDone) {
+                return;
+            }
+            lastGeneration = mGeneration;
+        }
+        drainTasks();
+    }
+}
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <android-base/thread_annotations.h>
+
+namespace android::surfaceflinger::frontend {
+
+// Fixed size pool of threads used to fan out independent units of work, such as disjoint layer
+// subtrees, and wait for all of them to complete. The calling thread participates in running the
+// tasks so a pool with N threads can run N + 1 tasks concurrently.
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    WorkerPool(size_t threadCount, std::string name);
+    ~WorkerPool();
+
+    size_t getThreadCount() const { return mThreads.size(); }
+
+    // Runs all the tasks and returns once every task has completed. Tasks may run in any order
+    // and on any thread, including the calling thread. Not safe to call from multiple threads.
+    void runAndWait(std::vector<Task>& tasks);
+
+private:
+    void threadMain();
+    // Claims and runs tasks from the current batch until there are none left to claim.
+    void drainTasks();
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mWorkDone;
+    std::vector<Task>* mTasks GUARDED_BY(mMutex) = nullptr;
+    size_t mNextTask GUARDED_BY(mMutex) = 0;
+    size_t mRemainingTasks GUARDED_BY(mMutex) = 0;
+    uint64_t mGeneration GUARDED_BY(mMutex) = 0;
+    bool mDone GUARDED_BY(mMutex) = false;
+
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "LocklessQueue.h"
+
+// Multi producer single consumer FIFO queue backed by a preallocated ring of |Capacity| slots.
+// Unlike LocklessQueue, push does not allocate while the consumer keeps up, and pop does not
+// need to reverse a list.
+//
+// Every push claims a ticket with a single fetch_add on mTail. Ticket t maps to slot
+// t % Capacity, and the slot's sequence number tells whether it is free for this lap:
+//   sequence == t      the slot is free for ticket t
+//   sequence == t + 1  ticket t has been published and can be popped
+// After popping ticket t from its slot the consumer moves the sequence on to the next lap that
+// has not been popped yet, freeing the slot for that ticket.
+//
+// If a producer finds its slot still occupied by a value from an earlier lap, the ring is full.
+// Rather than block a binder thread, the value is pushed with its ticket onto an overflow
+// LocklessQueue. The consumer drains the overflow queue into a ticket ordered map and looks
+// tickets up there when they are not in the ring.
+//
+// Like LocklessQueue, a value is poppable as soon as its push returns. A producer that is
+// preempted between claiming its ticket and publishing its value does not hold back values
+// claimed after it: pop remembers the unpublished ticket, moves on to the next one, and returns
+// the remembered ticket once it is published. Published values are popped in ticket order, so
+// values pushed by one thread are popped in the order they were pushed.
+template <typename T, size_t Capacity>
+class LocklessRingQueue {
+    // With a single slot, "published ticket t" and "free for ticket t + 1" would look the same.
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two greater than one");
+
+public:
+    LocklessRingQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // True when every pushed value has been popped. Values still being published by a preempted
+    // producer count as queued, so pop can return nullopt while this returns false.
+    bool isEmpty() const {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire) &&
+                mUnpublishedCount.load(std::memory_order_acquire) == 0;
+    }
+
+    void push(T value) {
+        const uint64_t ticket = mTail.fetch_add(1, std::memory_order_acq_rel);
+        Slot& slot = mSlots[ticket & kMask];
+        if (slot.sequence.load(std::memory_order_acquire) == ticket) {
+            slot.value.emplace(std::move(value));
+            slot.sequence.store(ticket + 1, std::memory_order_release);
+            return;
+        }
+        mOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        mOverflow.push({ticket, std::move(value)});
+    }
+
+    // Must only be called from a single consumer thread.
+    std::optional<T> pop() {
+        // Tickets passed over earlier are older than anything at the head.
+        for (auto it = mUnpublished.begin(); it != mUnpublished.end(); ++it) {
+            if (auto value = tryTake(*it)) {
+                mUnpublished.erase(it);
+                mUnpublishedCount.store(mUnpublished.size(), std::memory_order_release);
+                return value;
+            }
+        }
+
+        const uint64_t tail = mTail.load(std::memory_order_acquire);
+        for (uint64_t ticket = mHead.load(std::memory_order_relaxed); ticket != tail; ticket++) {
+            std::optional<T> value = tryTake(ticket);
+            if (!value) {
+                // The producer holding this ticket has not published yet. Skip it rather than
+                // hold back the tickets claimed after it.
+                mUnpublished.push_back(ticket);
+                mUnpublishedCount.store(mUnpublished.size(), std::memory_order_release);
+            }
+            mHead.store(ticket + 1, std::memory_order_release);
+            if (value) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+    // Number of pushes that found the ring full and had to allocate.
+    uint64_t getOverflowCount() const { return mOverflowCount.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint64_t kMask = Capacity - 1;
+    // Keep the producer and consumer indices on separate cache lines.
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::optional<T> value;
+    };
+
+    // Takes the value of |ticket| from its slot or the overflow entries if it has been published.
+    std::optional<T> tryTake(uint64_t ticket) {
+        Slot& slot = mSlots[ticket & kMask];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        std::optional<T> value;
+        if (sequence == ticket + 1) {
+            value = std::move(slot.value);
+            slot.value.reset();
+        } else if (auto it = findOverflow(ticket); it != mOverflowEntries.end()) {
+            value = std::move(it->second);
+            mOverflowEntries.erase(it);
+            if (sequence != ticket) {
+                // The slot belongs to another ticket.
+                return value;
+            }
+            // The slot was freed for this ticket after its producer had already overflowed.
+        } else {
+            return std::nullopt;
+        }
+        slot.sequence.store(nextFreeSequence(ticket), std::memory_order_release);
+        return value;
+    }
+
+    // The ticket the slot of |ticket| should be freed for: the first later lap that has not been
+    // popped. Producers of popped tickets are done, so none of them can be waiting for the slot.
+    uint64_t nextFreeSequence(uint64_t ticket) const {
+        const uint64_t head = mHead.load(std::memory_order_relaxed);
+        uint64_t sequence = ticket + Capacity;
+        while (sequence < head &&
+               std::find(mUnpublished.begin(), mUnpublished.end(), sequence) ==
+                       mUnpublished.end()) {
+            sequence += Capacity;
+        }
+        return sequence;
+    }
+
+    typename std::map<uint64_t, T>::iterator findOverflow(uint64_t ticket) {
+        while (auto entry = mOverflow.pop()) {
+            mOverflowEntries.emplace(entry->first, std::move(entry->second));
+        }
+        return mOverflowEntries.find(ticket);
+    }
+
+    alignas(kCacheLineSize) std::atomic<uint64_t> mTail = 0;
+    // Next ticket the consumer has not looked at. Tickets before it have been popped, or are in
+    // mUnpublished.
+    alignas(kCacheLineSize) std::atomic<uint64_t> mHead = 0;
+    std::atomic<size_t> mUnpublishedCount = 0;
+    std::atomic<uint64_t> mOverflowCount = 0;
+    std::array<Slot, Capacity> mSlots;
+
+    LocklessQueue<std::pair<uint64_t, T>> mOverflow;
+    // Overflowed values the consumer has taken out of mOverflow but not yet reached. Only
+    // accessed by the consumer.
+    std::map<uint64_t, T> mOverflowEntries;
+    // Tickets below mHead whose producers had not published when the consumer reached them, in
+    // ticket order. Only accessed by the consumer.
+    std::vector<uint64_t> mUnpublished;
+};
@@ -24,6 +24,7 @@
 #include <sched.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <optional>
@@ -35,6 +36,7 @@
 #include <binder/IPCThreadState.h>
 
 #include <cutils/compiler.h>
+#include <cutils/properties.h>
 #include <cutils/sched_policy.h>
 
 #include <gui/DisplayEventReceiver.h>
@@ -44,6 +46,7 @@
 #include <utils/Trace.h>
 
 #include <common/FlagManager.h>
+#include <ftl/small_vector.h>
 #include <scheduler/VsyncConfig.h>
 #include "DisplayHardware/DisplayMode.h"
 #include "FrameTimeline.h"
@@ -189,6 +192,10 @@ DisplayEventReceiver::Event makeHdcpLevelsChange(PhysicalDisplayId displayId,
     };
 }
 
+bool shareVsyncData() {
+    return property_get_bool("debug.sf.event_thread_share_vsync_data", false);
+}
+
 } // namespace
 
 EventThreadConnection::EventThreadConnection(EventThread* eventThread, uid_t callingUid,
@@ -282,7 +289,8 @@ EventThread::EventThread(const char* name, std::shared_ptr<scheduler::VsyncSched
         mVsyncSchedule(std::move(vsyncSchedule)),
         mVsyncRegistration(mVsyncSchedule->getDispatch(), createDispatchCallback(), name),
         mTokenManager(tokenManager),
-        mCallback(callback) {
+        mCallback(callback),
+        mShareVsyncData(shareVsyncData()) {
     mThread = std::thread([this]() NO_THREAD_SAFETY_ANALYSIS {
         std::unique_lock<std::mutex> lock(mMutex);
         threadMain(lock);
@@ -323,6 +331,11 @@ void EventThread::setDuration(std::chrono::nanoseconds workDuration,
                                .lastVsync = mLastVsyncCallbackTime.ns()});
 }
 
+void EventThread::setShareVsyncData(bool share) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mShareVsyncData = share;
+}
+
 sp<EventThreadConnection> EventThread::createEventConnection(
         EventRegistrationFlags eventRegistration) const {
     auto connection = sp<EventThreadConnection>::make(const_cast<EventThread*>(this),
@@ -700,14 +713,31 @@ void EventThread::generateFrameTimeline(VsyncEventData& outVsyncEventData, nsecs
 
 void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
                                 const DisplayEventConsumers& consumers) {
+    // Frame timelines formatted for this event, by frame interval, when mShareVsyncData is set.
+    ftl::SmallVector<std::pair<nsecs_t, VsyncEventData>, 2> sharedVsyncData;
+
     for (const auto& consumer : consumers) {
         DisplayEventReceiver::Event copy = event;
         if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
             const Period frameInterval = mCallback.getVsyncPeriod(consumer->mOwnerUid);
-            copy.vsync.vsyncData.frameInterval = frameInterval.ns();
-            generateFrameTimeline(copy.vsync.vsyncData, frameInterval.ns(), copy.header.timestamp,
-                                  event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                  event.vsync.vsyncData.preferredDeadlineTimestamp());
+            const auto it = std::find_if(sharedVsyncData.begin(), sharedVsyncData.end(),
+                                         [&](const auto& entry) {
+                                             return entry.first == frameInterval.ns();
+                                         });
+            if (it != sharedVsyncData.end()) {
+                copy.vsync.vsyncData = it->second;
+            } else {
+                copy.vsync.vsyncData.frameInterval = frameInterval.ns();
+                generateFrameTimeline(copy.vsync.vsyncData, frameInterval.ns(),
+                                      copy.header.timestamp,
+                                      event.vsync.vsyncData.preferredExpectedPresentationTime(),
+                                      event.vsync.vsyncData.preferredDeadlineTimestamp());
+                mVsyncDataFormatted++;
+                if (mShareVsyncData) {
+                    sharedVsyncData.emplace_back(frameInterval.ns(), copy.vsync.vsyncData);
+                }
+            }
+            mVsyncEventsPosted++;
         }
         switch (consumer->postEvent(copy)) {
             case NO_ERROR:
@@ -749,6 +779,10 @@ void EventThread::dump(std::string& result) const {
                   mWorkDuration.get().count() / 1e6f, mReadyDuration.count() / 1e6f);
     StringAppendF(&result, "%.2fms relative to now\n", relativeLastCallTime);
 
+    StringAppendF(&result, "  shared vsync data: %s, %zu frame timelines for %zu vsync events\n",
+                  mShareVsyncData ? "enabled" : "disabled", mVsyncDataFormatted,
+                  mVsyncEventsPosted);
+
     StringAppendF(&result, "  pending events (count=%zu):\n", mPendingEvents.size());
     for (const auto& event : mPendingEvents) {
         StringAppendF(&result, "    %s\n", toString(event).c_str());
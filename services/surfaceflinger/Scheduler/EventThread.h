@@ -184,6 +184,11 @@ public:
     void onHdcpLevelsChanged(PhysicalDisplayId displayId, int32_t connectedLevel,
                              int32_t maxLevel) override;
 
+    // Sets whether connections that get a VSYNC at the same frame interval share one set of
+    // frame timelines, instead of each getting timelines with their own vsync ids. The default
+    // comes from debug.sf.event_thread_share_vsync_data.
+    void setShareVsyncData(bool share) EXCLUDES(mMutex);
+
 private:
     friend EventThreadTest;
 
@@ -259,6 +264,17 @@ private:
 
     State mState GUARDED_BY(mMutex) = State::Idle;
 
+    // With 100+ connections, formatting the frame timelines for every connection costs a token
+    // per timeline per connection, each taking the token manager lock. Most connections are at
+    // the display rate, so the timelines are formatted once per distinct frame interval and
+    // copied into every event at that interval.
+    bool mShareVsyncData GUARDED_BY(mMutex);
+
+    // Number of VSYNC events posted and number of frame timelines formatted for them, to see
+    // how much sharing saves.
+    size_t mVsyncEventsPosted GUARDED_BY(mMutex) = 0;
+    size_t mVsyncDataFormatted GUARDED_BY(mMutex) = 0;
+
     static const char* toCString(State);
 };
 
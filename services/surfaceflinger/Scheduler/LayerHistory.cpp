@@ -33,6 +33,7 @@
 
 #include <common/FlagManager.h>
 #include "../Layer.h"
+#include "../LocklessRingQueue.h"
 #include "EventThread.h"
 #include "LayerInfo.h"
 
@@ -63,6 +64,10 @@ bool traceEnabled() {
     return property_get_bool("debug.sf.layer_history_trace", false);
 }
 
+bool batchRecords() {
+    return property_get_bool("debug.sf.layer_history_batch_records", false);
+}
+
 bool useFrameRatePriority() {
     char value[PROPERTY_VALUE_MAX];
     property_get("debug.sf.use_frame_rate_priority", value, "1");
@@ -101,8 +106,31 @@ LayerHistory::LayerVoteType getVoteType(FrameRateCompatibility compatibility,
 
 } // namespace
 
+struct LayerHistory::PendingRecords {
+    struct Record {
+        int32_t id;
+        LayerProps props;
+        nsecs_t presentTime;
+        nsecs_t now;
+        LayerUpdateType updateType;
+        bool modeChangePending;
+    };
+
+    // Enough for a couple of frames of 100 layers posting at 120Hz. Pushes past that allocate.
+    static constexpr size_t kCapacity = 512;
+    // record() flushes the queue itself once this many records are pending, so that the queue
+    // stays bounded if nothing reads the history, e.g. while content detection is off.
+    static constexpr size_t kFlushThreshold = kCapacity / 2;
+
+    LocklessRingQueue<Record, kCapacity> queue;
+    std::atomic<size_t> size = 0;
+};
+
 LayerHistory::LayerHistory()
-      : mTraceEnabled(traceEnabled()), mUseFrameRatePriority(useFrameRatePriority()) {
+      : mTraceEnabled(traceEnabled()),
+        mUseFrameRatePriority(useFrameRatePriority()),
+        mBatchRecords(batchRecords()),
+        mPendingRecords(std::make_unique<PendingRecords>()) {
     LayerInfo::setTraceEnabled(mTraceEnabled);
 }
 
@@ -110,6 +138,7 @@ LayerHistory::~LayerHistory() = default;
 
 void LayerHistory::registerLayer(Layer* layer, bool contentDetectionEnabled) {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
     LOG_ALWAYS_FATAL_IF(findLayer(layer->getSequence()).first != LayerStatus::NotFound,
                         "%s already registered", layer->getName().c_str());
     LayerVoteType type =
@@ -123,6 +152,7 @@ void LayerHistory::registerLayer(Layer* layer, bool contentDetectionEnabled) {
 
 void LayerHistory::deregisterLayer(Layer* layer) {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
     if (!mActiveLayerInfos.erase(layer->getSequence())) {
         if (!mInactiveLayerInfos.erase(layer->getSequence())) {
             LOG_ALWAYS_FATAL("%s: unknown layer %p", __FUNCTION__, layer);
@@ -132,7 +162,26 @@ void LayerHistory::deregisterLayer(Layer* layer) {
 
 void LayerHistory::record(int32_t id, const LayerProps& layerProps, nsecs_t presentTime,
                           nsecs_t now, LayerUpdateType updateType) {
+    if (mBatchRecords) {
+        // Count the record before publishing it so that a concurrent flush never pops more
+        // records than were counted.
+        const size_t pending = mPendingRecords->size.fetch_add(1, std::memory_order_relaxed) + 1;
+        mPendingRecords->queue.push(
+                {id, layerProps, presentTime, now, updateType, mModeChangePending});
+        if (pending >= PendingRecords::kFlushThreshold) {
+            std::lock_guard lock(mLock);
+            flushPendingRecordsLocked();
+        }
+        return;
+    }
+
     std::lock_guard lock(mLock);
+    recordLocked(id, layerProps, presentTime, now, updateType, mModeChangePending);
+}
+
+void LayerHistory::recordLocked(int32_t id, const LayerProps& layerProps, nsecs_t presentTime,
+                                nsecs_t now, LayerUpdateType updateType,
+                                bool modeChangePending) const {
     auto [found, layerPair] = findLayer(id);
     if (found == LayerStatus::NotFound) {
         // Offscreen layer
@@ -141,7 +190,7 @@ void LayerHistory::record(int32_t id, const LayerProps& layerProps, nsecs_t pres
     }
 
     const auto& info = layerPair->second;
-    info->setLastPresentTime(presentTime, now, updateType, mModeChangePending, layerProps);
+    info->setLastPresentTime(presentTime, now, updateType, modeChangePending, layerProps);
 
     // Activate layer if inactive.
     if (found == LayerStatus::LayerInInactiveMap) {
@@ -151,10 +200,26 @@ void LayerHistory::record(int32_t id, const LayerProps& layerProps, nsecs_t pres
     }
 }
 
+void LayerHistory::flushPendingRecordsLocked() const {
+    if (mPendingRecords->size.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    ATRACE_CALL();
+    size_t flushed = 0;
+    while (auto record = mPendingRecords->queue.pop()) {
+        recordLocked(record->id, record->props, record->presentTime, record->now,
+                     record->updateType, record->modeChangePending);
+        flushed++;
+    }
+    mPendingRecords->size.fetch_sub(flushed, std::memory_order_relaxed);
+}
+
 void LayerHistory::setDefaultFrameRateCompatibility(int32_t id,
                                                     FrameRateCompatibility frameRateCompatibility,
                                                     bool contentDetectionEnabled) {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
 
     auto [found, layerPair] = findLayer(id);
     if (found == LayerStatus::NotFound) {
@@ -169,6 +234,7 @@ void LayerHistory::setDefaultFrameRateCompatibility(int32_t id,
 
 void LayerHistory::setLayerProperties(int32_t id, const LayerProps& properties) {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
 
     auto [found, layerPair] = findLayer(id);
     if (found == LayerStatus::NotFound) {
@@ -194,6 +260,7 @@ auto LayerHistory::summarize(const RefreshRateSelector& selector, nsecs_t now) -
 
     std::lock_guard lock(mLock);
 
+    flushPendingRecordsLocked();
     partitionLayers(now);
 
     for (const auto& [key, value] : mActiveLayerInfos) {
@@ -348,6 +415,7 @@ void LayerHistory::partitionLayers(nsecs_t now) {
 
 void LayerHistory::clear() {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
     for (const auto& [key, value] : mActiveLayerInfos) {
         value.second->clearHistory(systemTime());
     }
@@ -355,6 +423,7 @@ void LayerHistory::clear() {
 
 std::string LayerHistory::dump() const {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
     return base::StringPrintf("{size=%zu, active=%zu}\n\tGameFrameRateOverrides=\n\t\t%s",
                               mActiveLayerInfos.size() + mInactiveLayerInfos.size(),
                               mActiveLayerInfos.size(), dumpGameFrameRateOverridesLocked().c_str());
@@ -371,6 +440,7 @@ std::string LayerHistory::dumpGameFrameRateOverridesLocked() const {
 
 float LayerHistory::getLayerFramerate(nsecs_t now, int32_t id) const {
     std::lock_guard lock(mLock);
+    flushPendingRecordsLocked();
     auto [found, layerPair] = findLayer(id);
     if (found != LayerStatus::NotFound) {
         return layerPair->second->getFps(now).getValue();
@@ -378,7 +448,7 @@ float LayerHistory::getLayerFramerate(nsecs_t now, int32_t id) const {
     return 0.f;
 }
 
-auto LayerHistory::findLayer(int32_t id) -> std::pair<LayerStatus, LayerPair*> {
+auto LayerHistory::findLayer(int32_t id) const -> std::pair<LayerStatus, LayerPair*> {
     // the layer could be in either the active or inactive map, try both
     auto it = mActiveLayerInfos.find(id);
     if (it != mActiveLayerInfos.end()) {
@@ -59,6 +59,11 @@ public:
     // Sets whether a mode change is pending to be applied
     void setModeChangePending(bool pending) { mModeChangePending = pending; }
 
+    // Sets whether record() queues updates instead of applying them under the history lock. The
+    // default comes from debug.sf.layer_history_batch_records. Client is responsible for
+    // synchronization with record().
+    void setBatchRecords(bool batch) { mBatchRecords = batch; }
+
     // Represents which layer activity is recorded
     enum class LayerUpdateType {
         Buffer,       // a new buffer queued
@@ -66,7 +71,9 @@ public:
         SetFrameRate, // setFrameRate API was called
     };
 
-    // Marks the layer as active, and records the given state to its history.
+    // Marks the layer as active, and records the given state to its history. If batched recording
+    // is enabled, the update is queued without taking the history lock and applied the next time
+    // the history is read, e.g. by summarize().
     void record(int32_t id, const LayerProps& props, nsecs_t presentTime, nsecs_t now,
                 LayerUpdateType updateType);
 
@@ -123,11 +130,15 @@ private:
 
     // looks up a layer by sequence id in both layerInfo maps.
     // The first element indicates if and where the item was found
-    std::pair<LayerStatus, LayerPair*> findLayer(int32_t id) REQUIRES(mLock);
+    std::pair<LayerStatus, LayerPair*> findLayer(int32_t id) const REQUIRES(mLock);
+
+    void recordLocked(int32_t id, const LayerProps&, nsecs_t presentTime, nsecs_t now,
+                      LayerUpdateType, bool modeChangePending) const REQUIRES(mLock);
 
-    std::pair<LayerStatus, const LayerPair*> findLayer(int32_t id) const REQUIRES(mLock) {
-        return const_cast<LayerHistory*>(this)->findLayer(id);
-    }
+    // Applies the updates queued by record() in the order they were recorded. Called before any
+    // access to the layer infos, so that the history observed under mLock is the same as if every
+    // record() had taken the lock.
+    void flushPendingRecordsLocked() const REQUIRES(mLock);
 
     mutable std::mutex mLock;
 
@@ -136,8 +147,9 @@ private:
     // 2. retrieval of all active layers (iterate that map)
     // The partitioning is allowed to become out of date but calling partitionLayers refreshes the
     // validity of each map.
-    LayerInfos mActiveLayerInfos GUARDED_BY(mLock);
-    LayerInfos mInactiveLayerInfos GUARDED_BY(mLock);
+    // Mutable so that const readers can apply the updates queued by record() first.
+    mutable LayerInfos mActiveLayerInfos GUARDED_BY(mLock);
+    mutable LayerInfos mInactiveLayerInfos GUARDED_BY(mLock);
 
     uint32_t mDisplayArea = 0;
 
@@ -150,6 +162,16 @@ private:
     // Whether a mode change is in progress or not
     std::atomic<bool> mModeChangePending = false;
 
+    // Whether record() queues updates rather than applying them under mLock. Binder threads
+    // posting buffers then only contend on the queue's tail index instead of on mLock, which
+    // summarize() holds while walking every layer. Queued updates are not dropped when this is
+    // turned off; they are applied by the next flush.
+    bool mBatchRecords;
+
+    // Updates queued by record() that have not been applied to the layer infos yet.
+    struct PendingRecords;
+    const std::unique_ptr<PendingRecords> mPendingRecords;
+
     // A list to look up the game frame rate overrides
     // Each entry includes:
     // 1. the uid of the app
@@ -67,18 +67,54 @@ void LayerInfo::setLastPresentTime(nsecs_t lastPresentTime, nsecs_t now, LayerUp
             }
             FALLTHROUGH_INTENDED;
         case LayerUpdateType::Buffer:
-            FrameTimeData frameTime = {.presentTime = lastPresentTime,
-                                       .queueTime = mLastUpdatedTime,
-                                       .pendingModeChange = pendingModeChange,
-                                       .isSmallDirty = props.isSmallDirty};
-            mFrameTimes.push_back(frameTime);
-            if (mFrameTimes.size() > HISTORY_SIZE) {
-                mFrameTimes.pop_front();
-            }
+            addFrameTime({.presentTime = lastPresentTime,
+                          .queueTime = mLastUpdatedTime,
+                          .pendingModeChange = pendingModeChange,
+                          .isSmallDirty = props.isSmallDirty});
             break;
     }
 }
 
+void LayerInfo::addFrameTime(const FrameTimeData& frameTime) {
+    if (mFrameTimes.size() == HISTORY_SIZE) {
+        // The oldest frame is about to be overwritten.
+        const FrameTimeData& oldest = mFrameTimes.front();
+        updateFrameDeltaStats(oldest, mFrameTimes[1], -1);
+        mNumPendingModeChangeFrames -= oldest.pendingModeChange;
+        mNumMissingPresentTimeFrames -= oldest.presentTime == 0;
+    }
+    if (mFrameTimes.size() > 0) {
+        updateFrameDeltaStats(mFrameTimes.back(), frameTime, 1);
+    }
+    mNumPendingModeChangeFrames += frameTime.pendingModeChange;
+    mNumMissingPresentTimeFrames += frameTime.presentTime == 0;
+    mFrameTimes.next() = frameTime;
+}
+
+void LayerInfo::clearFrameTimes() {
+    mFrameTimes.clear();
+    mPresentTimeDeltas = {};
+    mQueueTimeDeltas = {};
+    mNumPendingModeChangeFrames = 0;
+    mNumMissingPresentTimeFrames = 0;
+}
+
+void LayerInfo::updateFrameDeltaStats(const FrameTimeData& prev, const FrameTimeData& curr,
+                                      int32_t sign) {
+    const auto update = [&](FrameDeltaStats& stats, nsecs_t delta) {
+        // Mirrors the filtering in calculateAverageFrameTimeFromHistory.
+        if (delta < kMinPeriodBetweenFrames ||
+            (curr.isSmallDirty && delta < kMinPeriodBetweenSmallDirtyFrames)) {
+            stats.numCarriedDeltas += sign;
+        } else if (delta <= kMaxPeriodBetweenFrames) {
+            stats.totalDeltas += sign * delta;
+            stats.numDeltas += sign;
+        }
+    };
+    update(mPresentTimeDeltas, curr.presentTime - prev.presentTime);
+    update(mQueueTimeDeltas, curr.queueTime - prev.queueTime);
+}
+
 void LayerInfo::setProperties(const android::scheduler::LayerProps& properties) {
     *mLayerProps = properties;
 }
@@ -156,20 +192,20 @@ LayerInfo::Frequent LayerInfo::isFrequent(nsecs_t now) const {
 
 Fps LayerInfo::getFps(nsecs_t now) const {
     // Find the first active frame
-    auto it = mFrameTimes.begin();
-    for (; it != mFrameTimes.end(); ++it) {
-        if (it->queueTime >= getActiveLayerThreshold(now)) {
+    size_t first = 0;
+    for (; first < mFrameTimes.size(); first++) {
+        if (mFrameTimes[first].queueTime >= getActiveLayerThreshold(now)) {
             break;
         }
     }
 
-    const auto numFrames = std::distance(it, mFrameTimes.end());
-    if (numFrames < kFrequentLayerWindowSize) {
+    const auto numFrames = static_cast<nsecs_t>(mFrameTimes.size() - first);
+    if (numFrames < static_cast<nsecs_t>(kFrequentLayerWindowSize)) {
         return Fps();
     }
 
     // Layer is considered frequent if the average frame rate is higher than the threshold
-    const auto totalTime = mFrameTimes.back().queueTime - it->queueTime;
+    const auto totalTime = mFrameTimes.back().queueTime - mFrameTimes[first].queueTime;
     return Fps::fromPeriodNsecs(totalTime / (numFrames - 1));
 }
 
@@ -201,16 +237,11 @@ bool LayerInfo::hasEnoughDataForHeuristic() const {
 
 std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
     // Ignore frames captured during a mode change
-    const bool isDuringModeChange =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](const auto& frame) { return frame.pendingModeChange; });
-    if (isDuringModeChange) {
+    if (mNumPendingModeChangeFrames > 0) {
         return std::nullopt;
     }
 
-    const bool isMissingPresentTime =
-            std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
-                        [](auto frame) { return frame.presentTime == 0; });
+    const bool isMissingPresentTime = mNumMissingPresentTimeFrames > 0;
     if (isMissingPresentTime && !mLastRefreshRate.reported.isValid()) {
         // If there are no presentation timestamps and we haven't calculated
         // one in the past then we can't calculate the refresh rate
@@ -224,16 +255,33 @@ std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
     // when implementing render ahead for specific refresh rates. When hwui no longer provides
     // presentation timestamps we look at the queue time to see if the current refresh rate still
     // matches the content.
+    const FrameDeltaStats& stats = isMissingPresentTime ? mQueueTimeDeltas : mPresentTimeDeltas;
+    if (stats.numCarriedDeltas > 0) {
+        return calculateAverageFrameTimeFromHistory(isMissingPresentTime);
+    }
+
+    // Every delta between consecutive frames is either averaged or dropped, so the running
+    // aggregates give the same result as walking the history.
+    if (stats.numDeltas == 0) {
+        return std::nullopt;
+    }
+
+    const auto averageFrameTime =
+            static_cast<double>(stats.totalDeltas) / static_cast<double>(stats.numDeltas);
+    return static_cast<nsecs_t>(averageFrameTime);
+}
 
-    auto getFrameTime = isMissingPresentTime ? [](FrameTimeData data) { return data.queueTime; }
-                                             : [](FrameTimeData data) { return data.presentTime; };
+std::optional<nsecs_t> LayerInfo::calculateAverageFrameTimeFromHistory(bool useQueueTime) const {
+    auto getFrameTime = useQueueTime ? [](FrameTimeData data) { return data.queueTime; }
+                                     : [](FrameTimeData data) { return data.presentTime; };
 
     nsecs_t totalDeltas = 0;
     int numDeltas = 0;
     int32_t smallDirtyCount = 0;
-    auto prevFrame = mFrameTimes.begin();
-    for (auto it = mFrameTimes.begin() + 1; it != mFrameTimes.end(); ++it) {
-        const auto currDelta = getFrameTime(*it) - getFrameTime(*prevFrame);
+    size_t prevFrame = 0;
+    for (size_t i = 1; i < mFrameTimes.size(); i++) {
+        const FrameTimeData& frame = mFrameTimes[i];
+        const auto currDelta = getFrameTime(frame) - getFrameTime(mFrameTimes[prevFrame]);
         if (currDelta < kMinPeriodBetweenFrames) {
             // Skip this frame, but count the delta into the next frame
             continue;
@@ -241,12 +289,12 @@ std::optional<nsecs_t> LayerInfo::calculateAverageFrameTime() const {
 
         // If this is a small area update, we don't want to consider it for calculating the average
         // frame time. Instead, we let the bigger frame updates to drive the calculation.
-        if (it->isSmallDirty && currDelta < kMinPeriodBetweenSmallDirtyFrames) {
+        if (frame.isSmallDirty && currDelta < kMinPeriodBetweenSmallDirtyFrames) {
             smallDirtyCount++;
             continue;
         }
 
-        prevFrame = it;
+        prevFrame = i;
 
         if (currDelta > kMaxPeriodBetweenFrames) {
             // Skip this frame and the current delta.
@@ -31,6 +31,7 @@
 #include "FrameRateCompatibility.h"
 #include "LayerHistory.h"
 #include "RefreshRateSelector.h"
+#include "Utils/RingBuffer.h"
 
 namespace android {
 
@@ -228,7 +229,7 @@ public:
 
     void clearHistory(nsecs_t now) {
         onLayerInactive(now);
-        mFrameTimes.clear();
+        clearFrameTimes();
     }
 
 private:
@@ -240,6 +241,20 @@ private:
         bool isSmallDirty;
     };
 
+    // Aggregates over the deltas between consecutive frames in mFrameTimes, measured with either
+    // the present or the queue times. Kept up to date as frames are added and evicted, so that
+    // calculateAverageFrameTime does not need to walk the history in the common case.
+    struct FrameDeltaStats {
+        // Sum and count of the deltas that calculateAverageFrameTime averages, i.e. those within
+        // [kMinPeriodBetweenFrames, kMaxPeriodBetweenFrames] that are not small dirty skips.
+        nsecs_t totalDeltas = 0;
+        int32_t numDeltas = 0;
+        // Number of deltas that calculateAverageFrameTime skips while carrying them over into the
+        // next delta. If there are any, the average depends on the whole chain of frames and has
+        // to be computed from the history.
+        int32_t numCarriedDeltas = 0;
+    };
+
     // Holds information about the calculated and reported refresh rate
     struct RefreshRateHeuristicData {
         // Rate calculated on the layer
@@ -312,8 +327,15 @@ private:
     bool hasEnoughDataForHeuristic() const;
     std::optional<Fps> calculateRefreshRateIfPossible(const RefreshRateSelector&, nsecs_t now);
     std::optional<nsecs_t> calculateAverageFrameTime() const;
+    std::optional<nsecs_t> calculateAverageFrameTimeFromHistory(bool useQueueTime) const;
     bool isFrameTimeValid(const FrameTimeData&) const;
 
+    void addFrameTime(const FrameTimeData&);
+    void clearFrameTimes();
+    // Adds (sign = 1) or removes (sign = -1) the delta between two consecutive frames from the
+    // running aggregates.
+    void updateFrameDeltaStats(const FrameTimeData& prev, const FrameTimeData& curr, int32_t sign);
+
     const std::string mName;
     const uid_t mOwnerUid;
 
@@ -339,10 +361,18 @@ private:
 
     RefreshRateHeuristicData mLastRefreshRate;
 
-    std::deque<FrameTimeData> mFrameTimes;
+    static constexpr size_t HISTORY_SIZE = RefreshRateHistory::HISTORY_SIZE;
+    // Fixed capacity so that recording a frame never allocates. The oldest frame is overwritten
+    // once HISTORY_SIZE frames have been recorded.
+    utils::RingBuffer<FrameTimeData, HISTORY_SIZE> mFrameTimes;
+    FrameDeltaStats mPresentTimeDeltas;
+    FrameDeltaStats mQueueTimeDeltas;
+    // Number of frames in mFrameTimes captured during a mode change.
+    int32_t mNumPendingModeChangeFrames = 0;
+    // Number of frames in mFrameTimes without a present time.
+    int32_t mNumMissingPresentTimeFrames = 0;
     std::chrono::time_point<std::chrono::steady_clock> mFrameTimeValidSince =
             std::chrono::steady_clock::now();
-    static constexpr size_t HISTORY_SIZE = RefreshRateHistory::HISTORY_SIZE;
     static constexpr std::chrono::nanoseconds HISTORY_DURATION = LayerHistory::kMaxPeriodForHistory;
 
     std::unique_ptr<LayerProps> mLayerProps;
@@ -21,6 +21,7 @@
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wextra"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <deque>
@@ -33,6 +34,7 @@
 #include <ftl/match.h>
 #include <ftl/unit.h>
 #include <gui/TraceUtils.h>
+#include <math/HashCombine.h>
 #include <scheduler/FrameRateMode.h>
 #include <utils/Trace.h>
 
@@ -477,16 +479,44 @@ auto RefreshRateSelector::getRankedFrameRates(const std::vector<LayerRequirement
                                               GlobalSignals signals) const -> RankedFrameRates {
     std::lock_guard lock(mLock);
 
-    if (mGetRankedFrameRatesCache &&
-        mGetRankedFrameRatesCache->arguments == std::make_pair(layers, signals)) {
-        return mGetRankedFrameRatesCache->result;
+    const size_t hash = GetRankedFrameRatesCache::hashArguments(layers, signals);
+    const auto it = std::find_if(mGetRankedFrameRatesCache.begin(),
+                                 mGetRankedFrameRatesCache.end(), [&](const auto& entry) {
+                                     return entry.hash == hash &&
+                                             entry.arguments.second == signals &&
+                                             entry.arguments.first == layers;
+                                 });
+    if (it != mGetRankedFrameRatesCache.end()) {
+        mGetRankedFrameRatesCacheHits++;
+        std::rotate(mGetRankedFrameRatesCache.begin(), it, std::next(it));
+        return mGetRankedFrameRatesCache.front().result;
     }
 
-    const auto result = getRankedFrameRatesLocked(layers, signals);
-    mGetRankedFrameRatesCache = GetRankedFrameRatesCache{{layers, signals}, result};
+    mGetRankedFrameRatesCacheMisses++;
+    auto result = getRankedFrameRatesLocked(layers, signals);
+    if (mGetRankedFrameRatesCache.size() == kGetRankedFrameRatesCacheSize) {
+        mGetRankedFrameRatesCache.pop_back();
+    }
+    mGetRankedFrameRatesCache.emplace(mGetRankedFrameRatesCache.begin(),
+                                      std::make_pair(layers, signals), result);
     return result;
 }
 
+size_t RefreshRateSelector::GetRankedFrameRatesCache::hashArguments(
+        const std::vector<LayerRequirement>& layers, GlobalSignals signals) {
+    size_t hash = hashCombine(signals.touch, signals.idle, signals.powerOnImminent, layers.size());
+    for (const auto& layer : layers) {
+        // desiredRefreshRate is compared approximately, so it cannot be part of the hash.
+        hashCombineSingle(hash, layer.name);
+        hashCombineSingle(hash, layer.vote);
+        hashCombineSingle(hash, layer.seamlessness);
+        hashCombineSingle(hash, layer.frameRateCategory);
+        hashCombineSingle(hash, layer.weight);
+        hashCombineSingle(hash, layer.focused);
+    }
+    return hash;
+}
+
 auto RefreshRateSelector::getRankedFrameRatesLocked(const std::vector<LayerRequirement>& layers,
                                                     GlobalSignals signals) const
         -> RankedFrameRates {
@@ -1206,7 +1236,7 @@ void RefreshRateSelector::setActiveMode(DisplayModeId modeId, Fps renderFrameRat
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    mGetRankedFrameRatesCache.clear();
 
     const auto activeModeOpt = mDisplayModes.get(modeId);
     LOG_ALWAYS_FATAL_IF(!activeModeOpt);
@@ -1245,7 +1275,7 @@ void RefreshRateSelector::updateDisplayModes(DisplayModes modes, DisplayModeId a
 
     // Invalidate the cached invocation to getRankedFrameRates. This forces
     // the refresh rate to be recomputed on the next call to getRankedFrameRates.
-    mGetRankedFrameRatesCache.reset();
+    mGetRankedFrameRatesCache.clear();
 
     mDisplayModes = std::move(modes);
     const auto activeModeOpt = mDisplayModes.get(activeModeId);
@@ -1345,7 +1375,7 @@ auto RefreshRateSelector::setPolicy(const PolicyVariant& policy) -> SetPolicyRes
             return SetPolicyResult::Invalid;
         }
 
-        mGetRankedFrameRatesCache.reset();
+        mGetRankedFrameRatesCache.clear();
 
         if (*getCurrentPolicyLocked() == oldPolicy) {
             return SetPolicyResult::Unchanged;
@@ -1533,6 +1563,13 @@ void RefreshRateSelector::dump(utils::Dumper& dumper) const {
 
     dumper.dump("frameRateOverrideConfig"sv, *ftl::enum_name(mFrameRateOverrideConfig));
 
+    dumper.dump("getRankedFrameRatesCache"sv);
+    {
+        utils::Dumper::Indent indent(dumper);
+        dumper.dump("hits"sv, mGetRankedFrameRatesCacheHits);
+        dumper.dump("misses"sv, mGetRankedFrameRatesCacheMisses);
+    }
+
     dumper.dump("idleTimer"sv);
     {
         utils::Dumper::Indent indent(dumper);
@@ -534,10 +534,32 @@ private:
     Config::FrameRateOverride mFrameRateOverrideConfig;
 
     struct GetRankedFrameRatesCache {
-        std::pair<std::vector<LayerRequirement>, GlobalSignals> arguments;
+        using Arguments = std::pair<std::vector<LayerRequirement>, GlobalSignals>;
+
+        GetRankedFrameRatesCache(Arguments arguments, RankedFrameRates result)
+              : hash(hashArguments(arguments.first, arguments.second)),
+                arguments(std::move(arguments)),
+                result(std::move(result)) {}
+
+        // Hash of the fields compared by LayerRequirement::operator== and GlobalSignals, so that
+        // most mismatches are rejected without comparing the layer vectors.
+        static size_t hashArguments(const std::vector<LayerRequirement>&, GlobalSignals);
+
+        size_t hash;
+        Arguments arguments;
         RankedFrameRates result;
     };
-    mutable std::optional<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
+
+    // Number of distinct invocations of getRankedFrameRates that are remembered. More than one so
+    // that a summary alternating between a few states, e.g. while an animation toggles a layer's
+    // vote, keeps hitting the cache.
+    static constexpr size_t kGetRankedFrameRatesCacheSize = 4;
+
+    // Cached invocations of getRankedFrameRates, most recently used first. The cache is cleared
+    // whenever the display modes, active mode or policy change, as those affect the result too.
+    mutable std::vector<GetRankedFrameRatesCache> mGetRankedFrameRatesCache GUARDED_BY(mLock);
+    mutable uint64_t mGetRankedFrameRatesCacheHits GUARDED_BY(mLock) = 0;
+    mutable uint64_t mGetRankedFrameRatesCacheMisses GUARDED_BY(mLock) = 0;
 
     // Declare mIdleTimer last to ensure its thread joins before the mutex/callbacks are destroyed.
     std::mutex mIdleTimerCallbacksMutex;
@@ -16,6 +16,7 @@
 
 #define ATRACE_TAG ATRACE_TAG_GRAPHICS
 
+#include <algorithm>
 #include <vector>
 
 #include <android-base/stringprintf.h>
@@ -277,21 +278,35 @@ void VSyncDispatchTimerQueue::setTimer(nsecs_t targetTime, nsecs_t /*now*/) {
 }
 
 void VSyncDispatchTimerQueue::rearmTimer(nsecs_t now) {
-    rearmTimerSkippingUpdateFor(now, mCallbacks.cend());
+    rearmTimerSkippingUpdateFor(now, nullptr);
+}
+
+void VSyncDispatchTimerQueue::updateActiveCallback(
+        CallbackToken token, const std::shared_ptr<VSyncDispatchTimerQueueEntry>& callback) {
+    const auto it = std::lower_bound(mActiveCallbacks.begin(), mActiveCallbacks.end(), token,
+                                     [](const auto& active, CallbackToken value) {
+                                         return active.first.get() < value.get();
+                                     });
+    const bool listed = it != mActiveCallbacks.end() && it->first == token;
+    const bool active = callback->wakeupTime() || callback->hasPendingWorkloadUpdate();
+    if (active && !listed) {
+        mActiveCallbacks.emplace(it, token, callback);
+    } else if (!active && listed) {
+        mActiveCallbacks.erase(it);
+    }
 }
 
 void VSyncDispatchTimerQueue::rearmTimerSkippingUpdateFor(
-        nsecs_t now, CallbackMap::const_iterator skipUpdateIt) {
+        nsecs_t now, const VSyncDispatchTimerQueueEntry* skipUpdate) {
     std::optional<nsecs_t> min;
     std::optional<nsecs_t> targetVsync;
     std::optional<std::string_view> nextWakeupName;
-    for (auto it = mCallbacks.cbegin(); it != mCallbacks.cend(); ++it) {
-        auto& callback = it->second;
+    for (const auto& [_, callback] : mActiveCallbacks) {
         if (!callback->wakeupTime() && !callback->hasPendingWorkloadUpdate()) {
             continue;
         }
 
-        if (it != skipUpdateIt) {
+        if (callback.get() != skipUpdate) {
             callback->update(*mTracker, now);
         }
         auto const wakeupTime = *callback->wakeupTime();
@@ -331,8 +346,7 @@ void VSyncDispatchTimerQueue::timerCallback() {
         }
         auto const now = mTimeKeeper->now();
         mLastTimerCallback = now;
-        for (auto it = mCallbacks.begin(); it != mCallbacks.end(); it++) {
-            auto& callback = it->second;
+        for (const auto& [_, callback] : mActiveCallbacks) {
             auto const wakeupTime = callback->wakeupTime();
             if (!wakeupTime) {
                 continue;
@@ -348,6 +362,11 @@ void VSyncDispatchTimerQueue::timerCallback() {
             }
         }
 
+        std::erase_if(mActiveCallbacks, [](const auto& active) {
+            const auto& callback = active.second;
+            return !callback->wakeupTime() && !callback->hasPendingWorkloadUpdate();
+        });
+
         mIntendedWakeupTime = kInvalidTime;
         rearmTimer(mTimeKeeper->now());
     }
@@ -377,6 +396,8 @@ void VSyncDispatchTimerQueue::unregisterCallback(CallbackToken token) {
         if (it != mCallbacks.end()) {
             entry = it->second;
             mCallbacks.erase(it->first);
+            std::erase_if(mActiveCallbacks,
+                          [token](const auto& active) { return active.first == token; });
         }
     }
 
@@ -404,13 +425,16 @@ std::optional<ScheduleResult> VSyncDispatchTimerQueue::scheduleLocked(
      * timer recalculation to avoid cancelling a callback that is about to fire. */
     auto const rearmImminent = now > mIntendedWakeupTime;
     if (CC_UNLIKELY(rearmImminent)) {
-        return callback->addPendingWorkloadUpdate(*mTracker, now, scheduleTiming);
+        const auto result = callback->addPendingWorkloadUpdate(*mTracker, now, scheduleTiming);
+        updateActiveCallback(token, callback);
+        return result;
     }
 
     const auto result = callback->schedule(scheduleTiming, *mTracker, now);
+    updateActiveCallback(token, callback);
 
     if (callback->wakeupTime() < mIntendedWakeupTime - mTimerSlack) {
-        rearmTimerSkippingUpdateFor(now, it);
+        rearmTimerSkippingUpdateFor(now, callback.get());
     }
 
     return result;
@@ -444,6 +468,7 @@ CancelResult VSyncDispatchTimerQueue::cancel(CallbackToken token) {
     auto const wakeupTime = callback->wakeupTime();
     if (wakeupTime) {
         callback->disarm();
+        updateActiveCallback(token, callback);
 
         if (*wakeupTime == mIntendedWakeupTime) {
             mIntendedWakeupTime = kInvalidTime;
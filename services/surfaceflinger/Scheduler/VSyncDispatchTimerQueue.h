@@ -20,6 +20,8 @@
 #include <mutex>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 #include <android-base/thread_annotations.h>
 #include <ftl/small_map.h>
@@ -141,11 +143,18 @@ private:
     // The static capacity was chosen to exceed the expected number of callbacks.
     using CallbackMap =
             ftl::SmallMap<CallbackToken, std::shared_ptr<VSyncDispatchTimerQueueEntry>, 5>;
+    using ActiveCallbacks =
+            std::vector<std::pair<CallbackToken, std::shared_ptr<VSyncDispatchTimerQueueEntry>>>;
 
     void timerCallback();
     void setTimer(nsecs_t, nsecs_t) REQUIRES(mMutex);
     void rearmTimer(nsecs_t now) REQUIRES(mMutex);
-    void rearmTimerSkippingUpdateFor(nsecs_t now, CallbackMap::const_iterator skipUpdate)
+    void rearmTimerSkippingUpdateFor(nsecs_t now,
+                                     const VSyncDispatchTimerQueueEntry* skipUpdate)
+            REQUIRES(mMutex);
+    // Adds or removes the callback from mActiveCallbacks depending on whether it is armed or has
+    // a pending workload update.
+    void updateActiveCallback(CallbackToken, const std::shared_ptr<VSyncDispatchTimerQueueEntry>&)
             REQUIRES(mMutex);
     void cancelTimer() REQUIRES(mMutex);
     std::optional<ScheduleResult> scheduleLocked(CallbackToken, ScheduleTiming) REQUIRES(mMutex);
@@ -165,6 +174,10 @@ private:
     CallbackToken mCallbackToken GUARDED_BY(mMutex);
 
     CallbackMap mCallbacks GUARDED_BY(mMutex);
+    // The callbacks that are armed or have a pending workload update, sorted by token. Only these
+    // need to be visited when rearming the timer or dispatching, so idle registered callbacks do
+    // not add to the cost of either.
+    ActiveCallbacks mActiveCallbacks GUARDED_BY(mMutex);
     nsecs_t mIntendedWakeupTime GUARDED_BY(mMutex) = kInvalidTime;
 
     // For debugging purposes
@@ -48,12 +48,14 @@ static auto constexpr kMaxPercent = 100u;
 VSyncPredictor::~VSyncPredictor() = default;
 
 VSyncPredictor::VSyncPredictor(ftl::NonNull<DisplayModePtr> modePtr, size_t historySize,
-                               size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent)
+                               size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent,
+                               FitMode fitMode)
       : mId(modePtr->getPhysicalDisplayId()),
         mTraceOn(property_get_bool("debug.sf.vsp_trace", false)),
         kHistorySize(historySize),
         kMinimumSamplesForPrediction(minimumSamplesForPrediction),
         kOutlierTolerancePercent(std::min(outlierTolerancePercent, kMaxPercent)),
+        mFitMode(fitMode),
         mDisplayModePtr(modePtr) {
     resetModel();
 }
@@ -90,10 +92,15 @@ bool VSyncPredictor::validate(nsecs_t timestamp) const {
         return false;
     }
 
-    const auto iter = std::min_element(mTimestamps.begin(), mTimestamps.end(),
-                                       [timestamp](nsecs_t a, nsecs_t b) {
-                                           return std::abs(timestamp - a) < std::abs(timestamp - b);
-                                       });
+    // While the running sums are valid the timestamps are in increasing order, so the closest one
+    // to a newer timestamp is the last one.
+    const bool newerThanLast = mRunningSums.valid && timestamp > aValidTimestamp;
+    const auto iter = newerThanLast
+            ? mTimestamps.begin() + static_cast<ptrdiff_t>(mLastTimestampIndex)
+            : std::min_element(mTimestamps.begin(), mTimestamps.end(),
+                               [timestamp](nsecs_t a, nsecs_t b) {
+                                   return std::abs(timestamp - a) < std::abs(timestamp - b);
+                               });
     const auto distancePercent = std::abs(*iter - timestamp) * kMaxPercent / idealPeriod();
     if (distancePercent < kOutlierTolerancePercent) {
         // duplicate timestamp
@@ -151,6 +158,8 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         return false;
     }
 
+    const bool inOrder = mTimestamps.empty() || timestamp > mTimestamps[mLastTimestampIndex];
+    const bool evictedOldest = mTimestamps.size() == kHistorySize;
     if (mTimestamps.size() != kHistorySize) {
         mTimestamps.push_back(timestamp);
         mLastTimestampIndex = next(mLastTimestampIndex);
@@ -159,6 +168,10 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         mTimestamps[mLastTimestampIndex] = timestamp;
     }
 
+    if (mFitMode == FitMode::Incremental) {
+        updateRunningSums(timestamp, inOrder, evictedOldest);
+    }
+
     traceInt64If("VSP-ts", timestamp);
 
     const size_t numSamples = mTimestamps.size();
@@ -167,6 +180,33 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
         return true;
     }
 
+    auto it = mRateMap.find(idealPeriod());
+    const auto model = mRunningSums.valid ? fitModelFromRunningSums() : fitModel();
+    if (CC_UNLIKELY(!model)) {
+        it->second = {idealPeriod(), 0};
+        clearTimestamps();
+        return false;
+    }
+
+    const auto [anticipatedPeriod, intercept] = *model;
+    auto const percent = std::abs(anticipatedPeriod - idealPeriod()) * kMaxPercent / idealPeriod();
+    if (percent >= kOutlierTolerancePercent) {
+        it->second = {idealPeriod(), 0};
+        clearTimestamps();
+        return false;
+    }
+
+    traceInt64If("VSP-period", anticipatedPeriod);
+    traceInt64If("VSP-intercept", intercept);
+
+    it->second = {anticipatedPeriod, intercept};
+
+    ALOGV("model update ts %" PRIu64 ": %" PRId64 " slope: %" PRId64 " intercept: %" PRId64,
+          mId.value, timestamp, anticipatedPeriod, intercept);
+    return true;
+}
+
+std::optional<VSyncPredictor::Model> VSyncPredictor::fitModel() const {
     // This is a 'simple linear regression' calculation of Y over X, with Y being the
     // vsync timestamps, and X being the ordinal of vsync count.
     // The calculated slope is the vsync period.
@@ -182,13 +222,13 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     //
     // intercept = mean(Y) - slope * mean(X)
     //
+    const size_t numSamples = mTimestamps.size();
     std::vector<nsecs_t> vsyncTS(numSamples);
     std::vector<nsecs_t> ordinals(numSamples);
 
     // Normalizing to the oldest timestamp cuts down on error in calculating the intercept.
     const auto oldestTS = *std::min_element(mTimestamps.begin(), mTimestamps.end());
-    auto it = mRateMap.find(idealPeriod());
-    auto const currentPeriod = it->second.slope;
+    auto const currentPeriod = mRateMap.find(idealPeriod())->second.slope;
 
     // The mean of the ordinals must be precise for the intercept calculation, so scale them up for
     // fixed-point arithmetic.
@@ -225,29 +265,79 @@ bool VSyncPredictor::addVsyncTimestamp(nsecs_t timestamp) {
     }
 
     if (CC_UNLIKELY(bottom == 0)) {
-        it->second = {idealPeriod(), 0};
-        clearTimestamps();
-        return false;
+        return std::nullopt;
     }
 
     nsecs_t const anticipatedPeriod = top * kScalingFactor / bottom;
     nsecs_t const intercept = meanTS - (anticipatedPeriod * meanOrdinal / kScalingFactor);
+    return Model{anticipatedPeriod, intercept};
+}
 
-    auto const percent = std::abs(anticipatedPeriod - idealPeriod()) * kMaxPercent / idealPeriod();
-    if (percent >= kOutlierTolerancePercent) {
-        it->second = {idealPeriod(), 0};
-        clearTimestamps();
-        return false;
+// Same regression as fitModel, expanded so it only needs the sums of X, Y, X*X and X*Y:
+//
+//         n * Sigma_i(X_i * Y_i) - Sigma_i(X_i) * Sigma_i(Y_i)
+// slope = ----------------------------------------------------
+//         n * Sigma_i(X_i ^ 2) - Sigma_i(X_i) ^ 2
+//
+// intercept = (Sigma_i(Y_i) - slope * Sigma_i(X_i)) / n
+//
+// The ordinals are integers so no fixed-point scaling is needed.
+std::optional<VSyncPredictor::Model> VSyncPredictor::fitModelFromRunningSums() const {
+    const auto n = static_cast<int64_t>(mTimestamps.size());
+    const auto& sums = mRunningSums;
+    const int64_t bottom = n * sums.sumXX - sums.sumX * sums.sumX;
+    if (CC_UNLIKELY(bottom == 0)) {
+        return std::nullopt;
     }
 
-    traceInt64If("VSP-period", anticipatedPeriod);
-    traceInt64If("VSP-intercept", intercept);
+    const nsecs_t anticipatedPeriod = (n * sums.sumXY - sums.sumX * sums.sumY) / bottom;
+    const nsecs_t intercept = (sums.sumY - anticipatedPeriod * sums.sumX) / n;
+    return Model{anticipatedPeriod, intercept};
+}
 
-    it->second = {anticipatedPeriod, intercept};
+void VSyncPredictor::updateRunningSums(nsecs_t timestamp, bool inOrder, bool evictedOldest) {
+    mOrdinals.resize(mTimestamps.size());
+    auto& sums = mRunningSums;
 
-    ALOGV("model update ts %" PRIu64 ": %" PRId64 " slope: %" PRId64 " intercept: %" PRId64,
-          mId.value, timestamp, anticipatedPeriod, intercept);
-    return true;
+    if (mTimestamps.size() == 1) {
+        sums = {.valid = true, .anchorTimestamp = timestamp, .anchorOrdinal = 0};
+        mOrdinals[mLastTimestampIndex] = 0;
+        return;
+    }
+
+    if (!inOrder) {
+        // The oldest sample is no longer the first one in the ring, fall back to the batch fit
+        // until the timestamps are cleared.
+        sums.valid = false;
+    }
+    if (!sums.valid) {
+        return;
+    }
+
+    if (evictedOldest) {
+        // The evicted sample was the anchor, at (0, 0), so removing it does not change the sums.
+        // Move the anchor to the sample that is now the oldest, offsetting the sums of the other
+        // samples by (dx, dy).
+        const size_t oldest = next(mLastTimestampIndex);
+        const int64_t dx = mOrdinals[oldest] - sums.anchorOrdinal;
+        const nsecs_t dy = mTimestamps[oldest] - sums.anchorTimestamp;
+        const auto n = static_cast<int64_t>(mTimestamps.size() - 1);
+        sums.sumXX += n * dx * dx - 2 * dx * sums.sumX;
+        sums.sumXY += n * dx * dy - dx * sums.sumY - dy * sums.sumX;
+        sums.sumX -= n * dx;
+        sums.sumY -= n * dy;
+        sums.anchorTimestamp = mTimestamps[oldest];
+        sums.anchorOrdinal = mOrdinals[oldest];
+    }
+
+    const auto currentPeriod = mRateMap.find(idealPeriod())->second.slope;
+    const nsecs_t y = timestamp - sums.anchorTimestamp;
+    const int64_t x = currentPeriod == 0 ? 0 : (y + currentPeriod / 2) / currentPeriod;
+    mOrdinals[mLastTimestampIndex] = sums.anchorOrdinal + x;
+    sums.sumX += x;
+    sums.sumY += y;
+    sums.sumXX += x * x;
+    sums.sumXY += x * y;
 }
 
 auto VSyncPredictor::getVsyncSequenceLocked(nsecs_t timestamp) const -> VsyncSequence {
@@ -524,6 +614,8 @@ void VSyncPredictor::clearTimestamps() {
         mTimestamps.clear();
         mLastTimestampIndex = 0;
     }
+    mOrdinals.clear();
+    mRunningSums.valid = false;
 }
 
 bool VSyncPredictor::needsMoreSamples() const {
@@ -18,6 +18,7 @@
 
 #include <deque>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -30,6 +31,13 @@ namespace android::scheduler {
 
 class VSyncPredictor : public VSyncTracker {
 public:
+    enum class FitMode {
+        // Refits the model over every stored timestamp when a sample is added.
+        Batch,
+        // Keeps running sums of the samples so adding one costs O(1) regardless of history size.
+        Incremental,
+    };
+
     /*
      * \param [in] PhysicalDisplayid The display this corresponds to.
      * \param [in] modePtr  The initial display mode
@@ -37,9 +45,11 @@ public:
      * \param [in] minimumSamplesForPrediction The minimum number of samples to collect before
      * predicting. \param [in] outlierTolerancePercent a number 0 to 100 that will be used to filter
      * samples that fall outlierTolerancePercent from an anticipated vsync event.
+     * \param [in] fitMode How the model is refit when a timestamp is added.
      */
     VSyncPredictor(ftl::NonNull<DisplayModePtr> modePtr, size_t historySize,
-                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent);
+                   size_t minimumSamplesForPrediction, uint32_t outlierTolerancePercent,
+                   FitMode fitMode = FitMode::Batch);
     ~VSyncPredictor();
 
     bool addVsyncTimestamp(nsecs_t timestamp) final EXCLUDES(mMutex);
@@ -86,6 +96,9 @@ private:
 
     size_t next(size_t i) const REQUIRES(mMutex);
     bool validate(nsecs_t timestamp) const REQUIRES(mMutex);
+    std::optional<Model> fitModel() const REQUIRES(mMutex);
+    std::optional<Model> fitModelFromRunningSums() const REQUIRES(mMutex);
+    void updateRunningSums(nsecs_t timestamp, bool inOrder, bool evictedOldest) REQUIRES(mMutex);
     Model getVSyncPredictionModelLocked() const REQUIRES(mMutex);
     nsecs_t snapToVsync(nsecs_t timePoint) const REQUIRES(mMutex);
     nsecs_t snapToVsyncAlignedWithRenderRate(nsecs_t timePoint) const REQUIRES(mMutex);
@@ -104,6 +117,7 @@ private:
     size_t const kHistorySize;
     size_t const kMinimumSamplesForPrediction;
     size_t const kOutlierTolerancePercent;
+    FitMode const mFitMode;
     std::mutex mutable mMutex;
 
     std::optional<nsecs_t> mKnownTimestamp GUARDED_BY(mMutex);
@@ -114,6 +128,22 @@ private:
     size_t mLastTimestampIndex GUARDED_BY(mMutex) = 0;
     std::vector<nsecs_t> mTimestamps GUARDED_BY(mMutex);
 
+    // Sums for FitMode::Incremental, with X being the vsync ordinal and Y the timestamp, both
+    // relative to the oldest sample in mTimestamps. Only valid while mTimestamps is in
+    // increasing order, otherwise the model falls back to the batch fit until it is cleared.
+    struct RunningSums {
+        bool valid = false;
+        nsecs_t anchorTimestamp = 0;
+        int64_t anchorOrdinal = 0;
+        int64_t sumX = 0;
+        int64_t sumY = 0;
+        int64_t sumXX = 0;
+        int64_t sumXY = 0;
+    };
+    RunningSums mRunningSums GUARDED_BY(mMutex);
+    // Ordinal of each entry in mTimestamps, at the same index.
+    std::vector<int64_t> mOrdinals GUARDED_BY(mMutex);
+
     ftl::NonNull<DisplayModePtr> mDisplayModePtr GUARDED_BY(mMutex);
     std::optional<Fps> mRenderRateOpt GUARDED_BY(mMutex);
 
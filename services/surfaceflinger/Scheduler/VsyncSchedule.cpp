@@ -18,6 +18,7 @@
 
 #include <common/FlagManager.h>
 
+#include <cutils/properties.h>
 #include <ftl/fake_guard.h>
 #include <gui/TraceUtils.h>
 #include <scheduler/Fps.h>
@@ -119,9 +120,12 @@ VsyncSchedule::TrackerPtr VsyncSchedule::createTracker(ftl::NonNull<DisplayModeP
     constexpr size_t kHistorySize = 20;
     constexpr size_t kMinSamplesForPrediction = 6;
     constexpr uint32_t kDiscardOutlierPercent = 20;
+    const auto fitMode = property_get_bool("debug.sf.vsp_incremental_fit", false)
+            ? VSyncPredictor::FitMode::Incremental
+            : VSyncPredictor::FitMode::Batch;
 
     return std::make_unique<VSyncPredictor>(modePtr, kHistorySize, kMinSamplesForPrediction,
-                                            kDiscardOutlierPercent);
+                                            kDiscardOutlierPercent, fitMode);
 }
 
 VsyncSchedule::DispatchPtr VsyncSchedule::createDispatch(TrackerPtr tracker) {
@@ -507,6 +507,12 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
     property_get("debug.sf.predict_hwc_composition_strategy", value, "1");
     mPredictCompositionStrategy = atoi(value);
 
+    property_get("debug.sf.pipeline_hwc_validate", value, "0");
+    mPipelineHwcValidate = atoi(value);
+
+    property_get("debug.sf.parallel_composition_state", value, "0");
+    mParallelCompositionState = atoi(value);
+
     property_get("debug.sf.treat_170m_as_sRGB", value, "0");
     mTreat170mAsSrgb = atoi(value);
 
@@ -552,6 +558,14 @@ SurfaceFlinger::SurfaceFlinger(Factory& factory) : SurfaceFlinger(factory, SkipI
             base::GetBoolProperty("persist.debug.sf.enable_layer_lifecycle_manager"s, true);
     mLegacyFrontEndEnabled = !mLayerLifecycleManagerEnabled ||
             base::GetBoolProperty("persist.debug.sf.enable_legacy_frontend"s, false);
+    mUpdateDirtySnapshotSubtreesOnly =
+            base::GetBoolProperty("debug.sf.snapshot_builder_dirty_subtrees"s, false);
+    mSnapshotBuilderWorkerCount = static_cast<size_t>(
+            base::GetIntProperty("debug.sf.snapshot_builder_workers"s, 0, 0, 8));
+    mBuildPackedLayerSnapshots =
+            base::GetBoolProperty("debug.sf.packed_layer_snapshots"s, false);
+    mPrecomputeTransactionReadiness =
+            base::GetBoolProperty("debug.sf.precompute_transaction_readiness"s, false);
 
     // These are set by the HWC implementation to indicate that they will use the workarounds.
     mIsHotplugErrViaNegVsync =
@@ -840,6 +854,9 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
     ALOGI(  "SurfaceFlinger's main thread ready to run. "
             "Initializing graphics H/W...");
     addTransactionReadyFilters();
+    if (mPrecomputeTransactionReadiness) {
+        mTransactionHandler.enableReadinessPrecompute();
+    }
     Mutex::Autolock lock(mStateLock);
 
     // Get a RenderEngine for the given display / config (can't fail)
@@ -2420,7 +2437,10 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
                              getHwComposer().getSupportedLayerGenericMetadata(),
                      .genericLayerMetadataKeyMap = getGenericLayerMetadataKeyMap(),
                      .skipRoundCornersWhenProtected =
-                             !getRenderEngine().supportsProtectedContent()};
+                             !getRenderEngine().supportsProtectedContent(),
+                     .updateDirtySubtreesOnly = mUpdateDirtySnapshotSubtreesOnly,
+                     .subtreeWorkerCount = mSnapshotBuilderWorkerCount,
+                     .buildPackedSnapshots = mBuildPackedLayerSnapshots};
         mLayerSnapshotBuilder.update(args);
     }
 
@@ -2495,13 +2515,14 @@ bool SurfaceFlinger::updateLayerSnapshots(VsyncId vsyncId, nsecs_t frameTimeNs,
         }
 
         updateLayerHistory(latchTime);
-        mLayerSnapshotBuilder.forEachVisibleSnapshot([&](const frontend::LayerSnapshot& snapshot) {
-            if (mLayersIdsWithQueuedFrames.find(snapshot.path.id) ==
-                mLayersIdsWithQueuedFrames.end())
+        mLayerSnapshotBuilder.forEachVisibleBounds([&](uint32_t layerId,
+                                                       const ui::LayerFilter& outputFilter,
+                                                       const Rect& visibleBounds) {
+            if (mLayersIdsWithQueuedFrames.find(layerId) == mLayersIdsWithQueuedFrames.end())
                 return;
             Region visibleReg;
-            visibleReg.set(snapshot.transformedBoundsWithoutTransparentRegion);
-            invalidateLayerStack(snapshot.outputFilter, visibleReg);
+            visibleReg.set(visibleBounds);
+            invalidateLayerStack(outputFilter, visibleReg);
         });
 
         for (auto& destroyedLayer : mLayerLifecycleManager.getDestroyedLayers()) {
@@ -2769,6 +2790,8 @@ CompositeResultsPerDisplay SurfaceFlinger::composite(
         refreshArgs.devOptFlashDirtyRegionsDelay = std::chrono::milliseconds(mDebugFlashDelay);
     }
 
+    refreshArgs.parallelCompositionState = mParallelCompositionState;
+
     // TODO(b/255601557) Update frameInterval per display
     refreshArgs.frameInterval =
             mScheduler->getNextFrameInterval(pacesetterId, pacesetterTarget.expectedPresentTime());
@@ -4823,7 +4846,7 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
         const bool acquireFenceAvailable = s.bufferData &&
                 s.bufferData->flags.test(BufferData::BufferDataChange::fenceChanged) &&
                 s.bufferData->acquireFence;
-        const bool fenceSignaled = !acquireFenceAvailable ||
+        const bool fenceSignaled = !acquireFenceAvailable || resolvedState.acquireFenceSignaled ||
                 s.bufferData->acquireFence->getStatus() != Fence::Status::Unsignaled;
         if (!fenceSignaled) {
             // check fence status
@@ -4924,7 +4947,7 @@ TransactionHandler::TransactionReadiness SurfaceFlinger::transactionReadyBufferC
         const bool acquireFenceAvailable = s.bufferData &&
                 s.bufferData->flags.test(BufferData::BufferDataChange::fenceChanged) &&
                 s.bufferData->acquireFence;
-        const bool fenceSignaled = !acquireFenceAvailable ||
+        const bool fenceSignaled = !acquireFenceAvailable || resolvedState.acquireFenceSignaled ||
                 s.bufferData->acquireFence->getStatus() != Fence::Status::Unsignaled;
         if (!fenceSignaled) {
             // check fence status
@@ -315,6 +315,15 @@ public:
     // run parallel to the hwc validateDisplay call and re-run if the predition is incorrect.
     bool mPredictCompositionStrategy = false;
 
+    // If set, displays whose present is offloaded to another thread also run the hwc
+    // validateDisplay call there when no client composition is expected, so the main thread
+    // moves on to the next display without waiting on validate.
+    bool mPipelineHwcValidate = false;
+
+    // If set, displays that can be presented from another thread update and write the composition
+    // state of their layers on their own worker threads, concurrently with the other displays.
+    bool mParallelCompositionState = false;
+
     // If true, then any layer with a SMPTE 170M transfer function is decoded using the sRGB
     // transfer instead. This is mainly to preserve legacy behavior, where implementations treated
     // SMPTE 170M as sRGB prior to color management being implemented, and now implementations rely
@@ -1461,6 +1470,10 @@ private:
 
     bool mLayerLifecycleManagerEnabled = false;
     bool mLegacyFrontEndEnabled = true;
+    bool mUpdateDirtySnapshotSubtreesOnly = false;
+    size_t mSnapshotBuilderWorkerCount = 0;
+    bool mBuildPackedLayerSnapshots = false;
+    bool mPrecomputeTransactionReadiness = false;
 
     frontend::LayerLifecycleManager mLayerLifecycleManager;
     frontend::LayerHierarchyBuilder mLayerHierarchyBuilder;
@@ -44,6 +44,9 @@ public:
     uint32_t parentId = UNASSIGNED_LAYER_ID;
     uint32_t relativeParentId = UNASSIGNED_LAYER_ID;
     uint32_t touchCropId = UNASSIGNED_LAYER_ID;
+    // Set once the acquire fence has been seen signaled. Fences never go back to unsignaled so
+    // this can be computed ahead of the transaction readiness checks.
+    bool acquireFenceSignaled = false;
 };
 
 struct TransactionState {
@@ -100,6 +103,21 @@ struct TransactionState {
         }
     }
 
+    // Queries the acquire fences that have not been seen signaled yet and records the ones that
+    // have signaled since, so the readiness checks can skip them.
+    void pollAcquireFences() {
+        for (auto& state : states) {
+            const auto& bufferData = state.state.bufferData;
+            if (state.acquireFenceSignaled || !state.state.hasBufferChanges() || !bufferData ||
+                !bufferData->flags.test(BufferData::BufferDataChange::fenceChanged) ||
+                !bufferData->acquireFence) {
+                continue;
+            }
+            state.acquireFenceSignaled =
+                    bufferData->acquireFence->getStatus() != Fence::Status::Unsignaled;
+        }
+    }
+
     // TODO(b/185535769): Remove FrameHint. Instead, reset the idle timer (of the relevant physical
     // display) on the main thread if commit leads to composite. Then, RefreshRateOverlay should be
     // able to setFrameRate once, rather than for each transaction.
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <compositionengine/CompositionRefreshArgs.h>
+#include <compositionengine/impl/CompositionEngine.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
+#include <compositionengine/impl/OutputCompositionState.h>
+#include <compositionengine/mock/Output.h>
+#include <ftl/future.h>
+
+namespace android::compositionengine {
+namespace {
+
+using namespace std::chrono_literals;
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+// Time spent updating, planning and writing the composition state of an output's layers, and
+// the time spent in the rest of present, mostly HWC validate and present.
+constexpr std::chrono::nanoseconds kCompositionStateDuration = 300us;
+constexpr std::chrono::nanoseconds kPresentDuration = 200us;
+
+void spinFor(std::chrono::nanoseconds duration) {
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// An HWC display that can be presented from another thread. It stands in for impl::Output, with
+// its composition state steps replaced by a fixed amount of work, and offloads them to its own
+// worker like impl::Output does.
+class FakeOutput {
+public:
+    explicit FakeOutput(PhysicalDisplayId displayId) {
+        mState.isEnabled = true;
+        ON_CALL(*mOutput, getDisplayId())
+                .WillByDefault(Return(std::make_optional<DisplayId>(displayId)));
+        ON_CALL(*mOutput, getState()).WillByDefault(ReturnRef(mState));
+        ON_CALL(*mOutput, supportsOffloadPresent()).WillByDefault(Return(true));
+        ON_CALL(*mOutput, offloadCompositionStateNextFrame()).WillByDefault([this] {
+            mOffloadCompositionState = true;
+        });
+        ON_CALL(*mOutput, prepareCompositionState(_))
+                .WillByDefault([this](const CompositionRefreshArgs&)
+                                       -> ftl::Future<std::monostate> {
+                    mCompositionStatePrepared = true;
+                    if (std::exchange(mOffloadCompositionState, false)) {
+                        return ftl::Future<bool>(mWorker.send([] {
+                                   spinFor(kCompositionStateDuration);
+                                   return true;
+                               }))
+                                .then([](bool) { return std::monostate{}; });
+                    }
+                    spinFor(kCompositionStateDuration);
+                    return ftl::yield<std::monostate>({});
+                });
+        ON_CALL(*mOutput, present(_))
+                .WillByDefault([this](const CompositionRefreshArgs&)
+                                       -> ftl::Future<std::monostate> {
+                    if (!std::exchange(mCompositionStatePrepared, false)) {
+                        spinFor(kCompositionStateDuration);
+                    }
+                    spinFor(kPresentDuration);
+                    return ftl::yield<std::monostate>({});
+                });
+    }
+
+    std::shared_ptr<mock::Output> get() const { return mOutput; }
+
+private:
+    std::shared_ptr<mock::Output> mOutput = std::make_shared<NiceMock<mock::Output>>();
+    impl::OutputCompositionState mState;
+    impl::HwcAsyncWorker mWorker;
+    bool mOffloadCompositionState = false;
+    bool mCompositionStatePrepared = false;
+};
+
+// Cost of CompositionEngine::present for |outputs| displays, with the composition state of the
+// outputs prepared on the main thread (0) or on per-output workers (1).
+void present(benchmark::State& state) {
+    impl::CompositionEngine engine;
+    std::vector<std::unique_ptr<FakeOutput>> outputs;
+    CompositionRefreshArgs refreshArgs;
+    refreshArgs.parallelCompositionState = state.range(1) != 0;
+    for (uint8_t port = 0; port < state.range(0); port++) {
+        outputs.push_back(std::make_unique<FakeOutput>(PhysicalDisplayId::fromPort(port)));
+        refreshArgs.outputs.push_back(outputs.back()->get());
+    }
+
+    for (auto _ : state) {
+        engine.present(refreshArgs);
+    }
+}
+BENCHMARK(present)
+        ->ArgNames({"outputs", "parallel"})
+        ->Args({1, 0})
+        ->Args({1, 1})
+        ->Args({2, 0})
+        ->Args({2, 1})
+        ->Args({3, 0})
+        ->Args({3, 1})
+        ->Args({4, 0})
+        ->Args({4, 1})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android::compositionengine
@@ -0,0 +1,220 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gui/DisplayEventReceiver.h>
+#include <private/gui/BitTube.h>
+#include <scheduler/TimeKeeper.h>
+
+#include "FrameTimeline.h"
+#include "Scheduler/EventThread.h"
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "Scheduler/VSyncTracker.h"
+#include "Scheduler/VsyncSchedule.h"
+
+namespace android {
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr nsecs_t kPeriod = 16'666'666;
+constexpr nsecs_t kTimerSlack = 500'000;
+constexpr nsecs_t kMinVsyncDistance = 3'000'000;
+constexpr std::chrono::nanoseconds kWorkDuration = 4ms;
+constexpr std::chrono::nanoseconds kReadyDuration = 1ms;
+const PhysicalDisplayId kDisplayId = PhysicalDisplayId::fromPort(0);
+
+// Predicts a vsync on every multiple of a fixed period.
+class FixedPeriodTracker : public scheduler::VSyncTracker {
+public:
+    explicit FixedPeriodTracker(nsecs_t period) : mPeriod(period) {}
+
+    bool addVsyncTimestamp(nsecs_t) final { return true; }
+    nsecs_t nextAnticipatedVSyncTimeFrom(nsecs_t timePoint, std::optional<nsecs_t>) const final {
+        return timePoint - timePoint % mPeriod + mPeriod;
+    }
+    nsecs_t currentPeriod() const final { return mPeriod; }
+    Period minFramePeriod() const final { return Period::fromNs(mPeriod); }
+    void resetModel() final {}
+    bool needsMoreSamples() const final { return false; }
+    bool isVSyncInPhase(nsecs_t, Fps) const final { return true; }
+    void setDisplayModePtr(ftl::NonNull<DisplayModePtr>) final {}
+    void setRenderRate(Fps) final {}
+    void onFrameBegin(TimePoint, TimePoint) final {}
+    void onFrameMissed(TimePoint) final {}
+    void dump(std::string&) const final {}
+
+private:
+    const nsecs_t mPeriod;
+};
+
+// Clock that only moves when the benchmark fires the alarm the EventThread armed, so a vsync is
+// delivered as soon as the previous one has been dispatched.
+class ManualTimeKeeper : public scheduler::TimeKeeper {
+public:
+    nsecs_t now() const final {
+        std::scoped_lock lock(mMutex);
+        return mNow;
+    }
+    void alarmAt(std::function<void()> callback, nsecs_t time) final {
+        std::scoped_lock lock(mMutex);
+        mCallback = std::move(callback);
+        mAlarmTime = time;
+        mCondition.notify_all();
+    }
+    void alarmCancel() final {
+        std::scoped_lock lock(mMutex);
+        mCallback = nullptr;
+    }
+    void dump(std::string&) const final {}
+
+    // Waits for an alarm to be armed, then advances the clock to it and fires it.
+    void fireAlarm() {
+        std::function<void()> callback;
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, [this] { return mCallback != nullptr; });
+            callback = std::move(mCallback);
+            mCallback = nullptr;
+            mNow = std::max(mNow, mAlarmTime);
+        }
+        callback();
+    }
+
+private:
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    nsecs_t mNow = 0;
+    nsecs_t mAlarmTime = 0;
+    std::function<void()> mCallback;
+};
+
+class BenchmarkVsyncSchedule : public scheduler::VsyncSchedule {
+public:
+    BenchmarkVsyncSchedule(TrackerPtr tracker, DispatchPtr dispatch)
+          : VsyncSchedule(kDisplayId, std::move(tracker), std::move(dispatch), nullptr) {}
+};
+
+// Every eighth app runs at half the display rate through a frame rate override.
+class EventThreadCallback : public IEventThreadCallback {
+public:
+    bool throttleVsync(TimePoint, uid_t) override { return false; }
+    Period getVsyncPeriod(uid_t uid) override {
+        return Period::fromNs(uid % 8 == 7 ? kPeriod * 2 : kPeriod);
+    }
+    void resync() override {}
+    void onExpectedPresentTimePosted(TimePoint) override {}
+};
+
+// Posts through the connection's socket like an app connection, and counts the VSYNC events so
+// the benchmark knows when a vsync has reached every connection.
+class CountingConnection : public EventThreadConnection {
+public:
+    CountingConnection(EventThread* eventThread, uid_t uid, std::atomic<size_t>& posted)
+          : EventThreadConnection(eventThread, uid, {}), mPosted(posted) {}
+
+    status_t postEvent(const DisplayEventReceiver::Event& event) override {
+        const status_t status = EventThreadConnection::postEvent(event);
+        if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+            mPosted++;
+        }
+        return status;
+    }
+
+    // Reads back everything posted so far, as the app would, so the socket never fills up.
+    void drain() {
+        DisplayEventReceiver::Event events[8];
+        while (DisplayEventReceiver::getEvents(&mReceiveChannel, events, std::size(events)) > 0) {
+        }
+    }
+
+    gui::BitTube mReceiveChannel;
+
+private:
+    std::atomic<size_t>& mPosted;
+};
+
+// Cost of dispatching one vsync to |connections| connections that all requested periodic vsync,
+// from the alarm firing until the event has been written to every connection's socket. Arg 1
+// selects whether the frame timelines are formatted per connection (0) or shared between
+// connections at the same frame interval (1).
+void dispatchVsync(benchmark::State& state) {
+    const auto connectionCount = static_cast<size_t>(state.range(0));
+
+    auto timeKeeperPtr = std::make_unique<ManualTimeKeeper>();
+    ManualTimeKeeper& timeKeeper = *timeKeeperPtr;
+    auto tracker = std::make_shared<FixedPeriodTracker>(kPeriod);
+    auto dispatch =
+            std::make_shared<scheduler::VSyncDispatchTimerQueue>(std::move(timeKeeperPtr), tracker,
+                                                                 kTimerSlack, kMinVsyncDistance);
+    frametimeline::impl::TokenManager tokenManager;
+    EventThreadCallback callback;
+    impl::EventThread eventThread("benchmark",
+                                  std::make_shared<BenchmarkVsyncSchedule>(tracker, dispatch),
+                                  &tokenManager, callback, kWorkDuration, kReadyDuration);
+    eventThread.setShareVsyncData(state.range(1) != 0);
+    eventThread.onHotplugReceived(kDisplayId, true);
+
+    std::atomic<size_t> posted = 0;
+    std::vector<sp<CountingConnection>> connections;
+    for (size_t i = 0; i < connectionCount; i++) {
+        auto connection = sp<CountingConnection>::make(&eventThread,
+                                                       static_cast<uid_t>(10000 + i), posted);
+        connection->stealReceiveChannel(&connection->mReceiveChannel);
+        eventThread.setVsyncRate(1, connection);
+        connections.push_back(std::move(connection));
+    }
+
+    size_t expected = 0;
+    for (auto _ : state) {
+        timeKeeper.fireAlarm();
+        expected += connectionCount;
+        while (posted < expected) {
+            std::this_thread::yield();
+        }
+
+        state.PauseTiming();
+        for (const auto& connection : connections) {
+            connection->drain();
+        }
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(dispatchVsync)
+        ->ArgNames({"connections", "shared"})
+        ->Args({10, 0})
+        ->Args({10, 1})
+        ->Args({50, 0})
+        ->Args({50, 1})
+        ->Args({150, 0})
+        ->Args({150, 1})
+        ->Args({300, 0})
+        ->Args({300, 1})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "Scheduler/LayerHistory.h"
+#include "Scheduler/LayerInfo.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr int32_t kLayerCount = 100;
+constexpr nsecs_t kFramePeriod = (120_Hz).getPeriodNsecs();
+
+std::unique_ptr<LayerHistory> gLayerHistory;
+std::unique_ptr<RefreshRateSelector> gSelector;
+
+// 100 layers posting a buffer every 120Hz frame. Thread 0 plays the main thread and summarizes
+// the history once per frame, the other threads play binder threads and split the layers'
+// buffer updates between them. Arg 0 selects whether record() takes the history lock (0) or
+// queues the update for summarize() to apply (1).
+//
+// The layers are not registered, as that needs a live Layer, so the time spent under the lock
+// is mostly the lookup rather than the full history update. The benchmark still shows how the
+// binder threads and the main thread contend on the lock.
+void recordAndSummarize(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        gLayerHistory = std::make_unique<LayerHistory>();
+        gLayerHistory->setBatchRecords(state.range(0) != 0);
+        gSelector = std::make_unique<RefreshRateSelector>(
+                makeModes(mock::createDisplayMode(DisplayModeId(0), 60_Hz),
+                          mock::createDisplayMode(DisplayModeId(1), 120_Hz)),
+                DisplayModeId(1));
+    }
+
+    const LayerProps props{.visible = true, .bounds = FloatRect(0, 0, 1080, 2400)};
+    const int32_t producerCount = state.threads() > 1 ? state.threads() - 1 : 1;
+    const int32_t producerIndex = state.thread_index() > 0 ? state.thread_index() - 1 : 0;
+
+    nsecs_t time = 0;
+    for (auto _ : state) {
+        time += kFramePeriod;
+        if (state.thread_index() == 0 && state.threads() > 1) {
+            benchmark::DoNotOptimize(gLayerHistory->summarize(*gSelector, time));
+            continue;
+        }
+        for (int32_t id = producerIndex; id < kLayerCount; id += producerCount) {
+            gLayerHistory->record(id, props, time, time, LayerHistory::LayerUpdateType::Buffer);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        gLayerHistory.reset();
+        gSelector.reset();
+    }
+}
+BENCHMARK(recordAndSummarize)
+        ->ArgName("batched")
+        ->Arg(0)
+        ->Arg(1)
+        ->Threads(2)
+        ->Threads(3)
+        ->Threads(5)
+        ->UseRealTime();
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Scheduler/LayerInfo.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr size_t kHistorySize = 90;
+constexpr nsecs_t kFramePeriod = (120_Hz).getPeriodNsecs();
+constexpr nsecs_t kMinPeriodBetweenFrames = (240_Hz).getPeriodNsecs();
+constexpr nsecs_t kMaxPeriodBetweenFrames = (10_Hz).getPeriodNsecs();
+constexpr nsecs_t kMinPeriodBetweenSmallDirtyFrames = (60_Hz).getPeriodNsecs();
+
+// The frame time history as LayerInfo used to keep it: a deque that is scanned from the front
+// every time the average frame time is needed.
+class DequeFrameTimes {
+public:
+    struct FrameTimeData {
+        nsecs_t presentTime;
+        nsecs_t queueTime;
+        bool pendingModeChange;
+        bool isSmallDirty;
+    };
+
+    void add(const FrameTimeData& frameTime) {
+        mFrameTimes.push_back(frameTime);
+        if (mFrameTimes.size() > kHistorySize) {
+            mFrameTimes.pop_front();
+        }
+    }
+
+    std::optional<nsecs_t> averageFrameTime() const {
+        if (std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
+                        [](const auto& frame) { return frame.pendingModeChange; })) {
+            return std::nullopt;
+        }
+        const bool isMissingPresentTime =
+                std::any_of(mFrameTimes.begin(), mFrameTimes.end(),
+                            [](auto frame) { return frame.presentTime == 0; });
+        auto getFrameTime = isMissingPresentTime
+                ? [](FrameTimeData data) { return data.queueTime; }
+                : [](FrameTimeData data) { return data.presentTime; };
+
+        nsecs_t totalDeltas = 0;
+        int numDeltas = 0;
+        auto prevFrame = mFrameTimes.begin();
+        for (auto it = mFrameTimes.begin() + 1; it != mFrameTimes.end(); ++it) {
+            const auto currDelta = getFrameTime(*it) - getFrameTime(*prevFrame);
+            if (currDelta < kMinPeriodBetweenFrames) continue;
+            if (it->isSmallDirty && currDelta < kMinPeriodBetweenSmallDirtyFrames) continue;
+            prevFrame = it;
+            if (currDelta > kMaxPeriodBetweenFrames) continue;
+            totalDeltas += currDelta;
+            numDeltas++;
+        }
+        if (numDeltas == 0) return std::nullopt;
+        return static_cast<nsecs_t>(static_cast<double>(totalDeltas) /
+                                    static_cast<double>(numDeltas));
+    }
+
+private:
+    std::deque<FrameTimeData> mFrameTimes;
+};
+
+std::unique_ptr<RefreshRateSelector> createSelector() {
+    return std::make_unique<RefreshRateSelector>(
+            makeModes(mock::createDisplayMode(DisplayModeId(0), 60_Hz),
+                      mock::createDisplayMode(DisplayModeId(1), 120_Hz)),
+            DisplayModeId(1));
+}
+
+// Each iteration is one frame in which every layer posts a buffer and has its average frame time
+// computed, with the deque based history as a baseline.
+void dequeRecordAndAverage(benchmark::State& state) {
+    std::vector<DequeFrameTimes> layers(static_cast<size_t>(state.range(0)));
+    nsecs_t time = 0;
+    for (auto _ : state) {
+        time += kFramePeriod;
+        for (auto& layer : layers) {
+            layer.add({.presentTime = time,
+                       .queueTime = time,
+                       .pendingModeChange = false,
+                       .isSmallDirty = false});
+            benchmark::DoNotOptimize(layer.averageFrameTime());
+        }
+    }
+}
+BENCHMARK(dequeRecordAndAverage)->Arg(100)->Arg(300)->Arg(500);
+
+// Same as above using LayerInfo. Computing the vote also covers the frequency classification and
+// the refresh rate consistency checks, so this is an upper bound on the frame time history cost.
+void layerInfoRecordAndVote(benchmark::State& state) {
+    const auto selector = createSelector();
+    const LayerProps props{.visible = true};
+    std::vector<std::unique_ptr<LayerInfo>> layers;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        layers.push_back(std::make_unique<LayerInfo>("layer" + std::to_string(i), 0,
+                                                     LayerHistory::LayerVoteType::Heuristic));
+    }
+
+    // LayerInfo ignores frames from before it was created.
+    nsecs_t time = systemTime();
+    for (auto _ : state) {
+        time += kFramePeriod;
+        for (auto& layer : layers) {
+            layer->setLastPresentTime(time, time, LayerHistory::LayerUpdateType::Buffer,
+                                      /*pendingModeChange=*/false, props);
+            benchmark::DoNotOptimize(layer->getRefreshRateVote(*selector, time));
+        }
+    }
+}
+BENCHMARK(layerInfoRecordAndVote)->Arg(100)->Arg(300)->Arg(500);
+
+} // namespace
+} // namespace android::scheduler
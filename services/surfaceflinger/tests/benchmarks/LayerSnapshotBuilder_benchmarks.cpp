@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "SyntheticLayerHierarchy.h"
+
+namespace android::surfaceflinger::frontend {
+namespace {
+
+// Measures LayerSnapshotBuilder::update() on a synthetic hierarchy of state.range(0) layers
+// where state.range(1) percent of the layers change every frame.
+void updateSnapshots(benchmark::State& state, bool updateDirtySubtreesOnly, size_t workerCount) {
+    SyntheticLayerHierarchy hierarchy(static_cast<size_t>(state.range(0)));
+    LayerSnapshotBuilder builder;
+    {
+        auto args = hierarchy.getArgs(updateDirtySubtreesOnly, workerCount);
+        args.forceUpdate = LayerSnapshotBuilder::ForceUpdateFlags::ALL;
+        builder.update(args);
+        hierarchy.commitChanges();
+    }
+
+    size_t iteration = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        hierarchy.changeLayers(state.range(1), iteration++);
+        auto args = hierarchy.getArgs(updateDirtySubtreesOnly, workerCount);
+        state.ResumeTiming();
+
+        builder.update(args);
+
+        state.PauseTiming();
+        hierarchy.commitChanges();
+        state.ResumeTiming();
+    }
+    state.counters["layers"] = static_cast<double>(hierarchy.getLayerCount());
+    state.counters["changed%"] = static_cast<double>(state.range(1));
+}
+
+void snapshotBuildArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"layers", "changed%"})
+            ->ArgsProduct({{100, 400, 1000, 2000}, {1, 10, 50, 100}})
+            ->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(updateSnapshots, FullWalk, /*updateDirtySubtreesOnly=*/false,
+                  /*workerCount=*/0)
+        ->Apply(snapshotBuildArgs);
+BENCHMARK_CAPTURE(updateSnapshots, DirtySubtrees, /*updateDirtySubtreesOnly=*/true,
+                  /*workerCount=*/0)
+        ->Apply(snapshotBuildArgs);
+BENCHMARK_CAPTURE(updateSnapshots, DirtySubtrees2Workers, /*updateDirtySubtreesOnly=*/true,
+                  /*workerCount=*/2)
+        ->Apply(snapshotBuildArgs);
+BENCHMARK_CAPTURE(updateSnapshots, DirtySubtrees4Workers, /*updateDirtySubtreesOnly=*/true,
+                  /*workerCount=*/4)
+        ->Apply(snapshotBuildArgs);
+
+} // namespace android::surfaceflinger::frontend
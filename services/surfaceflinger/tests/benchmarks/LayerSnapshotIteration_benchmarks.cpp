@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "SyntheticLayerHierarchy.h"
+
+namespace android::surfaceflinger::frontend {
+namespace {
+
+void buildSnapshots(SyntheticLayerHierarchy& hierarchy, LayerSnapshotBuilder& builder,
+                    bool buildPackedSnapshots) {
+    auto args = hierarchy.getArgs();
+    args.forceUpdate = LayerSnapshotBuilder::ForceUpdateFlags::ALL;
+    args.buildPackedSnapshots = buildPackedSnapshots;
+    builder.update(args);
+    hierarchy.commitChanges();
+}
+
+// Walks the visible snapshots through LayerSnapshotBuilder::forEachVisibleSnapshot, as
+// CompositionEngine does every frame. range(1) selects the packed flags.
+void forEachVisibleSnapshot(benchmark::State& state) {
+    SyntheticLayerHierarchy hierarchy(static_cast<size_t>(state.range(0)));
+    LayerSnapshotBuilder builder;
+    buildSnapshots(hierarchy, builder, /*buildPackedSnapshots=*/state.range(1) != 0);
+
+    for (auto _ : state) {
+        float coverage = 0.f;
+        builder.forEachVisibleSnapshot([&](const LayerSnapshot& snapshot) {
+            const FloatRect& bounds = snapshot.transformedBounds;
+            coverage += bounds.getWidth() * bounds.getHeight() * snapshot.alpha;
+        });
+        benchmark::DoNotOptimize(coverage);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Walks the visible bounds through LayerSnapshotBuilder::forEachVisibleBounds, as SurfaceFlinger
+// does to invalidate the displays of layers with queued buffers. range(1) selects the packed
+// columns.
+void forEachVisibleBounds(benchmark::State& state) {
+    SyntheticLayerHierarchy hierarchy(static_cast<size_t>(state.range(0)));
+    LayerSnapshotBuilder builder;
+    buildSnapshots(hierarchy, builder, /*buildPackedSnapshots=*/state.range(1) != 0);
+
+    for (auto _ : state) {
+        int64_t area = 0;
+        builder.forEachVisibleBounds(
+                [&](uint32_t layerId, const ui::LayerFilter& outputFilter, const Rect& bounds) {
+                    if (layerId % 8 == 0 && outputFilter.layerStack == ui::DEFAULT_LAYER_STACK) {
+                        area += bounds.width() * bounds.height();
+                    }
+                });
+        benchmark::DoNotOptimize(area);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Walks the input snapshots through LayerSnapshotBuilder::forEachInputSnapshot, as the input
+// window info update does. range(1) selects the packed flags.
+void forEachInputSnapshot(benchmark::State& state) {
+    SyntheticLayerHierarchy hierarchy(static_cast<size_t>(state.range(0)));
+    LayerSnapshotBuilder builder;
+    buildSnapshots(hierarchy, builder, /*buildPackedSnapshots=*/state.range(1) != 0);
+
+    for (auto _ : state) {
+        size_t count = 0;
+        builder.forEachInputSnapshot([&](const LayerSnapshot& snapshot) {
+            count += snapshot.inputInfo.touchableRegion.isEmpty() ? 0 : 1;
+        });
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Cost of refreshing the packed copy, paid once per update when enabled.
+void updatePackedSnapshots(benchmark::State& state) {
+    SyntheticLayerHierarchy hierarchy(static_cast<size_t>(state.range(0)));
+    LayerSnapshotBuilder builder;
+    buildSnapshots(hierarchy, builder, /*buildPackedSnapshots=*/false);
+
+    PackedLayerSnapshots packed;
+    for (auto _ : state) {
+        packed.update(builder.getSnapshots(), builder.getSnapshots().size());
+        benchmark::DoNotOptimize(packed.size());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(forEachVisibleSnapshot)->ArgsProduct({{100, 500, 2000}, {0, 1}});
+BENCHMARK(forEachVisibleBounds)->ArgsProduct({{100, 500, 2000}, {0, 1}});
+BENCHMARK(forEachInputSnapshot)->ArgsProduct({{100, 500, 2000}, {0, 1}});
+BENCHMARK(updatePackedSnapshots)->Arg(100)->Arg(500)->Arg(2000);
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+
+#include <compositionengine/CompositionRefreshArgs.h>
+#include <compositionengine/LayerFE.h>
+#include <compositionengine/LayerFECompositionState.h>
+#include <compositionengine/impl/CompositionEngine.h>
+#include <compositionengine/impl/Output.h>
+#include <compositionengine/impl/OutputCompositionState.h>
+
+namespace android::compositionengine {
+namespace {
+
+const Rect kDisplayRect(0, 0, 1080, 2400);
+
+// A front-end layer with fixed geometry, so that the benchmark only measures the output's
+// visibility computation.
+class FakeLayerFE : public LayerFE {
+public:
+    FakeLayerFE(std::string name, const Rect& bounds, bool opaque, bool contentDirty,
+                float shadowLength = 0.f)
+          : mName(std::move(name)) {
+        mState.isVisible = true;
+        mState.isOpaque = opaque;
+        mState.contentDirty = contentDirty;
+        mState.outputFilter = {ui::DEFAULT_LAYER_STACK};
+        mState.geomLayerBounds = bounds.toFloatRect();
+        mState.shadowSettings.length = shadowLength;
+    }
+
+    const LayerFECompositionState* getCompositionState() const override { return &mState; }
+    bool onPreComposition(nsecs_t, bool) override { return false; }
+    std::optional<LayerSettings> prepareClientComposition(
+            ClientCompositionTargetSettings&) const override {
+        return {};
+    }
+    void onLayerDisplayed(ftl::SharedFuture<FenceResult>, ui::LayerStack) override {}
+    const char* getDebugName() const override { return mName.c_str(); }
+    int32_t getSequence() const override { return 0; }
+    bool hasRoundedCorners() const override { return false; }
+    const gui::LayerMetadata* getMetadata() const override { return nullptr; }
+    const gui::LayerMetadata* getRelativeMetadata() const override { return nullptr; }
+
+private:
+    const std::string mName;
+    LayerFECompositionState mState;
+};
+
+// The layers of a phone showing an app with a dialog, back to front, as recorded from the
+// geometry of a CompositionTest-style scene: the wallpaper and launcher, a stack of opaque
+// activities of which only the top one is visible, a video SurfaceView and a dialog with a
+// shadow in the top activity, then the system bars and the rounded corner overlays.
+Layers makeScene(int64_t activityCount) {
+    Layers layers;
+    layers.push_back(sp<FakeLayerFE>::make("Wallpaper", kDisplayRect, true, false));
+    layers.push_back(sp<FakeLayerFE>::make("Launcher", kDisplayRect, false, false));
+    for (int64_t i = 0; i < activityCount; i++) {
+        const bool top = i == activityCount - 1;
+        layers.push_back(sp<FakeLayerFE>::make("Activity#" + std::to_string(i), kDisplayRect,
+                                               true, top));
+        if (top) {
+            layers.push_back(sp<FakeLayerFE>::make("SurfaceView", Rect(0, 760, 1080, 1368), true,
+                                                   true));
+            layers.push_back(sp<FakeLayerFE>::make("Dialog", Rect(90, 900, 990, 1500), false,
+                                                   true, 24.f));
+        }
+    }
+    layers.push_back(sp<FakeLayerFE>::make("StatusBar", Rect(0, 0, 1080, 128), false, true));
+    layers.push_back(sp<FakeLayerFE>::make("NavigationBar", Rect(0, 2274, 1080, 2400), false,
+                                           false));
+    layers.push_back(sp<FakeLayerFE>::make("ScreenDecorOverlay", Rect(0, 0, 1080, 96), false,
+                                           false));
+    layers.push_back(sp<FakeLayerFE>::make("ScreenDecorOverlayBottom", Rect(0, 2304, 1080, 2400),
+                                           false, false));
+    return layers;
+}
+
+// Cost of computing the visible region of every layer of the scene on a geometry update, with
+// |activities| opaque activities stacked behind the top one. Arg 1 selects whether the coverage
+// is only tracked with Regions (0) or also summarized in CoverageTiles (1).
+void collectVisibleLayers(benchmark::State& state) {
+    impl::CompositionEngine compositionEngine;
+    const auto output = impl::createOutput(compositionEngine);
+    auto& outputState = output->editState();
+    outputState.isEnabled = true;
+    outputState.layerFilter = {ui::DEFAULT_LAYER_STACK};
+    outputState.displaySpace.setBounds(kDisplayRect.getSize());
+    outputState.layerStackSpace.setContent(kDisplayRect);
+
+    CompositionRefreshArgs refreshArgs;
+    refreshArgs.layers = makeScene(state.range(0));
+    refreshArgs.updatingOutputGeometryThisFrame = true;
+    const bool useTiles = state.range(1) != 0;
+
+    for (auto _ : state) {
+        LayerFESet latchedLayers;
+        Output::CoverageState coverage{latchedLayers};
+        if (useTiles) {
+            coverage.tiles.setBounds(kDisplayRect);
+        }
+        output->collectVisibleLayers(refreshArgs, coverage);
+        benchmark::DoNotOptimize(coverage.dirtyRegion);
+    }
+}
+BENCHMARK(collectVisibleLayers)
+        ->ArgNames({"activities", "tiles"})
+        ->Args({1, 0})
+        ->Args({1, 1})
+        ->Args({5, 0})
+        ->Args({5, 1})
+        ->Args({20, 0})
+        ->Args({20, 1});
+
+} // namespace
+} // namespace android::compositionengine
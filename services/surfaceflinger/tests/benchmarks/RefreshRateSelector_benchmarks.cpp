@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "Scheduler/RefreshRateSelector.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+namespace {
+
+using namespace std::chrono_literals;
+
+using LayerRequirement = RefreshRateSelector::LayerRequirement;
+using LayerVoteType = RefreshRateSelector::LayerVoteType;
+using GlobalSignals = RefreshRateSelector::GlobalSignals;
+
+constexpr DisplayModeId kActiveModeId{0};
+
+// 24 modes: every refresh rate at two resolutions, with each resolution in its own group.
+DisplayModes makeDisplayModes() {
+    const std::array kRefreshRates = {24_Hz, 30_Hz, 48_Hz, 50_Hz,  60_Hz,  72_Hz,
+                                      90_Hz, 96_Hz, 100_Hz, 120_Hz, 144_Hz, 165_Hz};
+    const std::array kResolutions = {ui::Size(1080, 2400), ui::Size(1440, 3200)};
+
+    DisplayModes modes;
+    int32_t id = 0;
+    for (int32_t group = 0; group < static_cast<int32_t>(kResolutions.size()); group++) {
+        for (const Fps fps : kRefreshRates) {
+            const DisplayModeId modeId{id++};
+            modes.try_emplace(modeId,
+                              mock::createDisplayMode(modeId, fps, group,
+                                                      kResolutions[static_cast<size_t>(group)]));
+        }
+    }
+    return modes;
+}
+
+// A summary as LayerHistory would produce it for a busy screen: a mix of heuristic and explicit
+// votes at various frame rates, plus layers that do not vote.
+std::vector<LayerRequirement> makeLayerRequirements(size_t layerCount) {
+    constexpr std::array kVotes = {LayerVoteType::Heuristic, LayerVoteType::ExplicitDefault,
+                                   LayerVoteType::ExplicitExactOrMultiple, LayerVoteType::NoVote};
+    const std::array kFrameRates = {24_Hz, 30_Hz, 60_Hz, 90_Hz, 120_Hz};
+
+    std::vector<LayerRequirement> layers;
+    layers.reserve(layerCount);
+    for (size_t i = 0; i < layerCount; i++) {
+        layers.push_back({.name = "com.example.app/Surface#" + std::to_string(i),
+                          .ownerUid = static_cast<uid_t>(10000 + i % 8),
+                          .vote = kVotes[i % kVotes.size()],
+                          .desiredRefreshRate = kFrameRates[i % kFrameRates.size()],
+                          .weight = i % 3 == 0 ? 1.f : 0.5f,
+                          .focused = i == 0});
+    }
+    return layers;
+}
+
+RefreshRateSelector makeSelector() {
+    return RefreshRateSelector(makeDisplayModes(), kActiveModeId,
+                               {.enableFrameRateOverride =
+                                        RefreshRateSelector::Config::FrameRateOverride::Enabled,
+                                .frameRateMultipleThreshold = 0,
+                                .idleTimerTimeout = 0ms,
+                                .kernelIdleTimerController = {}});
+}
+
+// Every summary is different from the ones before it, so every call scores all modes.
+void getRankedFrameRates_changingSummary(benchmark::State& state) {
+    RefreshRateSelector selector = makeSelector();
+    auto layers = makeLayerRequirements(static_cast<size_t>(state.range(0)));
+    float weight = 0.5f;
+    for (auto _ : state) {
+        weight = weight < 0.9f ? weight + 0.001f : 0.5f;
+        layers.back().weight = weight;
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(layers, {}));
+    }
+}
+BENCHMARK(getRankedFrameRates_changingSummary)->Arg(50)->Arg(100)->Arg(200);
+
+// The summary is the same every frame, which is the common case while content is steady.
+void getRankedFrameRates_steadySummary(benchmark::State& state) {
+    RefreshRateSelector selector = makeSelector();
+    const auto layers = makeLayerRequirements(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(layers, {}));
+    }
+}
+BENCHMARK(getRankedFrameRates_steadySummary)->Arg(50)->Arg(100)->Arg(200);
+
+// The summary toggles between a few states, e.g. a layer that alternates between voting and
+// not voting, and touch coming and going.
+void getRankedFrameRates_alternatingSummary(benchmark::State& state) {
+    RefreshRateSelector selector = makeSelector();
+    auto idleLayers = makeLayerRequirements(static_cast<size_t>(state.range(0)));
+    auto activeLayers = idleLayers;
+    activeLayers.front().vote = LayerVoteType::Max;
+
+    const std::array<std::pair<const std::vector<LayerRequirement>*, GlobalSignals>, 3> summaries =
+            {{{&idleLayers, {}}, {&activeLayers, {}}, {&activeLayers, {.touch = true}}}};
+    size_t frame = 0;
+    for (auto _ : state) {
+        const auto& [layers, signals] = summaries[frame++ % summaries.size()];
+        benchmark::DoNotOptimize(selector.getRankedFrameRates(*layers, signals));
+    }
+}
+BENCHMARK(getRankedFrameRates_alternatingSummary)->Arg(50)->Arg(100)->Arg(200);
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <ui/ShadowSettings.h>
+
+#include "Client.h" // temporarily needed for LayerCreationArgs
+#include "FrontEnd/LayerCreationArgs.h"
+#include "FrontEnd/LayerHierarchy.h"
+#include "FrontEnd/LayerLifecycleManager.h"
+#include "FrontEnd/LayerSnapshotBuilder.h"
+
+namespace android::surfaceflinger::frontend {
+
+// Builds a hierarchy that resembles a busy device: one root per display, each holding a number
+// of app containers with a handful of window layers each.
+//
+// ROOT
+// ├── display root 1
+// │   ├── app container
+// │   │   ├── window
+// │   │   └── ...
+// │   └── ...
+// └── display root 2
+//     └── ...
+class SyntheticLayerHierarchy {
+public:
+    static constexpr uint32_t kLayersPerApp = 5;
+
+    SyntheticLayerHierarchy(size_t layerCount, size_t displayCount = 2) {
+        uint32_t nextId = 1;
+        for (size_t display = 0; display < displayCount; display++) {
+            const uint32_t displayRootId = nextId++;
+            addLayer(displayRootId, UNASSIGNED_LAYER_ID);
+            setLayerStack(displayRootId, static_cast<uint32_t>(display));
+            mDisplayRootIds.push_back(displayRootId);
+
+            frontend::DisplayInfo info{.receivesInput = true,
+                                       .isSecure = true,
+                                       .isPrimary = display == 0,
+                                       .isVirtual = false,
+                                       .rotationFlags = ui::Transform::ROT_0,
+                                       .transformHint = ui::Transform::ROT_0};
+            info.info.logicalWidth = 1080;
+            info.info.logicalHeight = 2400;
+            mDisplays.emplace_or_replace(ui::LayerStack::fromValue(static_cast<uint32_t>(display)),
+                                         info);
+        }
+
+        size_t display = 0;
+        while (nextId <= layerCount) {
+            const uint32_t appId = nextId++;
+            addLayer(appId, mDisplayRootIds[display++ % mDisplayRootIds.size()]);
+            mChangeableIds.push_back(appId);
+            for (uint32_t i = 1; i < kLayersPerApp && nextId <= layerCount; i++) {
+                const uint32_t windowId = nextId++;
+                addLayer(windowId, appId);
+                setColor(windowId);
+                mChangeableIds.push_back(windowId);
+            }
+        }
+        mHierarchyBuilder.update(mLifecycleManager);
+    }
+
+    size_t getLayerCount() const { return mChangeableIds.size() + mDisplayRootIds.size(); }
+
+    // Changes the alpha of |percent| of the non root layers, starting at a different layer for
+    // every |iteration| so consecutive frames touch different subtrees.
+    void changeLayers(int64_t percent, size_t iteration) {
+        const size_t count =
+                std::max<size_t>(1, mChangeableIds.size() * static_cast<size_t>(percent) / 100);
+        std::vector<TransactionState> transactions;
+        transactions.emplace_back();
+        for (size_t i = 0; i < count; i++) {
+            const size_t index = (iteration * count + i) % mChangeableIds.size();
+            transactions.back().states.push_back({});
+            auto& state = transactions.back().states.back();
+            state.layerId = mChangeableIds[index];
+            state.state.what = layer_state_t::eAlphaChanged;
+            state.state.color.a = (iteration % 2) ? 0.5_hf : 1._hf;
+        }
+        mLifecycleManager.applyTransactions(transactions);
+    }
+
+    LayerSnapshotBuilder::Args getArgs(bool updateDirtySubtreesOnly = false,
+                                       size_t subtreeWorkerCount = 0) {
+        return {.root = mHierarchyBuilder.getHierarchy(),
+                .layerLifecycleManager = mLifecycleManager,
+                .includeMetadata = false,
+                .displays = mDisplays,
+                .globalShadowSettings = mGlobalShadowSettings,
+                .supportsBlur = true,
+                .supportedLayerGenericMetadata = {},
+                .genericLayerMetadataKeyMap = {},
+                .updateDirtySubtreesOnly = updateDirtySubtreesOnly,
+                .subtreeWorkerCount = subtreeWorkerCount};
+    }
+
+    void commitChanges() { mLifecycleManager.commitChanges(); }
+
+private:
+    void addLayer(uint32_t id, uint32_t parentId) {
+        LayerCreationArgs args(std::make_optional(id));
+        args.name = "synthetic";
+        args.addToRoot = parentId == UNASSIGNED_LAYER_ID;
+        args.parentId = parentId;
+        std::vector<std::unique_ptr<RequestedLayerState>> layers;
+        layers.emplace_back(std::make_unique<RequestedLayerState>(args));
+        mLifecycleManager.addLayers(std::move(layers));
+    }
+
+    void setColor(uint32_t id) {
+        std::vector<TransactionState> transactions;
+        transactions.emplace_back();
+        transactions.back().states.push_back({});
+        transactions.back().states.front().state.what = layer_state_t::eColorChanged;
+        transactions.back().states.front().state.color.rgb = half3(1._hf, 1._hf, 1._hf);
+        transactions.back().states.front().layerId = id;
+        mLifecycleManager.applyTransactions(transactions);
+    }
+
+    void setLayerStack(uint32_t id, uint32_t layerStack) {
+        std::vector<TransactionState> transactions;
+        transactions.emplace_back();
+        transactions.back().states.push_back({});
+        transactions.back().states.front().state.what = layer_state_t::eLayerStackChanged;
+        transactions.back().states.front().layerId = id;
+        transactions.back().states.front().state.layerStack = ui::LayerStack::fromValue(layerStack);
+        mLifecycleManager.applyTransactions(transactions);
+    }
+
+    LayerLifecycleManager mLifecycleManager;
+    LayerHierarchyBuilder mHierarchyBuilder;
+    DisplayInfos mDisplays;
+    ShadowSettings mGlobalShadowSettings;
+    std::vector<uint32_t> mDisplayRootIds;
+    std::vector<uint32_t> mChangeableIds;
+};
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+#include <vector>
+
+#include "LocklessQueue.h"
+#include "LocklessRingQueue.h"
+#include "TransactionState.h"
+
+namespace android {
+namespace {
+
+constexpr int kTransactionsPerProducer = 2000;
+
+// N binder threads queue transactions while the main thread drains them, the same shape as
+// TransactionHandler::queueTransaction and collectTransactions.
+template <typename Queue>
+void transactionQueueContention(benchmark::State& state) {
+    const int producerCount = static_cast<int>(state.range(0));
+    const int total = producerCount * kTransactionsPerProducer;
+    Queue queue;
+
+    for (auto _ : state) {
+        std::vector<std::thread> producers;
+        producers.reserve(static_cast<size_t>(producerCount));
+        for (int i = 0; i < producerCount; i++) {
+            producers.emplace_back([&queue]() {
+                for (int j = 0; j < kTransactionsPerProducer; j++) {
+                    TransactionState transaction;
+                    transaction.id = static_cast<uint64_t>(j);
+                    queue.push(std::move(transaction));
+                }
+            });
+        }
+
+        int popped = 0;
+        while (popped < total) {
+            auto transaction = queue.pop();
+            if (transaction) {
+                benchmark::DoNotOptimize(transaction->id);
+                popped++;
+            }
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * total);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(transactionQueueContention, LocklessQueue<TransactionState>)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4)
+        ->Arg(8)
+        ->UseRealTime();
+BENCHMARK_TEMPLATE(transactionQueueContention, LocklessRingQueue<TransactionState, 256>)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4)
+        ->Arg(8)
+        ->UseRealTime();
+
+} // namespace android
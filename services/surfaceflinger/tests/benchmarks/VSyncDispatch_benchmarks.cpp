@@ -0,0 +1,199 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <scheduler/Timer.h>
+
+#include "Scheduler/VSyncDispatchTimerQueue.h"
+#include "Scheduler/VSyncTracker.h"
+
+namespace android::scheduler {
+namespace {
+
+constexpr nsecs_t kTimerSlack = 500'000;
+constexpr nsecs_t kMinVsyncDistance = 3'000'000;
+
+// Predicts a vsync on every multiple of a fixed period.
+class FixedPeriodTracker : public VSyncTracker {
+public:
+    explicit FixedPeriodTracker(nsecs_t period) : mPeriod(period) {}
+
+    bool addVsyncTimestamp(nsecs_t) final { return true; }
+    nsecs_t nextAnticipatedVSyncTimeFrom(nsecs_t timePoint, std::optional<nsecs_t>) const final {
+        return timePoint - timePoint % mPeriod + mPeriod;
+    }
+    nsecs_t currentPeriod() const final { return mPeriod; }
+    Period minFramePeriod() const final { return Period::fromNs(mPeriod); }
+    void resetModel() final {}
+    bool needsMoreSamples() const final { return false; }
+    bool isVSyncInPhase(nsecs_t, Fps) const final { return true; }
+    void setDisplayModePtr(ftl::NonNull<DisplayModePtr>) final {}
+    void setRenderRate(Fps) final {}
+    void onFrameBegin(TimePoint, TimePoint) final {}
+    void onFrameMissed(TimePoint) final {}
+    void dump(std::string&) const final {}
+
+private:
+    const nsecs_t mPeriod;
+};
+
+// Clock that only moves when an alarm is fired, so the benchmark measures the dispatch
+// bookkeeping rather than time spent sleeping.
+class ManualTimeKeeper : public TimeKeeper {
+public:
+    nsecs_t now() const final { return mNow; }
+    void alarmAt(std::function<void()> callback, nsecs_t time) final {
+        mCallback = std::move(callback);
+        mAlarmTime = time;
+    }
+    void alarmCancel() final { mCallback = nullptr; }
+    void dump(std::string&) const final {}
+
+    void setNow(nsecs_t now) { mNow = std::max(mNow, now); }
+
+    // Advances the clock to the pending alarm and fires it. Returns false if no alarm is armed.
+    bool fireAlarm() {
+        if (!mCallback) return false;
+        auto callback = std::move(mCallback);
+        mCallback = nullptr;
+        setNow(mAlarmTime);
+        callback();
+        return true;
+    }
+
+private:
+    nsecs_t mNow = 0;
+    nsecs_t mAlarmTime = 0;
+    std::function<void()> mCallback;
+};
+
+// Simulates a stream of frames where |armed| of |registered| callbacks are scheduled for every
+// vsync, each with a different work duration so a frame needs several timer wakeups. Measures the
+// cost of scheduling and dispatching a frame, and reports how far from their target wakeup time
+// callbacks are dispatched because of timer slack grouping.
+void scheduleAndDispatch(benchmark::State& state) {
+    constexpr nsecs_t kPeriod = 16'666'666;
+    const auto registered = static_cast<size_t>(state.range(0));
+    const auto armed = static_cast<size_t>(state.range(1));
+
+    auto timeKeeperPtr = std::make_unique<ManualTimeKeeper>();
+    ManualTimeKeeper& timeKeeper = *timeKeeperPtr;
+    VSyncDispatchTimerQueue dispatch(std::move(timeKeeperPtr),
+                                     std::make_shared<FixedPeriodTracker>(kPeriod), kTimerSlack,
+                                     kMinVsyncDistance);
+
+    nsecs_t totalJitter = 0;
+    size_t dispatched = 0;
+    std::vector<VSyncDispatch::CallbackToken> tokens;
+    for (size_t i = 0; i < registered; i++) {
+        tokens.push_back(dispatch.registerCallback(
+                [&](nsecs_t, nsecs_t wakeupTime, nsecs_t) {
+                    totalJitter += std::abs(timeKeeper.now() - wakeupTime);
+                    dispatched++;
+                },
+                "callback" + std::to_string(i)));
+    }
+
+    nsecs_t frameStart = 0;
+    for (auto _ : state) {
+        timeKeeper.setNow(frameStart);
+        for (size_t i = 0; i < armed; i++) {
+            // Spread the wakeups over the first part of the frame.
+            const nsecs_t workDuration = kPeriod / 4 + static_cast<nsecs_t>(i) * 50'000;
+            dispatch.schedule(tokens[i],
+                              {.workDuration = workDuration,
+                               .readyDuration = 0,
+                               .lastVsync = frameStart});
+        }
+        while (timeKeeper.fireAlarm()) {
+        }
+        frameStart += kPeriod;
+    }
+
+    for (auto token : tokens) {
+        dispatch.unregisterCallback(token);
+    }
+    state.counters["wakeupJitterNs"] =
+            dispatched ? static_cast<double>(totalJitter) / static_cast<double>(dispatched) : 0;
+}
+BENCHMARK(scheduleAndDispatch)
+        ->Args({2, 2})
+        ->Args({10, 2})
+        ->Args({50, 2})
+        ->Args({200, 2})
+        ->Args({10, 10})
+        ->Args({50, 50})
+        ->Args({200, 200});
+
+// Same shape as above, but on the real timer, reporting how late the armed callback is woken up
+// relative to its target wakeup time while |registered| callbacks are registered.
+void timerWakeupJitter(benchmark::State& state) {
+    constexpr nsecs_t kPeriod = 4'000'000;
+    const auto registered = static_cast<size_t>(state.range(0));
+
+    VSyncDispatchTimerQueue dispatch(std::make_unique<Timer>(),
+                                     std::make_shared<FixedPeriodTracker>(kPeriod), kTimerSlack,
+                                     kMinVsyncDistance);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool woken = false;
+    nsecs_t totalLatency = 0;
+    std::vector<VSyncDispatch::CallbackToken> tokens;
+    for (size_t i = 0; i < registered; i++) {
+        tokens.push_back(dispatch.registerCallback(
+                [&](nsecs_t, nsecs_t wakeupTime, nsecs_t) {
+                    const nsecs_t latency = systemTime(SYSTEM_TIME_MONOTONIC) - wakeupTime;
+                    std::scoped_lock lock(mutex);
+                    totalLatency += latency;
+                    woken = true;
+                    cv.notify_one();
+                },
+                "callback" + std::to_string(i)));
+    }
+
+    for (auto _ : state) {
+        {
+            std::scoped_lock lock(mutex);
+            woken = false;
+        }
+        dispatch.schedule(tokens.back(),
+                          {.workDuration = kPeriod / 2,
+                           .readyDuration = 0,
+                           .lastVsync = systemTime(SYSTEM_TIME_MONOTONIC)});
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [&] { return woken; });
+    }
+
+    for (auto token : tokens) {
+        dispatch.unregisterCallback(token);
+    }
+    state.counters["wakeupLatencyNs"] =
+            benchmark::Counter(static_cast<double>(totalLatency), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(timerWakeupJitter)->Arg(2)->Arg(10)->Arg(50)->Arg(200)->Iterations(100)->UseRealTime();
+
+} // namespace
+} // namespace android::scheduler
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "Scheduler/VSyncPredictor.h"
+#include "mock/DisplayHardware/MockDisplayMode.h"
+
+namespace android::scheduler {
+namespace {
+
+using FitMode = VSyncPredictor::FitMode;
+
+constexpr PhysicalDisplayId kDisplayId = PhysicalDisplayId::fromPort(42u);
+constexpr size_t kMinimumSamplesForPrediction = 6;
+constexpr uint32_t kOutlierTolerancePercent = 20;
+
+struct VsyncTrace {
+    nsecs_t idealPeriod;
+    std::vector<nsecs_t> timestamps;
+};
+
+// HW vsync timestamps recorded on a 60Hz device (b/190331974), including a few timestamps that
+// are much closer together than a vsync period.
+VsyncTrace recorded60HzTrace() {
+    return {16'666'666,
+            {198353408177, 198370074844, 198371400000, 198374274000, 198390941000, 198407565000,
+             198540887994, 198607538588, 198624218276, 198657655939, 198674224176, 198690880955,
+             198724204319, 198740988133, 198758166681, 198790869196, 198824205052, 198840871678,
+             198857715631, 198890885797, 198924199640, 198940873834, 198974204401}};
+}
+
+// A long 120Hz trace with +/- 150us of jitter, periodic gaps where HW vsync was not sampled and
+// the occasional timestamp half way between two vsyncs.
+VsyncTrace synthetic120HzTrace() {
+    constexpr nsecs_t kPeriod = 8'333'333;
+    constexpr size_t kSampleCount = 2000;
+    VsyncTrace trace{kPeriod, {}};
+    uint32_t seed = 1;
+    for (size_t i = 0; i < kSampleCount; i++) {
+        if (i % 97 == 0) continue;
+        seed = seed * 1103515245 + 12345;
+        const nsecs_t jitter = static_cast<nsecs_t>((seed >> 16) % 300'001) - 150'000;
+        nsecs_t timestamp = static_cast<nsecs_t>(i) * kPeriod + jitter;
+        if (i % 211 == 0) timestamp += kPeriod / 2;
+        trace.timestamps.push_back(timestamp);
+    }
+    return trace;
+}
+
+ftl::NonNull<DisplayModePtr> displayMode(nsecs_t period) {
+    return ftl::as_non_null(mock::createDisplayMode(DisplayModeId(0),
+                                                    Fps::fromPeriodNsecs(period), /*group=*/0,
+                                                    ui::Size(1920, 1080), kDisplayId));
+}
+
+// Mean distance between each timestamp and the vsync predicted from the samples before it.
+double meanPredictionErrorNs(const VsyncTrace& trace, size_t historySize, FitMode fitMode) {
+    VSyncPredictor predictor{displayMode(trace.idealPeriod), historySize,
+                             kMinimumSamplesForPrediction, kOutlierTolerancePercent, fitMode};
+    double totalError = 0;
+    size_t predictions = 0;
+    for (size_t i = 0; i < trace.timestamps.size(); i++) {
+        const nsecs_t timestamp = trace.timestamps[i];
+        if (i > 0 && !predictor.needsMoreSamples()) {
+            const nsecs_t prediction =
+                    predictor.nextAnticipatedVSyncTimeFrom(timestamp - trace.idealPeriod / 2);
+            totalError += static_cast<double>(std::abs(prediction - timestamp));
+            predictions++;
+        }
+        predictor.addVsyncTimestamp(timestamp);
+    }
+    return predictions ? totalError / static_cast<double>(predictions) : 0;
+}
+
+void replayTrace(benchmark::State& state, const VsyncTrace& trace, FitMode fitMode) {
+    const auto historySize = static_cast<size_t>(state.range(0));
+    state.counters["meanErrorNs"] = meanPredictionErrorNs(trace, historySize, fitMode);
+
+    VSyncPredictor predictor{displayMode(trace.idealPeriod), historySize,
+                             kMinimumSamplesForPrediction, kOutlierTolerancePercent, fitMode};
+    for (auto _ : state) {
+        predictor.resetModel();
+        for (const nsecs_t timestamp : trace.timestamps) {
+            benchmark::DoNotOptimize(predictor.addVsyncTimestamp(timestamp));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(trace.timestamps.size()));
+}
+
+void replayRecorded60Hz(benchmark::State& state, FitMode fitMode) {
+    replayTrace(state, recorded60HzTrace(), fitMode);
+}
+
+void replaySynthetic120Hz(benchmark::State& state, FitMode fitMode) {
+    replayTrace(state, synthetic120HzTrace(), fitMode);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(replayRecorded60Hz, Batch, FitMode::Batch)->Arg(20);
+BENCHMARK_CAPTURE(replayRecorded60Hz, Incremental, FitMode::Incremental)->Arg(20);
+BENCHMARK_CAPTURE(replaySynthetic120Hz, Batch, FitMode::Batch)->Arg(20)->Arg(100);
+BENCHMARK_CAPTURE(replaySynthetic120Hz, Incremental, FitMode::Incremental)->Arg(20)->Arg(100);
+
+} // namespace android::scheduler
@@ -149,6 +149,7 @@ protected:
 
     static constexpr uid_t mConnectionUid = 443;
     static constexpr uid_t mThrottledConnectionUid = 177;
+    static constexpr uid_t mHalfRateConnectionUid = 555;
 };
 
 EventThreadTest::EventThreadTest() {
@@ -187,8 +188,8 @@ bool EventThreadTest::throttleVsync(android::TimePoint expectedVsyncTimestamp, u
     return (uid == mThrottledConnectionUid);
 }
 
-Period EventThreadTest::getVsyncPeriod(uid_t) {
-    return mVsyncPeriod;
+Period EventThreadTest::getVsyncPeriod(uid_t uid) {
+    return uid == mHalfRateConnectionUid ? mVsyncPeriod * 2 : mVsyncPeriod;
 }
 
 void EventThreadTest::resync() {
@@ -868,6 +869,66 @@ TEST_F(EventThreadTest, postHcpLevelsChanged) {
     EXPECT_EQ(HDCP_V2, event.hdcpLevelsChange.maxLevel);
 }
 
+TEST_F(EventThreadTest, sharedVsyncDataIsFormattedOncePerFrameInterval) {
+    setupEventThread();
+    mThread->setShareVsyncData(true);
+
+    ConnectionEventRecorder otherConnectionEventRecorder{0};
+    const auto otherConnection = createConnection(otherConnectionEventRecorder, {}, 444);
+    ConnectionEventRecorder halfRateConnectionEventRecorder{0};
+    const auto halfRateConnection =
+            createConnection(halfRateConnectionEventRecorder, {}, mHalfRateConnectionUid);
+
+    mThread->requestNextVsync(mConnection);
+    mThread->requestNextVsync(otherConnection);
+    mThread->requestNextVsync(halfRateConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    onVSyncEvent(123, 456, 789);
+    const auto args = mConnectionEventCallRecorder.waitForCall();
+    const auto otherArgs = otherConnectionEventRecorder.waitForCall();
+    const auto halfRateArgs = halfRateConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    ASSERT_TRUE(otherArgs.has_value());
+    ASSERT_TRUE(halfRateArgs.has_value());
+    const auto& vsyncData = std::get<0>(args.value()).vsync.vsyncData;
+    const auto& otherVsyncData = std::get<0>(otherArgs.value()).vsync.vsyncData;
+    const auto& halfRateVsyncData = std::get<0>(halfRateArgs.value()).vsync.vsyncData;
+
+    // Connections at the same frame interval get the same frame timelines, vsync ids included.
+    ASSERT_EQ(vsyncData.frameTimelinesLength, otherVsyncData.frameTimelinesLength);
+    EXPECT_EQ(vsyncData.preferredFrameTimelineIndex, otherVsyncData.preferredFrameTimelineIndex);
+    for (size_t i = 0; i < vsyncData.frameTimelinesLength; i++) {
+        EXPECT_EQ(vsyncData.frameTimelines[i].vsyncId, otherVsyncData.frameTimelines[i].vsyncId);
+    }
+
+    // A connection at another frame interval gets its own frame timelines.
+    EXPECT_EQ(mVsyncPeriod.count() * 2, halfRateVsyncData.frameInterval);
+    EXPECT_NE(vsyncData.preferredVsyncId(), halfRateVsyncData.preferredVsyncId());
+    EXPECT_EQ(vsyncData.preferredExpectedPresentationTime(),
+              halfRateVsyncData.preferredExpectedPresentationTime());
+}
+
+TEST_F(EventThreadTest, vsyncDataIsPerConnectionWhenNotShared) {
+    setupEventThread();
+    mThread->setShareVsyncData(false);
+
+    ConnectionEventRecorder otherConnectionEventRecorder{0};
+    const auto otherConnection = createConnection(otherConnectionEventRecorder, {}, 444);
+
+    mThread->requestNextVsync(mConnection);
+    mThread->requestNextVsync(otherConnection);
+    expectVSyncCallbackScheduleReceived(true);
+
+    onVSyncEvent(123, 456, 789);
+    const auto args = mConnectionEventCallRecorder.waitForCall();
+    const auto otherArgs = otherConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    ASSERT_TRUE(otherArgs.has_value());
+    EXPECT_NE(std::get<0>(args.value()).vsync.vsyncData.preferredVsyncId(),
+              std::get<0>(otherArgs.value()).vsync.vsyncData.preferredVsyncId());
+}
+
 } // namespace
 } // namespace android
 
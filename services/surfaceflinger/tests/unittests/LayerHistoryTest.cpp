@@ -27,6 +27,8 @@
 #include <gtest/gtest.h>
 #include <log/log.h>
 
+#include <thread>
+
 #include <common/test/FlagUtils.h>
 #include "FpsOps.h"
 #include "Scheduler/LayerHistory.h"
@@ -1299,6 +1301,64 @@ TEST_F(LayerHistoryTest, heuristicLayerNotOscillating_useKnownRefreshRate) {
     recordFramesAndExpect(layer, time, 27.1_Hz, 30_Hz, PRESENT_TIME_HISTORY_SIZE);
 }
 
+TEST_F(LayerHistoryTest, batchedRecordsAreAppliedOnSummarize) {
+    history().setBatchRecords(true);
+
+    const auto layer = createLayer();
+    EXPECT_CALL(*layer, isVisible()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*layer, getFrameRateForLayerTree()).WillRepeatedly(Return(Layer::FrameRate()));
+
+    nsecs_t time = systemTime();
+    history().record(layer->getSequence(), layer->getLayerProps(), time, time,
+                     LayerHistory::LayerUpdateType::Buffer);
+
+    // The record is queued until the history is read.
+    EXPECT_EQ(0, activeLayerCount());
+    ASSERT_EQ(1, summarizeLayerHistory(time).size());
+    EXPECT_EQ(1, activeLayerCount());
+
+    time += HI_FPS_PERIOD;
+    recordFramesAndExpect(layer, time, HI_FPS, HI_FPS, PRESENT_TIME_HISTORY_SIZE);
+}
+
+TEST_F(LayerHistoryTest, batchedRecordsFromSeveralThreads) {
+    history().setBatchRecords(true);
+
+    constexpr size_t kLayerCount = 8;
+    // Enough frames for the binder threads to flush the queue themselves a few times.
+    constexpr int kFrameCount = 500;
+
+    std::vector<sp<MockLayer>> layers;
+    for (size_t i = 0; i < kLayerCount; i++) {
+        layers.push_back(createLayer("layer" + std::to_string(i)));
+        EXPECT_CALL(*layers.back(), isVisible()).WillRepeatedly(Return(true));
+        EXPECT_CALL(*layers.back(), getFrameRateForLayerTree())
+                .WillRepeatedly(Return(Layer::FrameRate()));
+    }
+
+    const nsecs_t startTime = systemTime();
+    std::vector<std::thread> threads;
+    for (const auto& layer : layers) {
+        threads.emplace_back([&, id = layer->getSequence(), props = layer->getLayerProps()] {
+            nsecs_t time = startTime;
+            for (int frame = 0; frame < kFrameCount; frame++) {
+                history().record(id, props, time, time, LayerHistory::LayerUpdateType::Buffer);
+                time += HI_FPS_PERIOD;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const auto summary = summarizeLayerHistory(startTime + kFrameCount * HI_FPS_PERIOD);
+    ASSERT_EQ(kLayerCount, summary.size());
+    for (const auto& layer : summary) {
+        EXPECT_EQ(LayerHistory::LayerVoteType::Heuristic, layer.vote);
+        EXPECT_EQ(HI_FPS, layer.desiredRefreshRate);
+    }
+}
+
 TEST_F(LayerHistoryTest, smallDirtyLayer) {
     auto layer = createLayer();
 
@@ -38,6 +38,7 @@ using android::mock::createDisplayMode;
 class LayerInfoTest : public testing::Test {
 protected:
     using FrameTimeData = LayerInfo::FrameTimeData;
+    static constexpr size_t HISTORY_SIZE = LayerInfo::HISTORY_SIZE;
 
     static constexpr Fps LO_FPS = 30_Hz;
     static constexpr Fps HI_FPS = 90_Hz;
@@ -45,7 +46,14 @@ protected:
     LayerInfoTest() { mFlinger.resetScheduler(mScheduler); }
 
     void setFrameTimes(const std::deque<FrameTimeData>& frameTimes) {
-        layerInfo.mFrameTimes = frameTimes;
+        layerInfo.clearFrameTimes();
+        addFrameTimes(frameTimes);
+    }
+
+    void addFrameTimes(const std::deque<FrameTimeData>& frameTimes) {
+        for (const auto& frameTime : frameTimes) {
+            layerInfo.addFrameTime(frameTime);
+        }
     }
 
     void setLastRefreshRate(Fps fps) {
@@ -54,6 +62,10 @@ protected:
     }
 
     auto calculateAverageFrameTime() { return layerInfo.calculateAverageFrameTime(); }
+    auto calculateAverageFrameTimeFromHistory() {
+        return layerInfo.calculateAverageFrameTimeFromHistory(/*useQueueTime=*/false);
+    }
+    size_t frameTimeCount() const { return layerInfo.mFrameTimes.size(); }
 
     LayerInfo layerInfo{"TestLayerInfo", 0, LayerHistory::LayerVoteType::Heuristic};
 
@@ -196,6 +208,34 @@ TEST_F(LayerInfoTest, ignoresLargePeriods) {
     ASSERT_EQ(kExpectedFps, Fps::fromPeriodNsecs(*averageFrameTime));
 }
 
+// The average is kept up to date as frames are added and evicted from the history. Make sure it
+// matches the one computed from the history once the history has wrapped around, including after
+// the skipped frames have been evicted.
+TEST_F(LayerInfoTest, runningAverageMatchesHistory) {
+    constexpr auto kPeriod = (60_Hz).getPeriodNsecs();
+    constexpr auto kLargePeriod = (9_Hz).getPeriodNsecs();
+    constexpr auto kSmallPeriod = (250_Hz).getPeriodNsecs();
+    const size_t historySize = HISTORY_SIZE;
+
+    nsecs_t time = kPeriod;
+    for (size_t i = 0; i < 3 * historySize; i++) {
+        // A few large gaps while the history fills up the first time, and a duplicate frame
+        // towards the end of the first lap.
+        if (i < historySize && i % 20 == 0) {
+            time += kLargePeriod;
+        } else if (i == historySize - 10) {
+            time += kSmallPeriod;
+        } else {
+            time += kPeriod + static_cast<nsecs_t>(i % 7) * 10'000;
+        }
+        addFrameTimes({FrameTimeData{.presentTime = time,
+                                     .queueTime = time,
+                                     .pendingModeChange = false}});
+        EXPECT_EQ(calculateAverageFrameTimeFromHistory(), calculateAverageFrameTime()) << i;
+    }
+    EXPECT_EQ(historySize, frameTimeCount());
+}
+
 TEST_F(LayerInfoTest, getRefreshRateVote_explicitVote) {
     LayerInfo::LayerVote vote = {.type = LayerHistory::LayerVoteType::ExplicitDefault,
                                  .fps = 20_Hz};
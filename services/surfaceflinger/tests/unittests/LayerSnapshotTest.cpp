@@ -103,6 +103,59 @@ protected:
         EXPECT_EQ(expectedVisibleLayerIdsInZOrder, actualVisibleLayerIdsInZOrder);
     }
 
+    LayerSnapshotBuilder::Args dirtySubtreeArgs(size_t workerCount) {
+        return LayerSnapshotBuilder::Args{.root = mHierarchyBuilder.getHierarchy(),
+                                          .layerLifecycleManager = mLifecycleManager,
+                                          .includeMetadata = false,
+                                          .displays = mFrontEndDisplayInfos,
+                                          .globalShadowSettings = globalShadowSettings,
+                                          .supportsBlur = true,
+                                          .supportedLayerGenericMetadata = {},
+                                          .genericLayerMetadataKeyMap = {},
+                                          .updateDirtySubtreesOnly = true,
+                                          .subtreeWorkerCount = workerCount};
+    }
+
+    // Updates the builder by only walking dirty subtrees and verifies the snapshots match
+    // snapshots rebuilt from scratch. Records how many hierarchy nodes both updates walked.
+    void updateDirtySubtreesAndVerify(LayerSnapshotBuilder& actualBuilder, size_t workerCount) {
+        LayerSnapshotBuilder::Args args = dirtySubtreeArgs(workerCount);
+        update(actualBuilder, args);
+        mDirtyUpdateVisitedCount = actualBuilder.mVisitedHierarchyCount;
+
+        LayerSnapshotBuilder expectedBuilder(args);
+        mFullUpdateVisitedCount = expectedBuilder.mVisitedHierarchyCount;
+        mLifecycleManager.commitChanges();
+        ASSERT_EQ(expectedBuilder.getSnapshots().size(), actualBuilder.getSnapshots().size());
+        for (const auto& expected : expectedBuilder.getSnapshots()) {
+            SCOPED_TRACE(expected->getDebugString());
+            const LayerSnapshot* actual = actualBuilder.getSnapshot(expected->path);
+            ASSERT_NE(actual, nullptr);
+            EXPECT_EQ(expected->globalZ, actual->globalZ);
+            EXPECT_EQ(expected->isVisible, actual->isVisible);
+            EXPECT_EQ(expected->alpha, actual->alpha);
+            EXPECT_EQ(expected->geomLayerBounds, actual->geomLayerBounds);
+            EXPECT_EQ(expected->geomLayerTransform, actual->geomLayerTransform);
+            EXPECT_EQ(expected->isHiddenByPolicyFromParent, actual->isHiddenByPolicyFromParent);
+            EXPECT_EQ(expected->isHiddenByPolicyFromRelativeParent,
+                      actual->isHiddenByPolicyFromRelativeParent);
+        }
+    }
+
+    // Do a full update so the builder can record the hierarchy for subsequent dirty subtree
+    // updates.
+    void prepareDirtySubtreeUpdates(LayerSnapshotBuilder& builder, size_t workerCount) {
+        LayerSnapshotBuilder::Args args = dirtySubtreeArgs(workerCount);
+        args.forceUpdate = LayerSnapshotBuilder::ForceUpdateFlags::ALL;
+        update(builder, args);
+        mLifecycleManager.commitChanges();
+    }
+
+    // Hierarchy nodes walked by the last updateDirtySubtreesAndVerify, and by the full update it
+    // was compared against.
+    size_t mDirtyUpdateVisitedCount = 0;
+    size_t mFullUpdateVisitedCount = 0;
+
     LayerSnapshot* getSnapshot(uint32_t layerId) { return mSnapshotBuilder.getSnapshot(layerId); }
     LayerSnapshot* getSnapshot(const LayerHierarchy::TraversalPath path) {
         return mSnapshotBuilder.getSnapshot(path);
@@ -1258,4 +1311,138 @@ TEST_F(LayerSnapshotTest, canOccludePresentation) {
     EXPECT_EQ(getSnapshot(1221)->inputInfo.canOccludePresentation, true);
 }
 
+TEST_F(LayerSnapshotTest, dirtySubtreeUpdateMatchesFullUpdate) {
+    prepareDirtySubtreeUpdates(mSnapshotBuilder, /*workerCount=*/0);
+
+    setAlpha(12, 0.5f);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    EXPECT_EQ(getSnapshot(1221)->alpha, 0.5f);
+    EXPECT_EQ(getSnapshot(111)->alpha, 1.f);
+    // Only the path to 12 and its children are walked: 1, 12, 121, 122 and 1221.
+    EXPECT_EQ(mDirtyUpdateVisitedCount, 5u);
+    EXPECT_LT(mDirtyUpdateVisitedCount, mFullUpdateVisitedCount);
+
+    setCrop(1221, Rect(0, 0, 10, 10));
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    EXPECT_EQ(getSnapshot(1221)->geomLayerBounds, FloatRect(0, 0, 10, 10));
+    EXPECT_LT(mDirtyUpdateVisitedCount, mFullUpdateVisitedCount);
+
+    hideLayer(1);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    EXPECT_FALSE(getSnapshot(1221)->isVisible);
+    // Layer 2 is not below the hidden layer, so its subtree is still skipped.
+    EXPECT_LT(mDirtyUpdateVisitedCount, mFullUpdateVisitedCount);
+}
+
+TEST_F(LayerSnapshotTest, dirtySubtreeUpdateWithWorkers) {
+    createRootLayer(3);
+    createLayer(31, 3);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 13, 2, 3, 31});
+    prepareDirtySubtreeUpdates(mSnapshotBuilder, /*workerCount=*/2);
+
+    setAlpha(1, 0.5f);
+    setCrop(2, Rect(0, 0, 20, 20));
+    hideLayer(31);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/2);
+    EXPECT_EQ(getSnapshot(111)->alpha, 0.5f);
+    EXPECT_EQ(getSnapshot(2)->geomLayerBounds, FloatRect(0, 0, 20, 20));
+    EXPECT_FALSE(getSnapshot(31)->isVisible);
+    EXPECT_TRUE(getSnapshot(3)->isVisible);
+
+    setAlpha(31, 0.5f);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/2);
+    EXPECT_EQ(getSnapshot(31)->alpha, 0.5f);
+    // Only the subtree of layer 3 is walked.
+    EXPECT_EQ(mDirtyUpdateVisitedCount, 2u);
+}
+
+TEST_F(LayerSnapshotTest, dirtySubtreeUpdateWithRelativeLayers) {
+    // Relative parenting layer 13 to layer 2 makes both top level subtrees share a snapshot.
+    reparentRelativeLayer(13, 2);
+    UPDATE_AND_VERIFY(mSnapshotBuilder, {1, 11, 111, 12, 121, 122, 1221, 2, 13});
+    prepareDirtySubtreeUpdates(mSnapshotBuilder, /*workerCount=*/2);
+
+    hideLayer(2);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/2);
+    EXPECT_FALSE(getSnapshot(13)->isVisible);
+
+    showLayer(2);
+    setAlpha(13, 0.5f);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/2);
+    EXPECT_TRUE(getSnapshot(13)->isVisible);
+    EXPECT_EQ(getSnapshot(13)->alpha, 0.5f);
+}
+
+TEST_F(LayerSnapshotTest, dirtySubtreeUpdateFallsBackOnHierarchyChanges) {
+    prepareDirtySubtreeUpdates(mSnapshotBuilder, /*workerCount=*/0);
+
+    reparentLayer(122, 11);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    // A hierarchy change falls back to walking the whole hierarchy.
+    EXPECT_EQ(mDirtyUpdateVisitedCount, mFullUpdateVisitedCount);
+
+    createLayer(14, 1);
+    setAlpha(14, 0.5f);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    EXPECT_EQ(getSnapshot(14)->alpha, 0.5f);
+
+    setAlpha(122, 0.5f);
+    updateDirtySubtreesAndVerify(mSnapshotBuilder, /*workerCount=*/0);
+    EXPECT_EQ(getSnapshot(1221)->alpha, 0.5f);
+}
+
+TEST_F(LayerSnapshotTest, packedSnapshotsMatchSnapshots) {
+    setAlpha(12, 0.5f);
+    setCrop(2, Rect(0, 0, 20, 20));
+    hideLayer(13);
+    LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                    .layerLifecycleManager = mLifecycleManager,
+                                    .includeMetadata = false,
+                                    .displays = mFrontEndDisplayInfos,
+                                    .globalShadowSettings = globalShadowSettings,
+                                    .supportsBlur = true,
+                                    .supportedLayerGenericMetadata = {},
+                                    .genericLayerMetadataKeyMap = {},
+                                    .buildPackedSnapshots = true};
+    update(mSnapshotBuilder, args);
+    mLifecycleManager.commitChanges();
+
+    const PackedLayerSnapshots& packed = mSnapshotBuilder.getPackedSnapshots();
+    ASSERT_FALSE(packed.empty());
+    for (size_t i = 0; i < packed.size(); i++) {
+        const LayerSnapshot& snapshot = *packed.getSnapshot(i);
+        SCOPED_TRACE(snapshot.getDebugString());
+        EXPECT_EQ(snapshot.globalZ, i);
+        EXPECT_EQ(packed.getLayerIds()[i], snapshot.path.id);
+        EXPECT_EQ(packed.getOutputFilters()[i].layerStack, snapshot.outputFilter.layerStack);
+        EXPECT_EQ(packed.getOutputFilters()[i].toInternalDisplay,
+                  snapshot.outputFilter.toInternalDisplay);
+        EXPECT_EQ(packed.getVisibleBounds()[i], snapshot.transformedBoundsWithoutTransparentRegion);
+        EXPECT_EQ(packed.test(i, PackedLayerSnapshots::Visible), snapshot.isVisible);
+        EXPECT_EQ(packed.test(i, PackedLayerSnapshots::HasInputInfo), snapshot.hasInputInfo());
+    }
+
+    std::vector<uint32_t> visibleLayerIds;
+    mSnapshotBuilder.forEachVisibleSnapshot(
+            [&](const LayerSnapshot& snapshot) { visibleLayerIds.push_back(snapshot.path.id); });
+    EXPECT_EQ(visibleLayerIds, (std::vector<uint32_t>{1, 11, 111, 12, 121, 122, 1221, 2}));
+
+    std::vector<uint32_t> visibleBoundsLayerIds;
+    mSnapshotBuilder.forEachVisibleBounds(
+            [&](uint32_t layerId, const ui::LayerFilter& outputFilter, const Rect& visibleBounds) {
+                const LayerSnapshot& snapshot = *mSnapshotBuilder.getSnapshot(layerId);
+                EXPECT_EQ(outputFilter.layerStack, snapshot.outputFilter.layerStack);
+                EXPECT_EQ(visibleBounds, snapshot.transformedBoundsWithoutTransparentRegion);
+                visibleBoundsLayerIds.push_back(layerId);
+            });
+    EXPECT_EQ(visibleBoundsLayerIds, visibleLayerIds);
+
+    // Disabling the packed snapshots clears them.
+    args.buildPackedSnapshots = false;
+    setAlpha(12, 1.f);
+    update(mSnapshotBuilder, args);
+    mLifecycleManager.commitChanges();
+    EXPECT_TRUE(mSnapshotBuilder.getPackedSnapshots().empty());
+}
+
 } // namespace android::surfaceflinger::frontend
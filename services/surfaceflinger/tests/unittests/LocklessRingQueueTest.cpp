@@ -0,0 +1,205 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "LocklessRingQueue.h"
+
+namespace android {
+
+class LocklessRingQueueTest : public testing::Test {};
+
+namespace {
+
+TEST_F(LocklessRingQueueTest, startsEmpty) {
+    LocklessRingQueue<int, 4> queue;
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST_F(LocklessRingQueueTest, popsInPushOrder) {
+    LocklessRingQueue<int, 4> queue;
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    EXPECT_FALSE(queue.isEmpty());
+    EXPECT_EQ(1, queue.pop());
+    EXPECT_EQ(2, queue.pop());
+    EXPECT_EQ(3, queue.pop());
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_EQ(0u, queue.getOverflowCount());
+}
+
+TEST_F(LocklessRingQueueTest, wrapsAroundWithoutOverflowing) {
+    LocklessRingQueue<int, 4> queue;
+    for (int i = 0; i < 100; i++) {
+        queue.push(i);
+        queue.push(i + 1000);
+        EXPECT_EQ(i, queue.pop());
+        EXPECT_EQ(i + 1000, queue.pop());
+    }
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(0u, queue.getOverflowCount());
+}
+
+TEST_F(LocklessRingQueueTest, overflowKeepsOrder) {
+    LocklessRingQueue<int, 4> queue;
+    for (int i = 0; i < 10; i++) {
+        queue.push(i);
+    }
+    EXPECT_EQ(6u, queue.getOverflowCount());
+
+    // Free a few slots so later pushes land in the ring again, behind the overflowed values.
+    EXPECT_EQ(0, queue.pop());
+    EXPECT_EQ(1, queue.pop());
+    for (int i = 10; i < 14; i++) {
+        queue.push(i);
+    }
+
+    for (int i = 2; i < 14; i++) {
+        EXPECT_EQ(i, queue.pop());
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST_F(LocklessRingQueueTest, supportsMoveOnlyValues) {
+    LocklessRingQueue<std::unique_ptr<int>, 2> queue;
+    for (int i = 0; i < 4; i++) {
+        queue.push(std::make_unique<int>(i));
+    }
+    for (int i = 0; i < 4; i++) {
+        auto value = queue.pop();
+        ASSERT_TRUE(value.has_value());
+        EXPECT_EQ(i, **value);
+    }
+}
+
+// A value whose first move blocks until released, standing in for a producer that is preempted
+// between claiming its ticket and publishing its value.
+struct StallingValue {
+    int id;
+    std::promise<void>* moving = nullptr;
+    std::shared_future<void> release;
+
+    StallingValue(int id, std::promise<void>* moving, std::shared_future<void> release)
+          : id(id), moving(moving), release(std::move(release)) {}
+    StallingValue(StallingValue&& other) : id(other.id) {
+        if (other.moving) {
+            other.moving->set_value();
+            other.moving = nullptr;
+            other.release.wait();
+        }
+    }
+    StallingValue& operator=(StallingValue&& other) {
+        id = other.id;
+        return *this;
+    }
+};
+
+TEST_F(LocklessRingQueueTest, stalledProducerDoesNotHoldBackLaterValues) {
+    LocklessRingQueue<StallingValue, 4> queue;
+    std::promise<void> moving;
+    std::promise<void> release;
+    std::thread stalledProducer([&]() {
+        queue.push(StallingValue(0, &moving, release.get_future().share()));
+    });
+    moving.get_future().wait();
+
+    // The stalled value has claimed the first ticket, but the values behind it are returned.
+    queue.push(StallingValue(1, nullptr, {}));
+    queue.push(StallingValue(2, nullptr, {}));
+    auto value = queue.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(1, value->id);
+    value = queue.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(2, value->id);
+    EXPECT_FALSE(queue.pop().has_value());
+    EXPECT_FALSE(queue.isEmpty());
+
+    release.set_value();
+    stalledProducer.join();
+    value = queue.pop();
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(0, value->id);
+    EXPECT_TRUE(queue.isEmpty());
+
+    // The stalled value's slot is reused once it has been popped.
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 4; i++) {
+            queue.push(StallingValue(i, nullptr, {}));
+        }
+        for (int i = 0; i < 4; i++) {
+            value = queue.pop();
+            ASSERT_TRUE(value.has_value());
+            EXPECT_EQ(i, value->id);
+        }
+    }
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_EQ(0u, queue.getOverflowCount());
+}
+
+TEST_F(LocklessRingQueueTest, multipleProducers) {
+    constexpr int kProducerCount = 4;
+    constexpr int kValuesPerProducer = 10000;
+    // Small enough that the producers regularly overflow the ring.
+    LocklessRingQueue<std::pair<int, int>, 16> queue;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducerCount; producer++) {
+        producers.emplace_back([&queue, producer]() {
+            for (int i = 0; i < kValuesPerProducer; i++) {
+                queue.push({producer, i});
+            }
+        });
+    }
+
+    // Consume concurrently with the producers, but only check the values once they are joined
+    // so a failed assertion cannot leave the threads running.
+    std::vector<std::pair<int, int>> values;
+    constexpr size_t kValueCount = kProducerCount * kValuesPerProducer;
+    values.reserve(kValueCount);
+    while (values.size() < kValueCount) {
+        auto value = queue.pop();
+        if (!value) {
+            std::this_thread::yield();
+            continue;
+        }
+        values.push_back(*value);
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    // Values from the same producer must come out in the order they were pushed.
+    std::vector<int> nextValue(kProducerCount, 0);
+    for (const auto& [producer, value] : values) {
+        ASSERT_EQ(nextValue[producer], value);
+        nextValue[producer]++;
+    }
+    EXPECT_TRUE(queue.isEmpty());
+}
+
+} // namespace
+
+} // namespace android
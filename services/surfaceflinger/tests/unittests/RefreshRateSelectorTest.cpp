@@ -100,7 +100,10 @@ struct TestableRefreshRateSelector : RefreshRateSelector {
     const std::vector<Fps>& knownFrameRates() const { return mKnownFrameRates; }
 
     using RefreshRateSelector::GetRankedFrameRatesCache;
+    using RefreshRateSelector::kGetRankedFrameRatesCacheSize;
     auto& mutableGetRankedRefreshRatesCache() { return mGetRankedFrameRatesCache; }
+    auto getRankedFrameRatesCacheHits() const { return mGetRankedFrameRatesCacheHits; }
+    auto getRankedFrameRatesCacheMisses() const { return mGetRankedFrameRatesCacheMisses; }
 
     auto getRankedFrameRates(const std::vector<LayerRequirement>& layers,
                              GlobalSignals signals = {}) const {
@@ -2729,7 +2732,7 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ReadsCache) {
                                                                   {90_Hz, kMode90}}},
                                                           GlobalSignals{.touch = true}};
 
-    selector.mutableGetRankedRefreshRatesCache() = {args, result};
+    selector.mutableGetRankedRefreshRatesCache() = {{args, result}};
 
     EXPECT_EQ(result, selector.getRankedFrameRates(args.first, args.second));
 }
@@ -2737,7 +2740,7 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ReadsCache) {
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
 
-    EXPECT_FALSE(selector.mutableGetRankedRefreshRatesCache());
+    EXPECT_TRUE(selector.mutableGetRankedRefreshRatesCache().empty());
 
     std::vector<LayerRequirement> layers = {{.weight = 1.f}, {.weight = 0.5f}};
     RefreshRateSelector::GlobalSignals globalSignals{.touch = true, .idle = true};
@@ -2745,10 +2748,69 @@ TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_WritesCache) {
     const auto result = selector.getRankedFrameRates(layers, globalSignals);
 
     const auto& cache = selector.mutableGetRankedRefreshRatesCache();
-    ASSERT_TRUE(cache);
+    ASSERT_EQ(1u, cache.size());
 
-    EXPECT_EQ(cache->arguments, std::make_pair(layers, globalSignals));
-    EXPECT_EQ(cache->result, result);
+    EXPECT_EQ(cache.front().arguments, std::make_pair(layers, globalSignals));
+    EXPECT_EQ(cache.front().result, result);
+}
+
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_CachesRecentInvocations) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    std::vector<LayerRequirement> videoLayers = {{.vote = LayerVoteType::ExplicitDefault,
+                                                  .desiredRefreshRate = 30_Hz,
+                                                  .weight = 1.f}};
+    std::vector<LayerRequirement> gameLayers = {{.vote = LayerVoteType::ExplicitDefault,
+                                                 .desiredRefreshRate = 90_Hz,
+                                                 .weight = 1.f}};
+
+    const auto videoResult = selector.getRankedFrameRates(videoLayers);
+    const auto gameResult = selector.getRankedFrameRates(gameLayers);
+    EXPECT_EQ(0u, selector.getRankedFrameRatesCacheHits());
+    EXPECT_EQ(2u, selector.getRankedFrameRatesCacheMisses());
+
+    // Alternating between the two summaries keeps hitting the cache.
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(videoResult, selector.getRankedFrameRates(videoLayers));
+        EXPECT_EQ(gameResult, selector.getRankedFrameRates(gameLayers));
+    }
+    EXPECT_EQ(6u, selector.getRankedFrameRatesCacheHits());
+    EXPECT_EQ(2u, selector.getRankedFrameRatesCacheMisses());
+
+    // Layers that differ only in their name are not the same invocation.
+    gameLayers[0].name = "game";
+    selector.getRankedFrameRates(gameLayers);
+    EXPECT_EQ(3u, selector.getRankedFrameRatesCacheMisses());
+
+    // Changing the policy invalidates the cache.
+    EXPECT_EQ(SetPolicyResult::Changed,
+              selector.setDisplayManagerPolicy({kModeId60, {0_Hz, 60_Hz}}));
+    EXPECT_TRUE(selector.mutableGetRankedRefreshRatesCache().empty());
+}
+
+TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_CacheEvictsLeastRecentlyUsed) {
+    auto selector = createSelector(kModes_30_60_72_90_120, kModeId60);
+
+    constexpr size_t kCacheSize = TestableRefreshRateSelector::kGetRankedFrameRatesCacheSize;
+    std::vector<std::vector<LayerRequirement>> summaries;
+    for (size_t i = 0; i <= kCacheSize; i++) {
+        summaries.push_back({{.name = "layer" + std::to_string(i), .weight = 1.f}});
+    }
+
+    for (size_t i = 0; i < kCacheSize; i++) {
+        selector.getRankedFrameRates(summaries[i]);
+    }
+    // Use the oldest entry again so that the second oldest is evicted next.
+    selector.getRankedFrameRates(summaries[0]);
+    selector.getRankedFrameRates(summaries[kCacheSize]);
+
+    const auto& cache = selector.mutableGetRankedRefreshRatesCache();
+    ASSERT_EQ(kCacheSize, cache.size());
+    EXPECT_EQ(summaries[kCacheSize], cache[0].arguments.first);
+    EXPECT_EQ(summaries[0], cache[1].arguments.first);
+    for (const auto& entry : cache) {
+        EXPECT_NE(summaries[1], entry.arguments.first);
+    }
 }
 
 TEST_P(RefreshRateSelectorTest, getBestFrameRateMode_ExplicitExactTouchBoost) {
@@ -410,8 +410,11 @@ public:
         return transaction;
     }
 
+    // |acquireFenceSignaled| marks every acquire fence as already seen signaled, as the
+    // transaction readiness precompute does.
     void setTransactionStates(const std::vector<TransactionInfo>& transactions,
-                              size_t expectedTransactionsPending) {
+                              size_t expectedTransactionsPending,
+                              bool acquireFenceSignaled = false) {
         EXPECT_TRUE(mFlinger.getTransactionQueue().isEmpty());
         EXPECT_EQ(0u, mFlinger.getPendingTransactionQueue().size());
 
@@ -423,6 +426,7 @@ public:
                 resolvedState.state = std::move(state.state);
                 resolvedState.externalTexture =
                         std::make_shared<FakeExternalTexture>(*resolvedState.state.bufferData);
+                resolvedState.acquireFenceSignaled = acquireFenceSignaled;
                 resolvedStates.emplace_back(resolvedState);
             }
 
@@ -757,6 +761,24 @@ TEST_F(LatchUnsignaledDisabledTest, Flush_KeepsInTheQueue) {
     setTransactionStates({unsignaledTransaction}, kExpectedTransactionsPending);
 }
 
+TEST_F(LatchUnsignaledDisabledTest, Flush_RemovesPrecomputedSignaledFromTheQueue) {
+    const sp<IBinder> kApplyToken =
+            IInterface::asBinder(TransactionCompletedListener::getIInstance());
+    const auto kLayerId = 1;
+    const auto kExpectedTransactionsPending = 0u;
+
+    // The fence reports unsignaled, but the buffer check must trust the precomputed result.
+    const auto precomputedTransaction =
+            createTransactionInfo(kApplyToken,
+                                  {
+                                          createComposerState(kLayerId,
+                                                              fence(Fence::Status::Unsignaled),
+                                                              layer_state_t::eBufferChanged),
+                                  });
+    setTransactionStates({precomputedTransaction}, kExpectedTransactionsPending,
+                         /*acquireFenceSignaled=*/true);
+}
+
 TEST_F(LatchUnsignaledDisabledTest, Flush_KeepsInTheQueueSameLayerId) {
     const sp<IBinder> kApplyToken =
             IInterface::asBinder(TransactionCompletedListener::getIInstance());
@@ -909,6 +931,49 @@ TEST(TransactionHandlerTest, QueueTransaction) {
     EXPECT_EQ(transactionsReadyToBeApplied.front().id, 42u);
 }
 
+TEST(TransactionHandlerTest, PrecomputesSignaledAcquireFences) {
+    TransactionHandler handler;
+    handler.enableReadinessPrecompute();
+    // Only lets through transactions whose fences were found signaled before the filters ran.
+    handler.addTransactionReadyFilter([](const TransactionHandler::TransactionFlushState& state) {
+        return state.transaction->states.front().acquireFenceSignaled
+                ? TransactionHandler::TransactionReadiness::Ready
+                : TransactionHandler::TransactionReadiness::NotReady;
+    });
+
+    auto queueTransaction = [&](uint64_t id, Fence::Status status) {
+        const auto fence = sp<mock::MockFence>::make();
+        EXPECT_CALL(*fence, getStatus()).WillRepeatedly(Return(status));
+        ResolvedComposerState state;
+        state.state.what = layer_state_t::eBufferChanged;
+        state.state.bufferData =
+                std::make_shared<fake::BufferData>(/* bufferId */ id, /* width */ 1,
+                                                   /* height */ 2, /* pixelFormat */ 0,
+                                                   /* outUsage */ 0);
+        state.state.bufferData->acquireFence = fence;
+        state.state.bufferData->flags = BufferData::BufferDataChange::fenceChanged;
+
+        TransactionState transaction;
+        transaction.applyToken = sp<BBinder>::make();
+        transaction.id = id;
+        transaction.states.emplace_back(std::move(state));
+        handler.queueTransaction(std::move(transaction));
+    };
+
+    queueTransaction(1, Fence::Status::Signaled);
+    queueTransaction(2, Fence::Status::Signaled);
+    queueTransaction(3, Fence::Status::Signaled);
+    queueTransaction(4, Fence::Status::Unsignaled);
+    handler.collectTransactions();
+    std::vector<TransactionState> transactions = handler.flushTransactions();
+
+    ASSERT_EQ(3u, transactions.size());
+    for (const auto& transaction : transactions) {
+        EXPECT_NE(4u, transaction.id);
+    }
+    EXPECT_TRUE(handler.hasPendingTransactions());
+}
+
 TEST(TransactionHandlerTest, TransactionsKeepTrackOfDirectMerges) {
     SurfaceComposerClient::Transaction transaction1, transaction2, transaction3, transaction4;
 
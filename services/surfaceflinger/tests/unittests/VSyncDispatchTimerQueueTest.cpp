@@ -444,6 +444,68 @@ TEST_F(VSyncDispatchTimerQueueTest, basicTwoAlarmSetting) {
     EXPECT_THAT(cb1.mCalls[0], Eq(1063));
 }
 
+TEST_F(VSyncDispatchTimerQueueTest, idleCallbacksDoNotAffectDispatch) {
+    Sequence seq;
+    EXPECT_CALL(mMockClock, alarmAt(_, 900)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 750)).InSequence(seq);
+    EXPECT_CALL(mMockClock, alarmAt(_, 900)).InSequence(seq);
+
+    std::vector<std::unique_ptr<CountingCallback>> callbacks;
+    for (int i = 0; i < 20; i++) {
+        callbacks.push_back(std::make_unique<CountingCallback>(mDispatch));
+    }
+    auto& cb0 = *callbacks[3];
+    auto& cb1 = *callbacks[15];
+
+    mDispatch->schedule(cb0, {.workDuration = 100, .readyDuration = 0, .lastVsync = mPeriod});
+    mDispatch->schedule(cb1, {.workDuration = 250, .readyDuration = 0, .lastVsync = mPeriod});
+
+    advanceToNextCallback();
+    ASSERT_THAT(cb1.mCalls.size(), Eq(1));
+    EXPECT_THAT(cb1.mCalls[0], Eq(mPeriod));
+    EXPECT_THAT(cb0.mCalls.size(), Eq(0));
+
+    advanceToNextCallback();
+    ASSERT_THAT(cb0.mCalls.size(), Eq(1));
+    EXPECT_THAT(cb0.mCalls[0], Eq(mPeriod));
+
+    for (const auto& callback : callbacks) {
+        if (callback.get() != &cb0 && callback.get() != &cb1) {
+            EXPECT_THAT(callback->mCalls.size(), Eq(0));
+        }
+        EXPECT_EQ(mDispatch->cancel(*callback), CancelResult::TooLate);
+    }
+}
+
+// Callbacks that are due in the same wakeup are invoked in token order, i.e. the order they were
+// registered in, regardless of the order they were scheduled in or of earlier unregistrations.
+TEST_F(VSyncDispatchTimerQueueTest, dispatchesGroupedCallbacksInTokenOrder) {
+    EXPECT_CALL(mMockClock, alarmAt(_, 600));
+
+    std::vector<int> order;
+    std::vector<VSyncDispatch::CallbackToken> tokens;
+    auto registerCallback = [&](int index) {
+        auto callback = [&order, index](nsecs_t, nsecs_t, nsecs_t) { order.push_back(index); };
+        tokens.push_back(mDispatch->registerCallback(std::move(callback), "test"));
+    };
+    for (int i = 0; i < 4; i++) {
+        registerCallback(i);
+    }
+    mDispatch->unregisterCallback(tokens[1]);
+    registerCallback(4);
+
+    for (int i : {4, 3, 2, 0}) {
+        mDispatch->schedule(tokens[i],
+                            {.workDuration = 400, .readyDuration = 0, .lastVsync = mPeriod});
+    }
+    advanceToNextCallback();
+    EXPECT_THAT(order, ElementsAre(0, 2, 3, 4));
+
+    for (int i : {0, 2, 3, 4}) {
+        mDispatch->unregisterCallback(tokens[i]);
+    }
+}
+
 TEST_F(VSyncDispatchTimerQueueTest, noCloseCallbacksAfterPeriodChange) {
     EXPECT_CALL(*mStubTracker.get(), nextAnticipatedVSyncTimeFrom(_, _))
             .Times(4)
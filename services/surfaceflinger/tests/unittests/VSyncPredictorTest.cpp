@@ -586,6 +586,71 @@ TEST_F(VSyncPredictorTest, robustToDuplicateTimestamps_60hzRealTraceData) {
     EXPECT_THAT(intercept, IsCloseTo(expectedIntercept, mMaxRoundingError));
 }
 
+TEST_F(VSyncPredictorTest, incrementalFitMatchesBatchFit_60hzRealTraceData) {
+    std::vector<nsecs_t> const simulatedVsyncs{
+            198353408177, 198370074844, 198371400000, 198374274000, 198390941000, 198407565000,
+            198540887994, 198607538588, 198624218276, 198657655939, 198674224176, 198690880955,
+            198724204319, 198740988133, 198758166681, 198790869196, 198824205052, 198840871678,
+            198857715631, 198890885797, 198924199640, 198940873834, 198974204401,
+    };
+    auto constexpr idealPeriod = 16'666'666;
+    auto constexpr expectedPeriod = 16'644'742;
+    auto constexpr expectedIntercept = 125'626;
+
+    VSyncPredictor incrementalTracker{mMode, kHistorySize, kMinimumSamplesForPrediction,
+                                      kOutlierTolerancePercent,
+                                      VSyncPredictor::FitMode::Incremental};
+    tracker.setDisplayModePtr(displayMode(idealPeriod));
+    incrementalTracker.setDisplayModePtr(displayMode(idealPeriod));
+    for (auto const& timestamp : simulatedVsyncs) {
+        // Both fits must accept and reject the same samples.
+        EXPECT_EQ(tracker.addVsyncTimestamp(timestamp),
+                  incrementalTracker.addVsyncTimestamp(timestamp));
+    }
+    auto [slope, intercept] = incrementalTracker.getVSyncPredictionModel();
+    EXPECT_THAT(slope, IsCloseTo(expectedPeriod, mMaxRoundingError));
+    EXPECT_THAT(intercept, IsCloseTo(expectedIntercept, mMaxRoundingError));
+}
+
+TEST_F(VSyncPredictorTest, incrementalFitTracksLongSequences) {
+    auto constexpr idealPeriod = 16'666'666;
+    VSyncPredictor incrementalTracker{mMode, kHistorySize, kMinimumSamplesForPrediction,
+                                      kOutlierTolerancePercent,
+                                      VSyncPredictor::FitMode::Incremental};
+    tracker.setDisplayModePtr(displayMode(idealPeriod));
+    incrementalTracker.setDisplayModePtr(displayMode(idealPeriod));
+
+    // Enough samples to wrap the history many times, with up to +/- 100us of jitter.
+    for (nsecs_t i = 0; i < 200; i++) {
+        const nsecs_t jitter = ((i * 7919) % 2001 - 1000) * 100;
+        const nsecs_t timestamp = 1'000'000 + i * idealPeriod + jitter;
+        tracker.addVsyncTimestamp(timestamp);
+        incrementalTracker.addVsyncTimestamp(timestamp);
+
+        auto [slope, intercept] = tracker.getVSyncPredictionModel();
+        auto [incrementalSlope, incrementalIntercept] =
+                incrementalTracker.getVSyncPredictionModel();
+        EXPECT_THAT(incrementalSlope, IsCloseTo(slope, mMaxRoundingError));
+        EXPECT_THAT(incrementalIntercept, IsCloseTo(intercept, mMaxRoundingError));
+    }
+}
+
+TEST_F(VSyncPredictorTest, incrementalFitFallsBackOnOutOfOrderTimestamps) {
+    VSyncPredictor incrementalTracker{mMode, kHistorySize, kMinimumSamplesForPrediction,
+                                      kOutlierTolerancePercent,
+                                      VSyncPredictor::FitMode::Incremental};
+    std::vector<nsecs_t> const simulatedVsyncs{1000, 2000, 3000, 4000, 5000, 6000, 7000, 500};
+    for (auto const& timestamp : simulatedVsyncs) {
+        tracker.addVsyncTimestamp(timestamp);
+        incrementalTracker.addVsyncTimestamp(timestamp);
+    }
+
+    auto [slope, intercept] = tracker.getVSyncPredictionModel();
+    auto [incrementalSlope, incrementalIntercept] = incrementalTracker.getVSyncPredictionModel();
+    EXPECT_EQ(slope, incrementalSlope);
+    EXPECT_EQ(intercept, incrementalIntercept);
+}
+
 TEST_F(VSyncPredictorTest, setRenderRateIsRespected) {
     auto last = mNow;
     for (auto i = 0u; i < kMinimumSamplesForPrediction; i++) {